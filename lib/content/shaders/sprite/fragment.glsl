@@ -2,12 +2,54 @@
 
 in vec2 fragTextureCoords;
 in vec4 fragColor;
+flat in int fragTextureUnit;
+flat in float fragTextureLayer;
 
 out vec4 outColor;
 
-uniform sampler2D tex0;
+// Texture units 0-11 are used for 2D textures and 12-15 for texture arrays.
+// Samplers can't be indexed dynamically in GLSL 3.30, that's why every unit is
+// selected explicitly.
+uniform sampler2D textures[12];
+uniform sampler2DArray textureArrays[4];
+// Set for distance field fonts, see createDistanceFieldBatch.
+uniform int distanceField;
+
+vec4 sampleTexture()
+{
+    vec3 coords = vec3(fragTextureCoords, fragTextureLayer);
+    switch (fragTextureUnit) {
+        case 0: return texture(textures[0], fragTextureCoords);
+        case 1: return texture(textures[1], fragTextureCoords);
+        case 2: return texture(textures[2], fragTextureCoords);
+        case 3: return texture(textures[3], fragTextureCoords);
+        case 4: return texture(textures[4], fragTextureCoords);
+        case 5: return texture(textures[5], fragTextureCoords);
+        case 6: return texture(textures[6], fragTextureCoords);
+        case 7: return texture(textures[7], fragTextureCoords);
+        case 8: return texture(textures[8], fragTextureCoords);
+        case 9: return texture(textures[9], fragTextureCoords);
+        case 10: return texture(textures[10], fragTextureCoords);
+        case 11: return texture(textures[11], fragTextureCoords);
+        case 12: return texture(textureArrays[0], coords);
+        case 13: return texture(textureArrays[1], coords);
+        case 14: return texture(textureArrays[2], coords);
+        case 15: return texture(textureArrays[3], coords);
+    }
+    return vec4(1);
+}
 
 void main()
 {
-    outColor = texture(tex0, fragTextureCoords) * fragColor;
+    if (distanceField == 0) {
+        outColor = sampleTexture() * fragColor;
+        return;
+    }
+    // The alpha channel stores the distance to the glyph edge, 0.5 is on the
+    // edge. The width of the edge is kept at about one pixel on screen
+    // regardless of how much the text is scaled.
+    float distance = sampleTexture().a;
+    float width = fwidth(distance);
+    float alpha = smoothstep(0.5 - width, 0.5 + width, distance);
+    outColor = vec4(fragColor.rgb, fragColor.a * alpha);
 }
\ No newline at end of file
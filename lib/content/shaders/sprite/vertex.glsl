@@ -3,14 +3,19 @@
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec2 textureCoords;
 layout (location = 2) in vec4 color;
+layout (location = 3) in vec2 textureUnitLayer;
 
 out vec2 fragTextureCoords;
 out vec4 fragColor;
+flat out int fragTextureUnit;
+flat out float fragTextureLayer;
 
 uniform mat4 viewProjection;
 
 void main() {
     fragTextureCoords = textureCoords;
     fragColor = color;
+    fragTextureUnit = int(textureUnitLayer.x);
+    fragTextureLayer = textureUnitLayer.y;
     gl_Position = viewProjection * vec4(position, 1);
-}
\ No newline at end of file
+}
@@ -61,17 +61,25 @@ class Model {
             this.shader.setMaterial(mesh.material);
             this.shader.setWorld(mesh.transform.getWorldMatrix(matrix.next));
             graphics.setVertexSpecification(mesh.vertexSpecification);
-            graphics.drawIndexedPrimitives({
-                primitiveType: 'triangleList',
-                primitiveCount: mesh.geometry.indicies.length / 3
-            });
+            graphics.drawIndexedPrimitives(0 /* triangleList */, 0, mesh.geometry.indicies.length / 3);
         }
     }
     /**
      * Loads a model from file with the given shader.
      */
     static load(filepath, shader) {
-        let data = JSON.parse(file.readText(filepath));
+        return Model.create(filepath, JSON.parse(file.readText(filepath)), shader);
+    }
+    /**
+     * Loads a model from file with the given shader, the file is read in the
+     * background.
+     */
+    static loadAsync(filepath, shader) {
+        return file.readJsonAsync(filepath).then((data) => {
+            return Model.create(filepath, data, shader);
+        });
+    }
+    static create(filepath, data, shader) {
         let initial = AssimpReader.readTransformation(data.rootnode.transformation);
         let transform = new transform_1.Transform(initial);
         let reader = new AssimpReader(filepath.replace(/[^\/]*$/, ''), data, shader);
@@ -199,7 +207,7 @@ class AssimpReader {
                 }
                 case "$tex.file": {
                     if (!this.textures[value]) {
-                        this.textures[value] = new Texture2D(this.path + value);
+                        this.textures[value] = assets.texture(this.path + value);
                     }
                     switch (material.properties[i].semantic) {
                         case 1: {
@@ -89,17 +89,28 @@ export class Model {
             this.shader.setMaterial(mesh.material);
             this.shader.setWorld(mesh.transform.getWorldMatrix(matrix.next));
             graphics.setVertexSpecification(mesh.vertexSpecification);
-            graphics.drawIndexedPrimitives({
-                primitiveType: 'triangleList',
-                primitiveCount: mesh.geometry.indicies.length / 3
-            });
+            graphics.drawIndexedPrimitives(PrimitiveTypes.triangleList, 0,
+                mesh.geometry.indicies.length / 3);
         }
     }
     /**
      * Loads a model from file with the given shader.
      */
     static load(filepath: string, shader: Shader) {
-        let data = <AssimpData>JSON.parse(file.readText(filepath));
+        return Model.create(filepath,
+            <AssimpData>JSON.parse(file.readText(filepath)), shader);
+    }
+    /**
+     * Loads a model from file with the given shader, the file is read in the
+     * background.
+     */
+    static loadAsync(filepath: string, shader: Shader) {
+        return file.readJsonAsync(filepath).then((data: AssimpData) => {
+            return Model.create(filepath, data, shader);
+        });
+    }
+    private static create(filepath: string, data: AssimpData,
+        shader: Shader) {
         let initial = AssimpReader.readTransformation(
             data.rootnode.transformation);
         let transform = new Transform(initial);
@@ -240,7 +251,8 @@ class AssimpReader {
                 }
                 case "$tex.file": {
                     if (!this.textures[value]) {
-                        this.textures[value] = new Texture2D(this.path + value);
+                        this.textures[value] =
+                            assets.texture(this.path + value);
                     }
                     switch (material.properties[i].semantic) {
                         case 1: {
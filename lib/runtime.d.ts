@@ -51,6 +51,192 @@ declare const file: {
      * Reads the text from a file with given file name.
      */
     readText(filepath: string): string;
+    /**
+     * Reads the contents of a file with given file name.
+     */
+    readBytes(filepath: string): ArrayBuffer;
+    /**
+     * Maps a file into memory instead of reading it up front. Changes to the
+     * array buffer are never written back to the file. The file is unmapped
+     * when the array buffer is garbage collected, or by calling unmap.
+     */
+    mapBytes(filepath: string): ArrayBuffer;
+    /**
+     * Unmaps an array buffer returned by mapBytes, it's empty afterwards.
+     */
+    unmap(buffer: ArrayBuffer): void;
+    /**
+     * Reads the text from a file in the background. The promise is resolved
+     * when polling the window events.
+     */
+    readTextAsync(filepath: string): Promise<string>;
+    /**
+     * Reads the contents of a file in the background.
+     */
+    readBytesAsync(filepath: string): Promise<ArrayBuffer>;
+    /**
+     * Reads and parses a JSON file in the background.
+     */
+    readJsonAsync(filepath: string): Promise<any>;
+}
+
+declare const memory: {
+    /**
+     * Returns the statistics of the array buffer allocator. Small buffers
+     * are allocated from slabs, large buffers are reused from an arena.
+     */
+    arrayBufferStatistics(): {
+        allocations: number;
+        frees: number;
+        bytesInUse: number;
+        peakBytesInUse: number;
+        slabBytes: number;
+        arenaHits: number;
+        arenaMisses: number;
+        arenaBytes: number;
+    };
+}
+
+declare const profiler: {
+    /**
+     * Returns the times between presented frames in milliseconds. The
+     * histogram has a bucket for each millisecond, the last bucket also
+     * counts slower frames. The idle time is the total time that garbage
+     * collection was given after presenting frames.
+     */
+    frameStatistics(): {
+        frames: number;
+        mean: number;
+        p50: number;
+        p95: number;
+        p99: number;
+        max: number;
+        histogram: number[];
+        idleTime: number;
+    };
+    /**
+     * Returns the garbage collection times in milliseconds, in total, in the
+     * idle time after frames, per frame and per type of collection. The
+     * recent collections are listed oldest first.
+     */
+    gcStatistics(): {
+        time: number;
+        idleTime: number;
+        lastFrameTime: number;
+        perFrame: { mean: number; p95: number; max: number; };
+        collections: {
+            [type: string]: { count: number; time: number; maxPause: number; }
+        };
+        recent: {
+            type: string;
+            start: number;
+            duration: number;
+            heapBefore: number;
+            heapAfter: number;
+            idle: boolean;
+            frame: number;
+        }[];
+    };
+}
+
+/**
+ * Shares assets loaded from the same files with the same options. Each load
+ * adds a reference to the asset, it's disposed when all references have been
+ * released. Assets are loaded again after their files have changed.
+ */
+declare const assets: {
+    texture(filepath: string): Texture2D;
+    sound(filepath: string): SoundBuffer;
+    font(options: {
+        filename: string; size?: number; chars?: string;
+        distanceField?: boolean; pageSize?: number; maxPages?: number;
+    }): TextureFont;
+    shader(graphics: Graphics, path: string): ShaderProgram;
+    release(asset: Disposable): void;
+    /**
+     * Returns the number of cached assets, their references and the memory
+     * they use for each type of asset.
+     */
+    statistics(): {
+        [type: string]: { assets: number; references: number; bytes: number; }
+    };
+}
+
+/**
+ * An asset to load in the background, textures and sounds are shared with
+ * the asset cache.
+ */
+declare type AssetRequest =
+    { texture: string } | { sound: string } | { json: string } |
+    { font: { filename: string; size?: number; chars?: string;
+              distanceField?: boolean; pageSize?: number; maxPages?: number; } } |
+    { shader: string; graphics: Graphics };
+
+/**
+ * Loads groups of assets in the background. Files are read and decoded on
+ * other threads, the graphics and audio objects are created while polling
+ * events for at most the budget each frame.
+ */
+declare const loader: {
+    /**
+     * Milliseconds each frame spent creating loaded assets, defaults to 2.
+     */
+    budget: number;
+    /**
+     * Loads the assets of the group, groups with higher priority are loaded
+     * first. Resolves to the assets in the requested order, the group is
+     * rejected as a whole when an asset fails to load.
+     */
+    load(group: string, assets: AssetRequest[], priority?: number): Promise<any[]>;
+    /**
+     * Returns the progress of a group, or undefined when it isn't loading.
+     */
+    progress(group: string): { loaded: number; total: number; };
+    /**
+     * Stops loading the group and rejects it, returns false when it wasn't
+     * loading.
+     */
+    cancel(group: string): boolean;
+}
+
+/**
+ * Streams a large level in square cells around a position, only the cells
+ * within the radius are kept. The objects with a position in the level's JSON
+ * are partitioned into cells, the world file is built once and cached.
+ */
+interface WorldStreamOptions {
+    cellSize?: number; radius: number; hysteresis?: number;
+    enter: (cell: { x: number; y: number; }, data: any) => void;
+    leave: (cell: { x: number; y: number; }) => void;
+}
+
+declare class WorldStream implements Disposable {
+    /**
+     * Creates a stream from a level's JSON, or from a built ".world" file.
+     * Cells leave when they are further away than the radius and the
+     * hysteresis.
+     */
+    constructor(filepath: string, options: WorldStreamOptions);
+    /**
+     * Checks the cached world and reads the level in the background. The
+     * world is only built on the main thread when the level has changed.
+     */
+    static loadAsync(filepath: string,
+        options: WorldStreamOptions): Promise<WorldStream>;
+    /**
+     * The properties of the level which aren't partitioned into cells.
+     */
+    readonly data: any;
+    /**
+     * Number of cells which have entered.
+     */
+    readonly cells: number;
+    /**
+     * Reads the cells around the position and calls the callbacks for the
+     * cells which have been read or left.
+     */
+    update(x: number, y: number): void;
+    dispose(): void;
 }
 
 /**
@@ -92,6 +278,16 @@ declare type RasterizerState =
  */
 declare type PrimitiveType = "triangleList" | "pointList" | "lineList";
 
+/**
+ * Integer values of the primitive types, these can be passed in place of the
+ * names and are the cheapest to convert.
+ */
+declare const enum PrimitiveTypes {
+    triangleList = 0,
+    lineList = 1,
+    pointList = 2
+}
+
 /**
  * Performs primitive-based rendering.
  */
@@ -113,6 +309,8 @@ declare class Graphics {
         indexStart?: number;
         primitiveCount: number;
     }): void;
+    drawIndexedPrimitives(primitiveType: PrimitiveType | PrimitiveTypes,
+        indexStart: number, primitiveCount: number): void;
     /**
      * Renders a sequence of non-indexed geometric primitives.
      */
@@ -121,11 +319,14 @@ declare class Graphics {
         vertexStart?: number;
         primitiveCount: number;
     }): void;
+    drawPrimitives(primitiveType: PrimitiveType | PrimitiveTypes,
+        vertexStart: number, primitiveCount: number): void;
     /**
      * Returns the collection of textures that have been assigned to the 
-     * texture stages of the device.
+     * texture stages of the device. The length is the number of texture units
+     * available.
      */
-    textures: Texture2D[];
+    textures: Array<Texture2D | Texture2DArray>;
     /**
      * Presents the display with the contents of the next buffer.
      */
@@ -160,15 +361,65 @@ declare class Mouse {
     updateState();
 }
 
-declare class SoundBuffer {
+/**
+ * An object with native resources (e.g. textures or sound buffers) which are
+ * released when the object is collected.
+ */
+declare interface Disposable {
+    /**
+     * Releases the native resources immediately, using the object after that
+     * throws.
+     */
+    dispose(): void;
+}
+
+declare class SoundBuffer implements Disposable {
     constructor(filepath: string);
+    /**
+     * Decodes the sound on a worker thread, the promise is resolved with the
+     * buffer once it has been created.
+     */
+    static loadAsync(filepath: string): Promise<SoundBuffer>;
+    dispose(): void;
 }
 
+interface OneShotParams {
+    volume?: number;
+    pitch?: number;
+    /**
+     * Sounds with higher priority take the voices of lower ones when all
+     * voices are playing.
+     */
+    priority?: number;
+    /**
+     * Position of the sound, it's not positional when not given.
+     */
+    x?: number;
+    y?: number;
+    /**
+     * Distance from the listener where the sound is silent and culled.
+     */
+    maxDistance?: number;
+}
+
+/**
+ * A sound only uses one of the shared voices while it's playing and audible,
+ * otherwise it keeps track of its playback position without one.
+ */
 declare class SoundSource {
     loop: boolean;
     state: string;
     volume: number;
+    priority: number;
     constructor(buffer: SoundBuffer);
+    /**
+     * Plays the buffer once without creating a sound source.
+     */
+    static playOneShot(buffer: SoundBuffer, params?: OneShotParams): void;
+    /**
+     * Sets the position of the listener of positional sounds.
+     */
+    static setListener(x: number, y: number): void;
     /**
      * Start playing the sound.
      */
@@ -178,20 +429,53 @@ declare class SoundSource {
 }
 
 /**
- * Represents a program written in GLSL (OpenGL Shading Language).
+ * Plays an Ogg Vorbis file (e.g. music) while decoding it in the background,
+ * only a small part of the sound is in memory at a time. Short effects should
+ * be played from a SoundBuffer.
+ */
+declare class StreamingSoundSource implements Disposable {
+    loop: boolean;
+    readonly state: string;
+    volume: number;
+    /**
+     * Playback position in seconds.
+     */
+    readonly position: number;
+    /**
+     * Length of the sound in seconds.
+     */
+    readonly duration: number;
+    constructor(filepath: string);
+    play(): void;
+    pause(): void;
+    stop(): void;
+    /**
+     * Moves the playback position to the time in seconds.
+     */
+    seek(seconds: number): void;
+    dispose(): void;
+}
+
+/**
+ * Represents a program written in GLSL (OpenGL Shading Language). Uniforms
+ * are set as properties, setting a uniform the program doesn't declare (or
+ * doesn't use) is ignored.
  */
-declare class ShaderProgram {
+declare class ShaderProgram implements Disposable {
     constructor(graphics: Graphics, path: string);
+    dispose(): void;
 }
 
-declare class VertexSpecification {
+declare class VertexSpecification implements Disposable {
     constructor(graphics: Graphics, elements: string[]);
+    dispose(): void;
     setIndexData(data: Int32Array, usage: string);
     setVertexData(data: Float32Array, usage: string);
 }
 
-declare class RenderTarget {
+declare class RenderTarget implements Disposable {
     constructor(textures: Texture2D[]);
+    dispose(): void;
 }
 
 /**
@@ -216,7 +500,8 @@ declare type TextureFilter = "linear" | "nearest";
 
 declare type TextureWrap = "repeat" | "clampToEdge";
 
-declare class Texture2D {
+declare class Texture2D implements Disposable {
+    dispose(): void;
     /** 
      * Returns the unique id. 
      */
@@ -237,6 +522,29 @@ declare class Texture2D {
     getData(): number[];
 }
 
+/**
+ * Texture with multiple layers, each layer is an image with the same size.
+ */
+declare class Texture2DArray implements Disposable {
+    dispose(): void;
+    /** 
+     * Returns the unique id. 
+     */
+    id: number;
+    height: number;
+    width: number;
+    /**
+     * Returns the number of layers.
+     */
+    layers: number;
+    filter: TextureFilter;
+    wrap: TextureWrap;
+    /**
+     * Creates a new texture array with one layer for each image.
+     */
+    constructor(filepaths: string[]);
+}
+
 declare class Window {
     /**
      * Gets the graphics.
@@ -279,11 +587,64 @@ declare class Window {
     setTitle(title: string): void;
 }
 
-declare class TextureFont {
+declare class TextureFont implements Disposable {
+    /**
+     * Releases the font and the textures of its pages.
+     */
+    dispose(): void;
+    /**
+     * Size (in pixels) the glyphs were rendered at.
+     */
+    size: number;
+    /**
+     * True if the glyphs are stored as signed distance fields.
+     */
+    distanceField: boolean;
+    /**
+     * Returns the first page of the glyph atlas.
+     */
     texture: Texture2D;
+    /**
+     * Returns the pages of the glyph atlas, pages are added when needed.
+     */
+    pages: Texture2D[];
     glyphs: GlyphCollection;
-    constructor(options: { filename: string, size?: number, chars?: string });
+    /**
+     * Creates a new font. The characters in chars are loaded up front, other 
+     * characters are loaded the first time they are used.
+     * @pageSize Width and height of each atlas page (default: 1024).
+     * @maxPages Pages in the atlas before the least recently used page is 
+     * reused (default: 4).
+     * @distanceField Stores the glyphs as signed distance fields, the text can
+     * then be scaled without getting blurry when drawn with a spritebatch from
+     * createDistanceFieldBatch (default: false, pageSize defaults to 512).
+     */
+    constructor(options: { 
+        filename: string, size?: number, chars?: string, pageSize?: number, 
+        maxPages?: number, distanceField?: boolean 
+    });
+    /**
+     * Line height (in pixels) of the font.
+     */
+    lineHeight: number;
     measureString(text: string): number;
+    /**
+     * Positions the glyphs of the text and returns 10 values for each visible
+     * glyph: x, y, width, height (in pixels, y pointing down from the baseline 
+     * of the first line), u0, v0, u1, v1 (texture coordinates in the page), 
+     * page and advance. Kerning is applied between glyphs. The layout is 
+     * cached while the text and options are the same, each call returns a 
+     * new copy of it.
+     * @align Horizontal alignment of each line relative to x = 0 
+     * (default: 'left').
+     * @maxWidth Lines are wrapped at spaces when wider than this, 0 disables 
+     * wrapping (default: 0).
+     * @lineHeight Distance in pixels between lines (default: font.lineHeight).
+     */
+    layout(text: string, options?: {
+        align?: 'left' | 'center' | 'right', maxWidth?: number, 
+        lineHeight?: number
+    }): Float32Array;
 }
 
 /** Collection of glyphs. */
@@ -300,4 +661,6 @@ declare interface Glyph {
     advance: { x: number, y: number };
     /** Source rectangle of the glyph in the texture. */
     source: { x: number, y: number, width: number, height: number };
+    /** Index of the atlas page that contains the glyph. */
+    page: number;
 }
\ No newline at end of file
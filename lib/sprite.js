@@ -25,7 +25,15 @@ const utils_1 = require("./utils");
 const transform_1 = require("./transform");
 const math_1 = require("./math");
 const matrix4 = new utils_1.Pool(math_1.Matrix4, 5);
-const vector2 = new utils_1.Pool(math_1.Vector2, 5);
+/** Number of texture units used for 2D textures by the sprite shader. */
+const maxTextures = 12;
+/** Number of texture units used for texture arrays by the sprite shader. */
+const maxTextureArrays = 4;
+/** Number of floats for each glyph returned by TextureFont.layout. */
+const layoutStride = 10;
+function isTextureArray(texture) {
+    return texture.layers !== undefined;
+}
 class Rectangle {
     /**
      * Creates a new rectangle.
@@ -69,6 +77,10 @@ class Sprite {
         this.transform = new transform_1.Transform();
         this.pixelsPerUnit = 100;
         this.drawOrder = 0;
+        /**
+         * The layer to draw when the texture is a texture array.
+         */
+        this.layer = 0;
         this.source = new Rectangle(0, 0, this.texture ?
             this.texture.width : 0, this.texture ? this.texture.height : 0);
         this.origin = new math_1.Vector2(this.width / 2, this.height / 2);
@@ -107,22 +119,46 @@ class Sprite {
      * Loads a texture from the given file path and creates a new sprite.
      */
     static createFromFile(filePath, spriteBatch) {
-        return new Sprite(spriteBatch, new Texture2D(filePath));
+        return new Sprite(spriteBatch, assets.texture(filePath));
     }
 }
 exports.Sprite = Sprite;
+/**
+ * Creates a spritebatch for drawing text with distance field fonts. The text
+ * stays sharp at any scale, the font is only rendered once.
+ */
+function createDistanceFieldBatch(graphics, camera) {
+    let spriteBatch = new SpriteBatch(graphics, camera);
+    spriteBatch.distanceField = true;
+    return spriteBatch;
+}
+exports.createDistanceFieldBatch = createDistanceFieldBatch;
 class SpriteBatch {
     /**
-     * Creates a new spritebatch.
+     * Creates a new spritebatch, a custom shader can be used as long as it
+     * has the same inputs as the default sprite shader. The uniforms of the
+     * default shader which the custom shader doesn't declare are ignored.
      */
-    constructor(graphics, camera) {
+    constructor(graphics, camera, shaderPath = module.path + '/content/shaders/sprite') {
         this.graphics = graphics;
         this.camera = camera;
         this.sprites = [];
         this.vertices = new SpriteVertexArray();
         this.indicies = new SpriteIndexArray();
-        this.program = new ShaderProgram(this.graphics, module.path + '/content/shaders/sprite');
-        this.vertexSpecification = new VertexSpecification(this.graphics, ['vec3', 'vec2', 'vec4']);
+        this.textures = [];
+        this.textureArrays = [];
+        /**
+         * Draws the sprites as distance field glyphs with the default shader.
+         */
+        this.distanceField = false;
+        this.program = assets.shader(this.graphics, shaderPath);
+        this.vertexSpecification = new VertexSpecification(this.graphics, ['vec3', 'vec2', 'vec4', 'vec2']);
+        for (let i = 0; i < maxTextures; i++) {
+            this.program[`textures[${i}]`] = i;
+        }
+        for (let i = 0; i < maxTextureArrays; i++) {
+            this.program[`textureArrays[${i}]`] = maxTextures + i;
+        }
     }
     /**
      * Sets up the render states needed before drawing.
@@ -134,6 +170,8 @@ class SpriteBatch {
         this.graphics.setShaderProgram(this.program);
         this.program['viewProjection'] =
             this.camera.getViewProjection(matrix4.next);
+        // The program is shared with other batches through the asset cache.
+        this.program['distanceField'] = this.distanceField ? 1 : 0;
     }
     /**
      * Sorts the sprites based on texture.
@@ -165,34 +203,68 @@ class SpriteBatch {
         this.sprites.sort(this.sortByTexture);
         let numberOfSpritesInBatch = 0;
         let drawOrder = this.sprites[0].drawOrder;
-        let texture = this.sprites[0].texture;
         for (let sprite of this.sprites) {
-            if (sprite.texture !== texture || sprite.drawOrder !== drawOrder) {
-                this.drawBatch(texture, numberOfSpritesInBatch);
+            if (sprite.drawOrder !== drawOrder) {
+                this.drawBatch(numberOfSpritesInBatch);
                 numberOfSpritesInBatch = 0;
                 drawOrder = sprite.drawOrder;
-                texture = sprite.texture;
             }
-            this.vertices.addVertices(sprite);
+            let unit = this.getTextureUnit(sprite.texture);
+            if (unit < 0) {
+                // All texture units are in use, the sprites added so far needs
+                // to be drawn before continuing.
+                this.drawBatch(numberOfSpritesInBatch);
+                numberOfSpritesInBatch = 0;
+                unit = this.getTextureUnit(sprite.texture);
+            }
+            this.vertices.addVertices(sprite, unit);
             this.indicies.addIndicies(numberOfSpritesInBatch * 4);
             numberOfSpritesInBatch++;
         }
         this.sprites.length = 0;
-        this.drawBatch(texture, numberOfSpritesInBatch);
+        this.drawBatch(numberOfSpritesInBatch);
         this.graphics.blendState = savedState.blendState;
         this.graphics.depthState = savedState.depthState;
     }
     /**
-     * Draws a batch of sprites that has the same texture.
+     * Returns the texture unit to use for the given texture in the current
+     * batch, or -1 when there are no texture units left.
+     */
+    getTextureUnit(texture) {
+        if (isTextureArray(texture)) {
+            let index = this.textureArrays.indexOf(texture);
+            if (index < 0) {
+                if (this.textureArrays.length === maxTextureArrays) {
+                    return -1;
+                }
+                index = this.textureArrays.push(texture) - 1;
+            }
+            return maxTextures + index;
+        }
+        let index = this.textures.indexOf(texture);
+        if (index < 0) {
+            if (this.textures.length === maxTextures) {
+                return -1;
+            }
+            index = this.textures.push(texture) - 1;
+        }
+        return index;
+    }
+    /**
+     * Draws a batch of sprites using the textures assigned to the batch.
      */
-    drawBatch(texture, numberOfSprites) {
+    drawBatch(numberOfSprites) {
         this.vertexSpecification.setVertexData(new Float32Array(this.vertices), "stream");
         this.vertexSpecification.setIndexData(new Int32Array(this.indicies), "stream");
         this.vertices.length = this.indicies.length = 0;
-        this.graphics.textures[0] = texture;
-        this.graphics.drawIndexedPrimitives({
-            primitiveType: "triangleList", primitiveCount: numberOfSprites * 2
-        });
+        for (let i = 0; i < this.textures.length; i++) {
+            this.graphics.textures[i] = this.textures[i];
+        }
+        for (let i = 0; i < this.textureArrays.length; i++) {
+            this.graphics.textures[maxTextures + i] = this.textureArrays[i];
+        }
+        this.textures.length = this.textureArrays.length = 0;
+        this.graphics.drawIndexedPrimitives(0 /* triangleList */, 0, numberOfSprites * 2);
     }
 }
 exports.SpriteBatch = SpriteBatch;
@@ -203,27 +275,28 @@ class SpriteVertexArray extends Array {
         this.matrix = new math_1.Matrix4();
     }
     /**
-     * Adds vertex data for a sprite.
+     * Adds vertex data for a sprite drawn with the texture at the given unit.
      */
-    addVertices(sprite) {
+    addVertices(sprite, unit) {
         let world = sprite.transform.getWorldMatrix(this.matrix);
         let uv = Rectangle.divide(sprite.source, sprite.texture.width, sprite.texture.height);
         let color = sprite.color;
         let rect = sprite.getRectangle();
-        this.addVertex(rect.x, rect.y, uv.x, uv.y, color, world);
-        this.addVertex(rect.r, rect.y, uv.r, uv.y, color, world);
-        this.addVertex(rect.x, rect.b, uv.x, uv.b, color, world);
-        this.addVertex(rect.r, rect.b, uv.r, uv.b, color, world);
+        let layer = sprite.layer;
+        this.addVertex(rect.x, rect.y, uv.x, uv.y, color, world, unit, layer);
+        this.addVertex(rect.r, rect.y, uv.r, uv.y, color, world, unit, layer);
+        this.addVertex(rect.x, rect.b, uv.x, uv.b, color, world, unit, layer);
+        this.addVertex(rect.r, rect.b, uv.r, uv.b, color, world, unit, layer);
     }
     /**
      * Adds an sprite vertex at the given local-space coordinates.
      */
-    addVertex(x, y, u, v, c, m) {
+    addVertex(x, y, u, v, c, m, unit, layer) {
         this.vector[0] = x;
         this.vector[1] = y;
         this.vector[2] = 0;
         let t = this.vector.transform(m, this.vector);
-        this.push(t[0], t[1], t[2], u, v, c[0], c[1], c[2], c[3]);
+        this.push(t[0], t[1], t[2], u, v, c[0], c[1], c[2], c[3], unit, layer);
     }
 }
 class SpriteIndexArray extends Array {
@@ -240,49 +313,50 @@ class SpriteText {
         this.text = text;
         this.font = font;
         this.spriteBatch = spriteBatch;
-        /** Each character in a string is represented by a sprite. */
+        /** Each visible character is represented by a sprite. */
         this.sprites = [];
         this.alignment = 'center';
         this.color = color_1.Color.white;
         this.transform = new transform_1.Transform();
         this.pixelsPerUnit = 100;
+        /** Width in pixels before wrapping to the next line, 0 disables it. */
+        this.maxWidth = 0;
+        /** Distance in pixels between lines, 0 uses the line height of the font. */
+        this.lineHeight = 0;
     }
     /** Attaches the SpriteText to a Transform. */
     attach(transform) {
         this.transform.parent = transform;
     }
     draw() {
+        // The layout is cached by the font as long as the text and options 
+        // stays the same.
+        let quads = this.font.layout(this.text, {
+            align: this.alignment,
+            maxWidth: this.maxWidth,
+            lineHeight: this.lineHeight || this.font.lineHeight
+        });
+        let count = quads.length / layoutStride;
         // Make sure we have enough sprites to draw text.
-        while (this.sprites.length < this.text.length) {
+        while (this.sprites.length < count) {
             let sprite = new Sprite(this.spriteBatch, this.font.texture);
             this.sprites.push(sprite);
         }
-        if (this.alignment == 'center') {
-            var origin = vector2.next.xy(this.font.measureString(this.text) / 2, 0);
-        }
-        else if (this.alignment == 'left') {
-            var origin = vector2.next.xy(0, 0);
-        }
-        else if (this.alignment == 'right') {
-            var origin = vector2.next.xy(this.font.measureString(this.text), 0);
-        }
-        for (var i = 0; i < this.text.length; i++) {
-            let glyph = this.font.glyphs[this.text.charAt(i)];
+        for (let i = 0; i < count; i++) {
+            let quad = i * layoutStride;
             let sprite = this.sprites[i];
+            let texture = this.font.pages[quads[quad + 8]];
+            sprite.texture = texture;
             sprite.pixelsPerUnit = this.pixelsPerUnit;
             sprite.color = this.color;
             sprite.transform = this.transform;
-            sprite.origin.x =
-                (origin.x - glyph.offset.x) / this.pixelsPerUnit;
-            sprite.origin.y =
-                (origin.y + glyph.offset.y) / this.pixelsPerUnit;
-            sprite.source.width = glyph.source.width;
-            sprite.source.height = glyph.source.height;
-            sprite.source.x = glyph.source.x;
-            sprite.source.y = glyph.source.y;
-            origin[0] -= glyph.advance.x;
-            origin[1] -= glyph.advance.y;
-            this.spriteBatch.addSprite(this.sprites[i]);
+            sprite.origin.x = -quads[quad] / this.pixelsPerUnit;
+            sprite.origin.y = -quads[quad + 1] / this.pixelsPerUnit;
+            sprite.source.width = quads[quad + 2];
+            sprite.source.height = quads[quad + 3];
+            sprite.source.x = quads[quad + 4] * texture.width;
+            sprite.source.y = quads[quad + 5] * texture.height;
+            this.spriteBatch.addSprite(sprite);
         }
     }
 }
@@ -27,7 +27,19 @@ import { Vector2, Vector3, Matrix4 } from "./math"
 import { Camera } from "./camera"
 
 const matrix4 = new Pool(Matrix4, 5);
-const vector2 = new Pool(Vector2, 5);
+
+/** Number of texture units used for 2D textures by the sprite shader. */
+const maxTextures = 12;
+/** Number of texture units used for texture arrays by the sprite shader. */
+const maxTextureArrays = 4;
+/** Number of floats for each glyph returned by TextureFont.layout. */
+const layoutStride = 10;
+
+type SpriteTexture = Texture2D | Texture2DArray;
+
+function isTextureArray(texture: SpriteTexture): texture is Texture2DArray {
+    return (<Texture2DArray>texture).layers !== undefined;
+}
 
 class Rectangle {
     /**
@@ -64,10 +76,15 @@ export class Sprite {
     public pixelsPerUnit = 100;
     public origin: Vector2;
     public drawOrder = 0;
+    /**
+     * The layer to draw when the texture is a texture array.
+     */
+    public layer = 0;
     /**
      * Creates a new sprite.
      */
-    constructor(public spriteBatch: SpriteBatch, public texture: Texture2D = null) {
+    constructor(public spriteBatch: SpriteBatch, 
+        public texture: SpriteTexture = null) {
         this.source = new Rectangle(0, 0, this.texture ?
             this.texture.width : 0, this.texture ? this.texture.height : 0);
         this.origin = new Vector2(this.width / 2, this.height / 2);
@@ -107,24 +124,48 @@ export class Sprite {
      * Loads a texture from the given file path and creates a new sprite.
      */
     static createFromFile(filePath: string, spriteBatch: SpriteBatch) {
-        return new Sprite(spriteBatch, new Texture2D(filePath));
+        return new Sprite(spriteBatch, assets.texture(filePath));
     }
 }
 
+/**
+ * Creates a spritebatch for drawing text with distance field fonts. The text
+ * stays sharp at any scale, the font is only rendered once.
+ */
+export function createDistanceFieldBatch(graphics: Graphics, camera: Camera) {
+    let spriteBatch = new SpriteBatch(graphics, camera);
+    spriteBatch.distanceField = true;
+    return spriteBatch;
+}
+
 export class SpriteBatch {
     private program: ShaderProgram;
     private vertexSpecification: VertexSpecification;
     private sprites: Sprite[] = [];
     private vertices = new SpriteVertexArray();
     private indicies = new SpriteIndexArray();
+    private textures: Texture2D[] = [];
+    private textureArrays: Texture2DArray[] = [];
+    /**
+     * Draws the sprites as distance field glyphs with the default shader.
+     */
+    distanceField = false;
     /**
-     * Creates a new spritebatch.
+     * Creates a new spritebatch, a custom shader can be used as long as it
+     * has the same inputs as the default sprite shader. The uniforms of the
+     * default shader which the custom shader doesn't declare are ignored.
      */
-    constructor(public graphics: Graphics, public camera: Camera) {
-        this.program = new ShaderProgram(
-            this.graphics, module.path + '/content/shaders/sprite');
+    constructor(public graphics: Graphics, public camera: Camera,
+        shaderPath = module.path + '/content/shaders/sprite') {
+        this.program = assets.shader(this.graphics, shaderPath);
         this.vertexSpecification = new VertexSpecification(
-            this.graphics, ['vec3', 'vec2', 'vec4']);
+            this.graphics, ['vec3', 'vec2', 'vec4', 'vec2']);
+        for (let i = 0; i < maxTextures; i++) {
+            this.program[`textures[${i}]`] = i;
+        }
+        for (let i = 0; i < maxTextureArrays; i++) {
+            this.program[`textureArrays[${i}]`] = maxTextures + i;
+        }
     }
     /**
      * Sets up the render states needed before drawing.
@@ -136,6 +177,8 @@ export class SpriteBatch {
         this.graphics.setShaderProgram(this.program);
         this.program['viewProjection'] = 
             this.camera.getViewProjection(matrix4.next);
+        // The program is shared with other batches through the asset cache.
+        this.program['distanceField'] = this.distanceField ? 1 : 0;
     }
     /**
      * Sorts the sprites based on texture.
@@ -168,39 +211,75 @@ export class SpriteBatch {
 
         let numberOfSpritesInBatch = 0;
         let drawOrder = this.sprites[0].drawOrder;
-        let texture = this.sprites[0].texture;
 
         for (let sprite of this.sprites) {
-            if (sprite.texture !== texture || sprite.drawOrder !== drawOrder) {
-                this.drawBatch(texture, numberOfSpritesInBatch);
+            if (sprite.drawOrder !== drawOrder) {
+                this.drawBatch(numberOfSpritesInBatch);
                 numberOfSpritesInBatch = 0;
                 drawOrder = sprite.drawOrder;
-                texture = sprite.texture;
             }
-            this.vertices.addVertices(sprite);
+            let unit = this.getTextureUnit(sprite.texture);
+            if (unit < 0) {
+                // All texture units are in use, the sprites added so far needs
+                // to be drawn before continuing.
+                this.drawBatch(numberOfSpritesInBatch);
+                numberOfSpritesInBatch = 0;
+                unit = this.getTextureUnit(sprite.texture);
+            }
+            this.vertices.addVertices(sprite, unit);
             this.indicies.addIndicies(numberOfSpritesInBatch * 4);
             numberOfSpritesInBatch++;
         }
         this.sprites.length = 0;
-        this.drawBatch(texture, numberOfSpritesInBatch);
+        this.drawBatch(numberOfSpritesInBatch);
 
         this.graphics.blendState = savedState.blendState;
         this.graphics.depthState = savedState.depthState;
     }
     /**
-     * Draws a batch of sprites that has the same texture.
+     * Returns the texture unit to use for the given texture in the current 
+     * batch, or -1 when there are no texture units left.
      */
-    private drawBatch(texture: Texture2D, numberOfSprites: number) {
+    private getTextureUnit(texture: SpriteTexture) {
+        if (isTextureArray(texture)) {
+            let index = this.textureArrays.indexOf(texture);
+            if (index < 0) {
+                if (this.textureArrays.length === maxTextureArrays) {
+                    return -1;
+                }
+                index = this.textureArrays.push(texture) - 1;
+            }
+            return maxTextures + index;
+        }
+        let index = this.textures.indexOf(texture);
+        if (index < 0) {
+            if (this.textures.length === maxTextures) {
+                return -1;
+            }
+            index = this.textures.push(texture) - 1;
+        }
+        return index;
+    }
+    /**
+     * Draws a batch of sprites using the textures assigned to the batch.
+     */
+    private drawBatch(numberOfSprites: number) {
         this.vertexSpecification.setVertexData(
             new Float32Array(this.vertices), "stream");
         this.vertexSpecification.setIndexData(
             new Int32Array(this.indicies), "stream");
         this.vertices.length = this.indicies.length = 0;
 
-        this.graphics.textures[0] = texture;
-        this.graphics.drawIndexedPrimitives({
-            primitiveType: "triangleList", primitiveCount: numberOfSprites * 2
-        });
+        for (let i = 0; i < this.textures.length; i++) {
+            this.graphics.textures[i] = this.textures[i];
+        }
+        for (let i = 0; i < this.textureArrays.length; i++) {
+            this.graphics.textures[maxTextures + i] = this.textureArrays[i];
+        }
+        this.textures.length = this.textureArrays.length = 0;
+
+        this.graphics.drawIndexedPrimitives(
+            PrimitiveTypes.triangleList, 0, numberOfSprites * 2);
     }
 }
 
@@ -208,32 +287,34 @@ class SpriteVertexArray extends Array<number> {
     private vector = new Vector3();
     private matrix = new Matrix4();
     /**
-     * Adds vertex data for a sprite.
+     * Adds vertex data for a sprite drawn with the texture at the given unit.
      */
-    addVertices(sprite: Sprite) {
+    addVertices(sprite: Sprite, unit: number) {
         let world = sprite.transform.getWorldMatrix(this.matrix);
         let uv = Rectangle.divide(
             sprite.source, sprite.texture.width, sprite.texture.height);
         let color = sprite.color;
         let rect = sprite.getRectangle();
+        let layer = sprite.layer;
 
-        this.addVertex(rect.x, rect.y, uv.x, uv.y, color, world);
-        this.addVertex(rect.r, rect.y, uv.r, uv.y, color, world);
-        this.addVertex(rect.x, rect.b, uv.x, uv.b, color, world);
-        this.addVertex(rect.r, rect.b, uv.r, uv.b, color, world);
+        this.addVertex(rect.x, rect.y, uv.x, uv.y, color, world, unit, layer);
+        this.addVertex(rect.r, rect.y, uv.r, uv.y, color, world, unit, layer);
+        this.addVertex(rect.x, rect.b, uv.x, uv.b, color, world, unit, layer);
+        this.addVertex(rect.r, rect.b, uv.r, uv.b, color, world, unit, layer);
     }
     /**
      * Adds an sprite vertex at the given local-space coordinates.
      */
-    private addVertex(
-        x: number, y: number, u: number, v: number, c: Color, m: Matrix4) {
+    private addVertex(x: number, y: number, u: number, v: number, c: Color, 
+        m: Matrix4, unit: number, layer: number) {
             
         this.vector[0] = x;
         this.vector[1] = y;
         this.vector[2] = 0;
 
         let t = this.vector.transform(m, this.vector);
-        this.push(t[0], t[1], t[2], u, v, c[0], c[1], c[2], c[3]);
+        this.push(
+            t[0], t[1], t[2], u, v, c[0], c[1], c[2], c[3], unit, layer);
     }
 }
 
@@ -249,13 +330,17 @@ class SpriteIndexArray extends Array<number> {
 type TextAlignment = 'left' | 'right' | 'center';
 
 export class SpriteText {
-    /** Each character in a string is represented by a sprite. */
+    /** Each visible character is represented by a sprite. */
     public sprites: Sprite[] = [];
 
     public alignment: TextAlignment = 'center';
     public color = Color.white;
     public transform = new Transform();
     public pixelsPerUnit = 100;
+    /** Width in pixels before wrapping to the next line, 0 disables it. */
+    public maxWidth = 0;
+    /** Distance in pixels between lines, 0 uses the line height of the font. */
+    public lineHeight = 0;
 
     /** Creates a new SpriteFont. */
     constructor(public text: string, 
@@ -267,40 +352,37 @@ export class SpriteText {
     }
 
     draw() {
+        // The layout is cached by the font as long as the text and options 
+        // stays the same.
+        let quads = this.font.layout(this.text, {
+            align: this.alignment, 
+            maxWidth: this.maxWidth, 
+            lineHeight: this.lineHeight || this.font.lineHeight
+        });
+        let count = quads.length / layoutStride;
+        
         // Make sure we have enough sprites to draw text.
-        while (this.sprites.length < this.text.length) {
+        while (this.sprites.length < count) {
             let sprite = new Sprite(this.spriteBatch, this.font.texture);
             this.sprites.push(sprite);
         }
-        if (this.alignment == 'center') {
-            var origin = vector2.next.xy(
-                this.font.measureString(this.text) / 2, 0);
-        } else if (this.alignment == 'left') {
-            var origin = vector2.next.xy(0, 0);
-        } else if (this.alignment == 'right') {
-            var origin = vector2.next.xy(
-                this.font.measureString(this.text), 0);
-        }
-        for (var i = 0; i < this.text.length; i++) {
-            let glyph = this.font.glyphs[this.text.charAt(i)];
+        for (let i = 0; i < count; i++) {
+            let quad = i * layoutStride;
             let sprite = this.sprites[i];
+            let texture = this.font.pages[quads[quad + 8]];
 
+            sprite.texture = texture;
             sprite.pixelsPerUnit = this.pixelsPerUnit;
             sprite.color = this.color;
             sprite.transform = this.transform;
-            sprite.origin.x = 
-                (origin.x - glyph.offset.x) / this.pixelsPerUnit;
-            sprite.origin.y = 
-                (origin.y + glyph.offset.y) / this.pixelsPerUnit;
-            sprite.source.width = glyph.source.width;
-            sprite.source.height = glyph.source.height;
-            sprite.source.x = glyph.source.x;
-            sprite.source.y = glyph.source.y;
-
-            origin[0] -= glyph.advance.x;
-            origin[1] -= glyph.advance.y;
+            sprite.origin.x = -quads[quad] / this.pixelsPerUnit;
+            sprite.origin.y = -quads[quad + 1] / this.pixelsPerUnit;
+            sprite.source.width = quads[quad + 2];
+            sprite.source.height = quads[quad + 3];
+            sprite.source.x = quads[quad + 4] * texture.width;
+            sprite.source.y = quads[quad + 5] * texture.height;
 
-            this.spriteBatch.addSprite(this.sprites[i]);
+            this.spriteBatch.addSprite(sprite);
         }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,77 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+// Measures the per-call overhead of the graphics bindings, comparing the
+// object forms against the positional and integer forms.
+
+let window = new Window();
+let graphics = window.graphics;
+
+let vertexSpecification = new VertexSpecification(graphics, ["vec3", "vec3"]);
+vertexSpecification.setVertexData(new Float32Array(18), "static");
+let shader = new ShaderProgram(graphics, "../triangle/shader");
+
+graphics.setVertexSpecification(vertexSpecification);
+graphics.setShaderProgram(shader);
+
+const iterations = 1000000;
+
+function measure(name: string, call: () => void) {
+    // Warm up so the call site gets optimized before measuring.
+    for (let i = 0; i < 10000; i++) {
+        call();
+    }
+    let gcTime = profiler.gcStatistics().time;
+    let start = Date.now();
+    for (let i = 0; i < iterations; i++) {
+        call();
+    }
+    let nanoseconds = (Date.now() - start) * 1000000 / iterations;
+    gcTime = profiler.gcStatistics().time - gcTime;
+    console.log(`${name}: ${nanoseconds.toFixed(1)} ns/call, ` +
+        `garbage collection ${gcTime.toFixed(2)} ms`);
+}
+
+measure("blendState (name)", () => {
+    graphics.blendState = "alphaBlend";
+});
+measure("drawPrimitives (object)", () => {
+    graphics.drawPrimitives({
+        primitiveType: "triangleList", vertexStart: 0, primitiveCount: 0
+    });
+});
+measure("drawPrimitives (positional)", () => {
+    graphics.drawPrimitives("triangleList", 0, 0);
+});
+measure("drawPrimitives (integer)", () => {
+    graphics.drawPrimitives(PrimitiveTypes.triangleList, 0, 0);
+});
+
+let collections = profiler.gcStatistics().collections;
+for (let type in collections) {
+    let collection = collections[type];
+    console.log(`${type}: ${collection.count} collections, ` +
+        `${collection.time.toFixed(2)} ms, ` +
+        `max pause ${collection.maxPause.toFixed(2)} ms`);
+}
+
+window.close();
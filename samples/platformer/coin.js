@@ -28,7 +28,6 @@ class Coin extends $.Entity {
         this.lifeTime = 0;
         this.destroyed = false;
         this.destroyedTime = 0;
-        this.sound = new SoundSource(content_1.Content.SoundBuffers.coin);
         // Box collider for collision detection.
         this.collider = this.addComponent(new $.BoxCollider(new $.Vector3(0.35, 0.5, 1)));
         let coin = this.addComponent(new $.Sprite(level.spriteBatch, content_1.Content.Textures.coin));
@@ -65,7 +64,7 @@ class Coin extends $.Entity {
         if (this.destroyed) {
             return;
         }
-        this.sound.play();
+        SoundSource.playOneShot(content_1.Content.SoundBuffers.coin, { priority: 1 });
         this.destroyed = true;
     }
 }
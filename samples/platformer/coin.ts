@@ -30,13 +30,10 @@ export class Coin extends $.Entity {
     destroyed = false;
     destroyedTime = 0;
     startPosition: $.Vector3;
-    sound: SoundSource;
 
     constructor(level: Level, name: string) {
         super();
 
-        this.sound = new SoundSource(Content.SoundBuffers.coin);
-
         // Box collider for collision detection.
         this.collider = this.addComponent(
             new $.BoxCollider(new $.Vector3(0.35, 0.5, 1)));
@@ -82,7 +79,7 @@ export class Coin extends $.Entity {
         if (this.destroyed) {
             return;
         }
-        this.sound.play();
+        SoundSource.playOneShot(Content.SoundBuffers.coin, { priority: 1 });
         this.destroyed = true;
     }
 }
\ No newline at end of file
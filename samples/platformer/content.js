@@ -32,6 +32,8 @@ var Content;
     var SoundBuffers;
     (function (SoundBuffers) {
     })(SoundBuffers = Content.SoundBuffers || (Content.SoundBuffers = {}));
+    // The textures are loaded right away, the promise is resolved when the
+    // sounds have been decoded in the background.
     function load() {
         Textures.sky = new Texture2D("./content/sky.png");
         Textures.sky.filter = "nearest";
@@ -66,8 +68,13 @@ var Content;
             };
         }
         SpriteSheets.jump.texture.filter = "nearest";
-        SoundBuffers.coin = new SoundBuffer("./content/coin.ogg");
-        SoundBuffers.jump = new SoundBuffer("./content/jump.ogg");
+        return Promise.all([
+            SoundBuffer.loadAsync("./content/coin.ogg"),
+            SoundBuffer.loadAsync("./content/jump.ogg")
+        ]).then((buffers) => {
+            SoundBuffers.coin = buffers[0];
+            SoundBuffers.jump = buffers[1];
+        });
     }
     Content.load = load;
 })(Content = exports.Content || (exports.Content = {}));
@@ -44,6 +44,8 @@ export namespace Content {
         export let jump: SoundBuffer;
     }
 
+    // The textures are loaded right away, the promise is resolved when the
+    // sounds have been decoded in the background.
     export function load() {
         Textures.sky = new Texture2D("./content/sky.png");
         Textures.sky.filter = "nearest";
@@ -90,7 +92,12 @@ export namespace Content {
         }
         SpriteSheets.jump.texture.filter = "nearest";
 
-        SoundBuffers.coin = new SoundBuffer("./content/coin.ogg");
-        SoundBuffers.jump = new SoundBuffer("./content/jump.ogg");
+        return Promise.all([
+            SoundBuffer.loadAsync("./content/coin.ogg"),
+            SoundBuffer.loadAsync("./content/jump.ogg")
+        ]).then((buffers) => {
+            SoundBuffers.coin = buffers[0];
+            SoundBuffers.jump = buffers[1];
+        });
     }
 }
\ No newline at end of file
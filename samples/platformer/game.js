@@ -25,13 +25,21 @@ const context_1 = require("./context");
 const level_1 = require("./level");
 const content_1 = require("./content");
 $.Game.init();
-content_1.Content.load();
-const level = new level_1.Level(new context_1.GraphicsContext());
+let level;
+// The level is created when the content has been loaded, the game keeps
+// running meanwhile.
+content_1.Content.load().then(() => {
+    level = new level_1.Level(new context_1.GraphicsContext());
+});
 $.Game.draw = function () {
-    level.draw();
+    if (level) {
+        level.draw();
+    }
 };
 $.Game.update = function (elapsedTime) {
-    level.update(elapsedTime);
+    if (level) {
+        level.update(elapsedTime);
+    }
 };
 $.Game.run();
 //# sourceMappingURL=data:application/json;base64,eyJ2ZXJzaW9uIjozLCJmaWxlIjoiZ2FtZS5qcyIsInNvdXJjZVJvb3QiOiIiLCJzb3VyY2VzIjpbImdhbWUudHMiXSwibmFtZXMiOltdLCJtYXBwaW5ncyI6IkFBQUE7Ozs7Ozs7Ozs7Ozs7Ozs7Ozs7O1dBb0JXOztBQUVYLG1DQUFrQztBQUNsQyx1Q0FBMkM7QUFDM0MsbUNBQStCO0FBQy9CLHVDQUFtQztBQUVuQyxDQUFDLENBQUMsSUFBSSxDQUFDLElBQUksRUFBRSxDQUFDO0FBRWQsaUJBQU8sQ0FBQyxJQUFJLEVBQUUsQ0FBQztBQUVmLE1BQU0sS0FBSyxHQUFHLElBQUksYUFBSyxDQUFDLElBQUkseUJBQWUsRUFBRSxDQUFDLENBQUM7QUFFL0MsQ0FBQyxDQUFDLElBQUksQ0FBQyxJQUFJLEdBQUc7SUFDVixLQUFLLENBQUMsSUFBSSxFQUFFLENBQUM7QUFDakIsQ0FBQyxDQUFDO0FBRUYsQ0FBQyxDQUFDLElBQUksQ0FBQyxNQUFNLEdBQUcsVUFBUyxXQUFtQjtJQUN4QyxLQUFLLENBQUMsTUFBTSxDQUFDLFdBQVcsQ0FBQyxDQUFDO0FBQzlCLENBQUMsQ0FBQztBQUVGLENBQUMsQ0FBQyxJQUFJLENBQUMsR0FBRyxFQUFFLENBQUMifQ==
\ No newline at end of file
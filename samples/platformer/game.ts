@@ -27,16 +27,24 @@ import { Content } from "./content"
 
 $.Game.init();
 
-Content.load();
+let level: Level;
 
-const level = new Level(new GraphicsContext());
+// The level is created when the content has been loaded, the game keeps
+// running meanwhile.
+Content.load().then(() => {
+    level = new Level(new GraphicsContext());
+});
 
 $.Game.draw = function() {
-    level.draw();
+    if (level) {
+        level.draw();
+    }
 };
 
 $.Game.update = function(elapsedTime: number) {
-    level.update(elapsedTime);
+    if (level) {
+        level.update(elapsedTime);
+    }
 };
 
 $.Game.run();
\ No newline at end of file
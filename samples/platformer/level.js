@@ -41,9 +41,12 @@ class Level {
         this.playerStart = new $.Vector3();
         this.platforms = [];
         this.coins = [];
+        this.cells = {};
+        this.entered = false;
         let fw = new FileWatcher("./content/level.json", () => {
-            // Reload level when the file changes.
-            this.load("./content/level.json");
+            // Reload level when the file changes, without blocking the game.
+            WorldStream.loadAsync("./content/level.json", this.worldOptions())
+                .then((world) => this.start(world));
         });
         this.camera = context.camera;
         this.spriteBatch = context.spriteBatch;
@@ -64,22 +67,58 @@ class Level {
         this.load("./content/level.json");
     }
     load(filePath) {
-        let data = JSON.parse(file.readText(filePath));
+        this.start(new WorldStream(filePath, this.worldOptions()));
+    }
+    worldOptions() {
+        // Only the platforms and coins near the camera are kept, the cells
+        // around it are read in the background.
+        return {
+            cellSize: 16, radius: 32, hysteresis: 8,
+            enter: (cell, data) => this.enter(cell, data),
+            leave: (cell) => this.leave(cell)
+        };
+    }
+    start(world) {
+        if (this.world) {
+            this.world.dispose();
+        }
+        this.cells = {};
+        this.entered = false;
         this.platforms = [];
         this.coins = [];
-        this.playerStart.xyz(data.player.position.x, data.player.position.y, 0);
+        this.world = world;
+        let start = this.world.data.player.position;
+        this.playerStart.xyz(start.x, start.y, 0);
         this.player.transform.localPosition = this.playerStart.copy();
-        for (let p of data.platforms) {
+    }
+    enter(cell, data) {
+        let objects = { platforms: [], coins: [] };
+        for (let p of data.platforms || []) {
             // Create platform and move to specified x, y.
             let platform = new platform_1.Platform(this, p.size.x, p.size.y, p.name, p.drawOrder);
             platform.transform.move(new $.Vector3(p.position.x, p.position.y, 0));
-            this.platforms.push(platform);
+            objects.platforms.push(platform);
         }
-        for (let c of data.coins) {
+        for (let c of data.coins || []) {
             // Create coin and move to specified x, y.
             let coin = new coin_1.Coin(this, c.name);
             coin.transform.move(new $.Vector3(c.position.x, c.position.y, 0));
-            this.coins.push(coin);
+            objects.coins.push(coin);
+        }
+        this.cells[cell.x + "," + cell.y] = objects;
+        this.entered = true;
+        this.collectObjects();
+    }
+    leave(cell) {
+        delete this.cells[cell.x + "," + cell.y];
+        this.collectObjects();
+    }
+    collectObjects() {
+        this.platforms = [];
+        this.coins = [];
+        for (let key in this.cells) {
+            this.platforms.push(...this.cells[key].platforms);
+            this.coins.push(...this.cells[key].coins);
         }
     }
     draw() {
@@ -95,6 +134,11 @@ class Level {
         this.spriteBatch.draw();
     }
     update(elapsedTime) {
+        this.world.update(this.camera.transform.localPosition.x, this.camera.transform.localPosition.y);
+        if (!this.entered) {
+            // Wait for the first cells so the player doesn't fall through.
+            return;
+        }
         this.player.update(elapsedTime);
         if (this.player.transform.localPosition.y < -10) {
             this.player.transform.localPosition = this.playerStart.copy();
@@ -47,11 +47,15 @@ export class Level {
     coins: Coin[] = [];
     sky: $.Sprite;
     clouds: $.Sprite;
+    world: WorldStream;
+    cells: { [cell: string]: { platforms: Platform[]; coins: Coin[]; } } = {};
+    entered = false;
 
     constructor(private context: GraphicsContext) {
         let fw = new FileWatcher("./content/level.json", () => {
-            // Reload level when the file changes.
-            this.load("./content/level.json");
+            // Reload level when the file changes, without blocking the game.
+            WorldStream.loadAsync("./content/level.json", this.worldOptions())
+                .then((world) => this.start(world));
         });
         this.camera = context.camera;
         this.spriteBatch = context.spriteBatch;
@@ -79,29 +83,67 @@ export class Level {
     }
 
     load(filePath: string) {
-        let data = JSON.parse(file.readText(filePath));
+        this.start(new WorldStream(filePath, this.worldOptions()));
+    }
+
+    worldOptions() {
+        // Only the platforms and coins near the camera are kept, the cells
+        // around it are read in the background.
+        return {
+            cellSize: 16, radius: 32, hysteresis: 8,
+            enter: (cell, data) => this.enter(cell, data),
+            leave: (cell) => this.leave(cell)
+        };
+    }
 
+    start(world: WorldStream) {
+        if (this.world) {
+            this.world.dispose();
+        }
+        this.cells = {};
+        this.entered = false;
         this.platforms = [];
         this.coins = [];
 
-        this.playerStart.xyz(
-            data.player.position.x, data.player.position.y, 0);
+        this.world = world;
+        let start = this.world.data.player.position;
+        this.playerStart.xyz(start.x, start.y, 0);
         this.player.transform.localPosition = this.playerStart.copy();
+    }
 
-        for (let p of data.platforms) {
+    enter(cell: { x: number; y: number; }, data: any) {
+        let objects = { platforms: <Platform[]>[], coins: <Coin[]>[] };
+        for (let p of data.platforms || []) {
             // Create platform and move to specified x, y.
             let platform = new Platform(
                 this, p.size.x, p.size.y, p.name, p.drawOrder);
             platform.transform.move(
                 new $.Vector3(p.position.x, p.position.y, 0));
-            this.platforms.push(platform);
+            objects.platforms.push(platform);
         }
-        for (let c of data.coins) {
+        for (let c of data.coins || []) {
             // Create coin and move to specified x, y.
             let coin = new Coin(this, c.name);
             coin.transform.move(
                 new $.Vector3(c.position.x, c.position.y, 0));
-            this.coins.push(coin);
+            objects.coins.push(coin);
+        }
+        this.cells[cell.x + "," + cell.y] = objects;
+        this.entered = true;
+        this.collectObjects();
+    }
+
+    leave(cell: { x: number; y: number; }) {
+        delete this.cells[cell.x + "," + cell.y];
+        this.collectObjects();
+    }
+
+    collectObjects() {
+        this.platforms = [];
+        this.coins = [];
+        for (let key in this.cells) {
+            this.platforms.push(...this.cells[key].platforms);
+            this.coins.push(...this.cells[key].coins);
         }
     }
 
@@ -119,6 +161,12 @@ export class Level {
     }
 
     update(elapsedTime: number) {
+        this.world.update(this.camera.transform.localPosition.x,
+            this.camera.transform.localPosition.y);
+        if (!this.entered) {
+            // Wait for the first cells so the player doesn't fall through.
+            return;
+        }
         this.player.update(elapsedTime);
         if (this.player.transform.localPosition.y < -10) {
             this.player.transform.localPosition = this.playerStart.copy();
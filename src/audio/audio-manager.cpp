@@ -23,6 +23,7 @@ SOFTWARE.*/
 #include <script/scripthelper.h>
 #include <script/script-engine.h>
 #include "audio-manager.h"
+#include "streaming-sound-source.h"
 
 using namespace v8;
 
@@ -38,6 +39,8 @@ AudioManager::AudioManager(v8::Isolate *isolate) : ScriptObjectWrap(isolate) {
 }
 
 AudioManager::~AudioManager() {
+    // The streaming thread uses the context until it has been stopped.
+    StreamingSoundSource::StopStreaming();
     auto device = alcGetContextsDevice(context_);
     alcMakeContextCurrent(NULL);
     alcDestroyContext(context_);
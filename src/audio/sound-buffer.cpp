@@ -23,34 +23,149 @@ SOFTWARE.*/
 #include <script/scripthelper.h>
 #include <script/script-engine.h>
 #include "sound-buffer.h"
+#include "voice-pool.h"
+#include <utils/virtual-file-system.h>
+#include <utils/cooked-formats.h>
 #include "stb_vorbis.c"
 
 using namespace v8;
 
-SoundBuffer::SoundBuffer(v8::Isolate *isolate, std::string filename) :
-        ScriptObjectWrap(isolate) {
+namespace {
+
+struct AsyncDecode {
+    std::string filename;
+    SoundBuffer::Samples samples;
+    std::string error;
+    Persistent<Promise::Resolver> resolver;
+};
+
+void ResolveDecode(Isolate* isolate, AsyncDecode* decode) {
+    HandleScope scope(isolate);
+    auto context = isolate->GetCurrentContext();
+    auto resolver = Local<Promise::Resolver>::New(isolate, decode->resolver);
+    decode->resolver.Reset();
+    if (decode->error.empty()) {
+        try {
+            // The AL buffer is created on the thread owning the context.
+            auto soundBuffer = new SoundBuffer(isolate, decode->samples);
+            decode->samples.data.reset();
+            resolver->Resolve(context, soundBuffer->v8Object()).FromMaybe(
+                    false);
+            return;
+        }
+        catch (std::exception& ex) {
+            decode->error = ex.what();
+        }
+    }
+    resolver->Reject(context, Exception::Error(String::NewFromUtf8(
+            isolate, decode->error.c_str()))).FromMaybe(false);
+}
+
+// Decodes the sound on the worker threads, the promise is resolved with the
+// buffer when polling events.
+void LoadAsync(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    auto isolate = args.GetIsolate();
+    HandleScope scope(isolate);
+    ScriptHelper helper(isolate);
+    Local<Promise::Resolver> resolver;
+    if (!Promise::Resolver::New(isolate->GetCurrentContext()).ToLocal(
+            &resolver)) {
+        return;
+    }
+    std::shared_ptr<AsyncDecode> decode(new AsyncDecode());
+    decode->filename = ScriptEngine::current().resolvePath(
+            helper.GetString(args[0]));
+    decode->resolver.Reset(isolate, resolver);
+    ScriptEngine::current().workerThreadPool().Post(
+        [decode] {
+            try {
+                decode->samples = SoundBuffer::Decode(decode->filename);
+            }
+            catch (std::exception& ex) {
+                decode->error = ex.what();
+            }
+        },
+        [isolate, decode] { ResolveDecode(isolate, decode.get()); });
+    args.GetReturnValue().Set(resolver->GetPromise());
+}
 
-    int channels, rate;
+}
+
+SoundBuffer::Samples SoundBuffer::Decode(std::string filename) {
+    Samples samples;
     short* output;
-    auto samples = stb_vorbis_decode_filename(
-        filename.c_str(), &channels, &rate, &output);
+    std::shared_ptr<VirtualFile> file(
+        VirtualFileSystem::current().Open(filename));
+    auto cooked = GetCookedHeader<CookedSoundHeader>(
+        file->data(), file->size(), CookedSoundMagic, CookedSoundVersion);
+    if (cooked)
+    {
+        if (cooked->count < 0 || cooked->channels < 1 ||
+            (file->size() - sizeof(*cooked)) / sizeof(short) <
+                static_cast<size_t>(cooked->count) * cooked->channels)
+        {
+            throw std::runtime_error(
+                "Cooked sound '" + filename + "' is truncated");
+        }
+        samples.channels = cooked->channels;
+        samples.rate = cooked->rate;
+        samples.count = cooked->count;
+        // The samples are used directly from the file, which is kept open.
+        samples.data = std::shared_ptr<short>(
+            file, reinterpret_cast<short*>(
+                const_cast<unsigned char*>(file->data()) + sizeof(*cooked)));
+        return samples;
+    }
+    samples.count = stb_vorbis_decode_memory(
+        file->data(), static_cast<int>(file->size()), &samples.channels,
+        &samples.rate, &output);
 
-    if (samples < 0)
+    if (samples.count < 0)
     {
         throw std::runtime_error("Failed to load sound '" + filename + "'");
     }
+    samples.data.reset(output, free);
+    return samples;
+}
+
+SoundBuffer::SoundBuffer(v8::Isolate *isolate, std::string filename) :
+        SoundBuffer(isolate, Decode(filename)) {
+}
+
+SoundBuffer::SoundBuffer(v8::Isolate *isolate, const Samples &samples) :
+        ScriptObjectWrap(isolate) {
+
     alGenBuffers((ALuint)1, &al_buffer_);
     auto format = AL_FORMAT_STEREO16;
-    if (channels == 1)
+    if (samples.channels == 1)
     {
         format = AL_FORMAT_MONO16;
     }
-    alBufferData(al_buffer_, format, output,
-                 static_cast<ALsizei>(samples*channels*sizeof(short)), rate);
+    auto size = samples.count * samples.channels * sizeof(short);
+    alBufferData(al_buffer_, format, samples.data.get(),
+                 static_cast<ALsizei>(size), samples.rate);
+    if (samples.rate > 0) {
+        duration_ = static_cast<double>(samples.count) / samples.rate;
+    }
+    SetExternalMemory(size);
 }
 
 SoundBuffer::~SoundBuffer() {
+    Dispose();
+}
+
+void SoundBuffer::Release() {
+    VoicePool::current().Detach(al_buffer_);
     alDeleteBuffers(1, &al_buffer_);
+    al_buffer_ = 0;
+}
+
+void SoundBuffer::InstallAsConstructor(
+        v8::Isolate* isolate, std::string name,
+        v8::Handle<v8::ObjectTemplate> objectTemplate) {
+
+    ScriptObjectWrap::InstallAsConstructor(isolate, name, objectTemplate);
+    SetConstructorFunction(isolate, "loadAsync", LoadAsync);
 }
 
 void SoundBuffer::New(const v8::FunctionCallbackInfo<v8::Value> &args) {
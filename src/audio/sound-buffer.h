@@ -26,22 +26,50 @@ SOFTWARE.*/
 #include <al/al.h>
 #include <al/alc.h>
 #include <script/script-object-wrap.h>
+#include <memory>
 #include <v8.h>
 
 class SoundBuffer : public ScriptObjectWrap<SoundBuffer> {
 
 public:
+    static const bool Disposable = true;
+
+    // Samples decoded from an Ogg Vorbis file, decoding can be done on any
+    // thread.
+    struct Samples {
+        int channels = 0;
+        int rate = 0;
+        int count = 0;
+        std::shared_ptr<short> data;
+    };
+
+    static Samples Decode(std::string filename);
+
     SoundBuffer(v8::Isolate *isolate, std::string filename);
+    SoundBuffer(v8::Isolate *isolate, const Samples &samples);
     virtual ~SoundBuffer();
 
     static void New(const v8::FunctionCallbackInfo<v8::Value> &args);
 
+    static void InstallAsConstructor(
+            v8::Isolate* isolate, std::string name,
+            v8::Handle<v8::ObjectTemplate> objectTemplate);
+
     ALuint al_buffer() const {
         return al_buffer_;
     }
 
+    // Length of the sound in seconds.
+    double duration() const {
+        return duration_;
+    }
+
+protected:
+    virtual void Release() override;
+
 private:
     ALuint al_buffer_;
+    double duration_ = 0;
 };
 
 #endif // GAMEPLAY_SOUNDBUFFER_H
@@ -22,53 +22,127 @@ SOFTWARE.*/
 
 #include "sound-source.h"
 #include "sound-buffer.h"
+#include "voice-pool.h"
 #include <script/script-engine.h>
 #include <script/scripthelper.h>
 
 using namespace v8;
 
+namespace {
+
+float Clamp(float value) {
+    if (value < 0) {
+        return 0;
+    }
+    if (value > 1) {
+        return 1;
+    }
+    return value;
+}
+
+// Plays the buffer once without creating a sound source, the voice is
+// released when it has finished playing.
+void PlayOneShot(const FunctionCallbackInfo<Value>& args) {
+    HandleScope scope(args.GetIsolate());
+    ScriptHelper helper(args.GetIsolate());
+    try {
+        auto soundBuffer = helper.GetObject<SoundBuffer>(args[0]);
+        if (!soundBuffer) {
+            throw std::runtime_error("Expected a sound buffer");
+        }
+        if (!soundBuffer->al_buffer()) {
+            throw std::runtime_error("Sound buffer has been disposed");
+        }
+        auto params = helper.GetObject(args[1]);
+        auto& voices = VoicePool::current();
+        auto voice = voices.Create(soundBuffer->al_buffer(),
+                                   soundBuffer->duration());
+        voice->oneShot = true;
+        voice->soundBuffer.Reset(args.GetIsolate(), soundBuffer->v8Object());
+        voice->volume = Clamp(helper.GetFloat(params, "volume", 1));
+        voice->pitch = helper.GetFloat(params, "pitch", 1);
+        voice->priority = helper.GetInteger(params, "priority", 0);
+        voice->positional = helper.GetValue(params, "x")->IsNumber() ||
+                            helper.GetValue(params, "y")->IsNumber();
+        voice->x = helper.GetFloat(params, "x", 0);
+        voice->y = helper.GetFloat(params, "y", 0);
+        voice->maxDistance = helper.GetFloat(params, "maxDistance", 0);
+        voices.Play(voice);
+    }
+    catch (std::exception& ex) {
+        ScriptEngine::current().ThrowTypeError(ex.what());
+    }
+}
+
+void SetListener(const FunctionCallbackInfo<Value>& args) {
+    HandleScope scope(args.GetIsolate());
+    VoicePool::current().SetListener(
+            static_cast<float>(args[0]->NumberValue()),
+            static_cast<float>(args[1]->NumberValue()));
+}
+
+}
+
 SoundSource::SoundSource(Isolate *isolate, SoundBuffer *soundBuffer) :
         ScriptObjectWrap(isolate) {
-    alGenSources((ALuint)1, &al_source_);
-    alSourcef(al_source_, AL_PITCH, 1);
-    alSourcef(al_source_, AL_GAIN, 1);
-    alSource3f(al_source_, AL_POSITION, 0, 0, 0);
-    alSource3f(al_source_, AL_VELOCITY, 0, 0, 0);
-    alSourcei(al_source_, AL_LOOPING, AL_FALSE);
-    alSourcei(al_source_, AL_BUFFER, soundBuffer->al_buffer());
+    voice_ = VoicePool::current().Create(soundBuffer->al_buffer(),
+                                         soundBuffer->duration());
+    voice_->soundBuffer.Reset(isolate, soundBuffer->v8Object());
 }
 
 SoundSource::~SoundSource() {
-    alDeleteSources(1, &al_source_);
+    VoicePool::current().Release(voice_);
 }
 
 void SoundSource::Pause() {
-    alSourcePause(al_source_);
+    VoicePool::current().Pause(voice_);
 }
 
 void SoundSource::Play() {
-    alSourcePlay(al_source_);
+    VoicePool::current().Play(voice_);
 }
 
 void SoundSource::Stop() {
-    alSourceStop(al_source_);
+    VoicePool::current().Stop(voice_);
 }
 
 SoundState SoundSource::GetState() {
-    ALenum state;
-    alGetSourcei(al_source_, AL_SOURCE_STATE, &state);
-    switch (state) {
-        case AL_INITIAL:
-            return SoundState::Initial;
-        case AL_PLAYING:
-            return SoundState::Playing;
-        case AL_PAUSED:
-            return SoundState::Paused;
-        case AL_STOPPED:
-            return SoundState::Stopped;
-        default:
-            return SoundState::Unknown;
-    }
+    return voice_->state;
+}
+
+float SoundSource::volume() {
+    return voice_->volume;
+}
+
+void SoundSource::volume(float value) {
+    voice_->volume = Clamp(value);
+    VoicePool::current().Apply(voice_);
+}
+
+bool SoundSource::loop() {
+    return voice_->loop;
+}
+
+void SoundSource::loop(bool value) {
+    voice_->loop = value;
+    VoicePool::current().Apply(voice_);
+}
+
+int SoundSource::priority() {
+    return voice_->priority;
+}
+
+void SoundSource::priority(int value) {
+    voice_->priority = value;
+}
+
+void SoundSource::InstallAsConstructor(
+        v8::Isolate* isolate, std::string name,
+        v8::Handle<v8::ObjectTemplate> objectTemplate) {
+
+    ScriptObjectWrap::InstallAsConstructor(isolate, name, objectTemplate);
+    SetConstructorFunction(isolate, "playOneShot", PlayOneShot);
+    SetConstructorFunction(isolate, "setListener", SetListener);
 }
 
 void SoundSource::Initialize() {
@@ -79,6 +153,7 @@ void SoundSource::Initialize() {
     SetAccessor("state", GetState, nullptr);
     SetAccessor("volume", GetVolume, SetVolume);
     SetAccessor("loop", GetLoop, SetLoop);
+    SetAccessor("priority", GetPriority, SetPriority);
 }
 
 void SoundSource::New(const FunctionCallbackInfo<Value> &args) {
@@ -86,6 +161,12 @@ void SoundSource::New(const FunctionCallbackInfo<Value> &args) {
     ScriptHelper helper(args.GetIsolate());
     try {
         auto soundBuffer = helper.GetObject<SoundBuffer>(args[0]);
+        if (!soundBuffer) {
+            throw std::runtime_error("Expected a sound buffer");
+        }
+        if (!soundBuffer->al_buffer()) {
+            throw std::runtime_error("Sound buffer has been disposed");
+        }
         auto soundSource = new SoundSource(args.GetIsolate(), soundBuffer);
         args.GetReturnValue().Set(soundSource->v8Object());
     }
@@ -175,4 +256,17 @@ void SoundSource::SetLoop(Local<String> name, Local<Value> value,
     info.GetReturnValue().Set(value);
 }
 
+void SoundSource::GetPriority(v8::Local<v8::String> name,
+                              const v8::PropertyCallbackInfo<v8::Value> &args) {
+    HandleScope scope(args.GetIsolate());
+    auto self = GetInternalObject(args.Holder());
+    args.GetReturnValue().Set(self->priority());
+}
 
+void SoundSource::SetPriority(Local<String> name, Local<Value> value,
+                              const PropertyCallbackInfo<void> &info) {
+    HandleScope scope(info.GetIsolate());
+    auto self = GetInternalObject(info.Holder());
+    self->priority(value->Int32Value());
+    info.GetReturnValue().Set(value);
+}
@@ -28,6 +28,7 @@ SOFTWARE.*/
 #include <v8.h>
 
 class SoundBuffer;
+struct Voice;
 
 enum class SoundState {
     Unknown,
@@ -37,6 +38,8 @@ enum class SoundState {
     Stopped
 };
 
+// A sound which can be played, paused and stopped. It only uses an AL source
+// from the voice pool while playing and audible.
 class SoundSource : public ScriptObjectWrap<SoundSource> {
 
 public:
@@ -44,36 +47,20 @@ public:
     virtual ~SoundSource();
 
     static void New(const v8::FunctionCallbackInfo<v8::Value> &args);
+    static void InstallAsConstructor(
+            v8::Isolate* isolate, std::string name,
+            v8::Handle<v8::ObjectTemplate> objectTemplate);
     void Pause();
     void Play();
     void Stop();
     SoundState GetState();
 
-    float volume() {
-        ALfloat value;
-        alGetSourcef(al_source_, AL_GAIN, &value);
-        return static_cast<float>(value);
-    }
-
-    void volume(float value) {
-        if (value < 0) {
-            value = 0;
-        }
-        else if (value > 1) {
-            value = 1;
-        }
-        alSourcef(al_source_, AL_GAIN, static_cast<ALfloat>(value));
-    }
-
-    bool loop() {
-        ALint value;
-        alGetSourcei(al_source_, AL_LOOPING, &value);
-        return static_cast<bool>(value);
-    }
-
-    void loop(bool value) {
-        alSourcei(al_source_, AL_LOOPING, static_cast<ALint>(value));
-    }
+    float volume();
+    void volume(float value);
+    bool loop();
+    void loop(bool value);
+    int priority();
+    void priority(int value);
 
 protected:
     void Initialize() override;
@@ -94,8 +81,13 @@ private:
     static void SetLoop(v8::Local<v8::String> name,
                         v8::Local<v8::Value> value,
                         const v8::PropertyCallbackInfo<void>& args);
+    static void GetPriority(v8::Local<v8::String> name,
+                            const v8::PropertyCallbackInfo<v8::Value>& args);
+    static void SetPriority(v8::Local<v8::String> name,
+                            v8::Local<v8::Value> value,
+                            const v8::PropertyCallbackInfo<void>& args);
 
-    ALuint al_source_;
+    Voice* voice_;
 };
 
 #endif //JSPLAY_SOUNDSOURCE_H
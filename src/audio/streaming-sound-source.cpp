@@ -0,0 +1,481 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "streaming-sound-source.h"
+#include <script/script-engine.h>
+#include <script/scripthelper.h>
+#include <utils/cooked-formats.h>
+#include <al/alc.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+#define STB_VORBIS_HEADER_ONLY
+#include "stb_vorbis.c"
+
+using namespace v8;
+
+namespace {
+
+// Keeps the queues of the streaming sources filled. The thread is started
+// when the first source is created and wakes up more often than a buffer
+// takes to play.
+class AudioStreamer {
+
+public:
+    static AudioStreamer& current() {
+        static AudioStreamer instance;
+        return instance;
+    }
+
+    void Add(StreamingSoundSource* source) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!thread_.joinable() && !stopping_) {
+            thread_ = std::thread(&AudioStreamer::Run, this);
+        }
+        sources_.push_back(source);
+    }
+
+    // The source is never used by the thread after it has been removed.
+    void Remove(StreamingSoundSource* source) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sources_.erase(std::remove(sources_.begin(), sources_.end(), source),
+                       sources_.end());
+    }
+
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        stopped_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+private:
+    AudioStreamer() { }
+
+    ~AudioStreamer() {
+        Stop();
+    }
+
+    void Run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            // Nothing can be played after the audio context is gone.
+            if (alcGetCurrentContext()) {
+                for (auto source : sources_) {
+                    source->Stream();
+                }
+            }
+            stopped_.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable stopped_;
+    std::vector<StreamingSoundSource*> sources_;
+    std::thread thread_;
+    bool stopping_ = false;
+};
+
+const char* GetStateName(SoundState state) {
+    switch (state) {
+        case SoundState::Initial: return "initial";
+        case SoundState::Playing: return "playing";
+        case SoundState::Paused: return "paused";
+        case SoundState::Stopped: return "stopped";
+        default: return "unknown";
+    }
+}
+
+}
+
+StreamingSoundSource::StreamingSoundSource(Isolate *isolate,
+                                           std::string filename) :
+        ScriptObjectWrap(isolate) {
+
+    // The file stays open (mapped) while the source exists, the decoder
+    // reads from it.
+    file_ = VirtualFileSystem::current().Open(filename);
+    auto cooked = GetCookedHeader<CookedSoundHeader>(
+            file_->data(), file_->size(), CookedSoundMagic,
+            CookedSoundVersion);
+    if (cooked) {
+        if (cooked->count < 0 || cooked->channels < 1 ||
+                (file_->size() - sizeof(*cooked)) / sizeof(short) <
+                static_cast<size_t>(cooked->count) * cooked->channels) {
+            throw std::runtime_error(
+                    "Cooked sound '" + filename + "' is truncated");
+        }
+        cooked_ = reinterpret_cast<const short*>(
+                file_->data() + sizeof(*cooked));
+        cookedChannels_ = cooked->channels;
+        channels_ = std::min(cooked->channels, 2);
+        rate_ = cooked->rate;
+        length_ = static_cast<unsigned int>(cooked->count);
+    }
+    else {
+        int error;
+        vorbis_ = stb_vorbis_open_memory(
+                file_->data(), static_cast<int>(file_->size()), &error,
+                nullptr);
+        if (!vorbis_) {
+            throw std::runtime_error(
+                    "Failed to open sound '" + filename + "'");
+        }
+        auto info = stb_vorbis_get_info(vorbis_);
+        channels_ = std::min(info.channels, 2);
+        rate_ = static_cast<int>(info.sample_rate);
+        length_ = stb_vorbis_stream_length_in_samples(vorbis_);
+    }
+    format_ = channels_ == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+    // Each buffer holds a quarter of a second.
+    samples_.resize(static_cast<size_t>(rate_ / 4) * channels_);
+
+    alGenSources(1, &al_source_);
+    alGenBuffers(BufferCount, al_buffers_);
+    alSourcef(al_source_, AL_PITCH, 1);
+    alSourcef(al_source_, AL_GAIN, 1);
+    alSource3f(al_source_, AL_POSITION, 0, 0, 0);
+    alSource3f(al_source_, AL_VELOCITY, 0, 0, 0);
+    // Looping is done by the decoder, the source would loop the queue.
+    alSourcei(al_source_, AL_LOOPING, AL_FALSE);
+    Refill();
+    SetExternalMemory(file_->size() + samples_.size() * sizeof(short) *
+                      (BufferCount + 1));
+    AudioStreamer::current().Add(this);
+}
+
+StreamingSoundSource::~StreamingSoundSource() {
+    Dispose();
+}
+
+void StreamingSoundSource::Release() {
+    AudioStreamer::current().Remove(this);
+    std::lock_guard<std::mutex> lock(mutex_);
+    alSourceStop(al_source_);
+    alDeleteSources(1, &al_source_);
+    alDeleteBuffers(BufferCount, al_buffers_);
+    al_source_ = 0;
+    if (vorbis_) {
+        stb_vorbis_close(vorbis_);
+    }
+    vorbis_ = nullptr;
+    cooked_ = nullptr;
+    file_.reset();
+}
+
+bool StreamingSoundSource::Fill(ALuint buffer) {
+    if (length_ == 0) {
+        return false;
+    }
+    auto start = decoded_;
+    auto capacity = static_cast<int>(samples_.size()) / channels_;
+    int frames = 0;
+    while (frames < capacity) {
+        auto read = Read(samples_.data() + frames * channels_,
+                         capacity - frames);
+        if (read == 0) {
+            if (!loop_) {
+                break;
+            }
+            // The start is decoded into the same buffer, so there is no gap
+            // when the sound loops.
+            Rewind(0);
+            continue;
+        }
+        frames += read;
+        decoded_ += read;
+    }
+    if (frames == 0) {
+        return false;
+    }
+    alBufferData(buffer, format_, samples_.data(),
+                 frames * channels_ * static_cast<ALsizei>(sizeof(short)),
+                 rate_);
+    alSourceQueueBuffers(al_source_, 1, &buffer);
+    queued_.push_back(start);
+    return true;
+}
+
+int StreamingSoundSource::Read(short* samples, int frames) {
+    if (!cooked_) {
+        return stb_vorbis_get_samples_short_interleaved(
+                vorbis_, channels_, samples, frames * channels_);
+    }
+    frames = std::min(frames, static_cast<int>(length_ - decoded_));
+    for (int i = 0; i < frames; i++) {
+        auto frame = cooked_ + (decoded_ + i) * cookedChannels_;
+        for (int c = 0; c < channels_; c++) {
+            samples[i * channels_ + c] = frame[c];
+        }
+    }
+    return frames;
+}
+
+void StreamingSoundSource::Rewind(unsigned int sample) {
+    if (vorbis_) {
+        stb_vorbis_seek(vorbis_, sample);
+    }
+    decoded_ = sample;
+}
+
+void StreamingSoundSource::Refill() {
+    alSourceStop(al_source_);
+    // Unqueues all buffers.
+    alSourcei(al_source_, AL_BUFFER, 0);
+    queued_.clear();
+    for (int i = 0; i < BufferCount; i++) {
+        if (!Fill(al_buffers_[i])) {
+            break;
+        }
+    }
+}
+
+void StreamingSoundSource::Stream() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!al_source_) {
+        return;
+    }
+    ALint processed;
+    alGetSourcei(al_source_, AL_BUFFERS_PROCESSED, &processed);
+    for (int i = 0; i < processed; i++) {
+        ALuint buffer;
+        alSourceUnqueueBuffers(al_source_, 1, &buffer);
+        queued_.pop_front();
+        Fill(buffer);
+    }
+    if (!playing_) {
+        return;
+    }
+    ALint state;
+    alGetSourcei(al_source_, AL_SOURCE_STATE, &state);
+    if (state != AL_PLAYING) {
+        if (queued_.empty()) {
+            // The whole file has been played.
+            playing_ = false;
+        }
+        else {
+            // The queue ran dry before it was filled again.
+            alSourcePlay(al_source_);
+        }
+    }
+}
+
+void StreamingSoundSource::Pause() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (playing_) {
+        paused_ = true;
+    }
+    playing_ = false;
+    alSourcePause(al_source_);
+}
+
+void StreamingSoundSource::Play() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queued_.empty()) {
+        // Played to the end, starts over.
+        Rewind(0);
+        Refill();
+    }
+    playing_ = true;
+    paused_ = false;
+    alSourcePlay(al_source_);
+}
+
+void StreamingSoundSource::Stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    playing_ = false;
+    paused_ = false;
+    Rewind(0);
+    Refill();
+}
+
+void StreamingSoundSource::Seek(double seconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto sample = static_cast<unsigned int>(std::max(0.0, seconds) * rate_);
+    if (length_ > 0) {
+        sample = std::min(sample, length_ - 1);
+    }
+    Rewind(sample);
+    Refill();
+    if (playing_) {
+        alSourcePlay(al_source_);
+    }
+}
+
+SoundState StreamingSoundSource::GetState() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (playing_) {
+        return SoundState::Playing;
+    }
+    // Refilling the queue stops the source.
+    if (paused_) {
+        return SoundState::Paused;
+    }
+    ALenum state;
+    alGetSourcei(al_source_, AL_SOURCE_STATE, &state);
+    switch (state) {
+        case AL_INITIAL:
+            return SoundState::Initial;
+        case AL_PAUSED:
+            return SoundState::Paused;
+        default:
+            return SoundState::Stopped;
+    }
+}
+
+double StreamingSoundSource::position() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queued_.empty() || length_ == 0) {
+        return 0;
+    }
+    // The offset is relative to the first queued buffer.
+    ALint offset;
+    alGetSourcei(al_source_, AL_SAMPLE_OFFSET, &offset);
+    auto sample = (queued_.front() + static_cast<unsigned int>(offset)) %
+                  length_;
+    return static_cast<double>(sample) / rate_;
+}
+
+double StreamingSoundSource::duration() {
+    return static_cast<double>(length_) / rate_;
+}
+
+float StreamingSoundSource::volume() {
+    ALfloat value;
+    alGetSourcef(al_source_, AL_GAIN, &value);
+    return static_cast<float>(value);
+}
+
+void StreamingSoundSource::volume(float value) {
+    value = std::max(0.0f, std::min(1.0f, value));
+    alSourcef(al_source_, AL_GAIN, static_cast<ALfloat>(value));
+}
+
+bool StreamingSoundSource::loop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return loop_;
+}
+
+void StreamingSoundSource::loop(bool value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    loop_ = value;
+}
+
+void StreamingSoundSource::StopStreaming() {
+    AudioStreamer::current().Stop();
+}
+
+void StreamingSoundSource::Initialize() {
+    ScriptObjectWrap::Initialize();
+    SetFunction("pause", Pause);
+    SetFunction("play", Play);
+    SetFunction("stop", Stop);
+    SetFunction("seek", Seek);
+    SetAccessor("state", GetState, nullptr);
+    SetAccessor("position", GetPosition, nullptr);
+    SetAccessor("duration", GetDuration, nullptr);
+    SetAccessor("volume", GetVolume, SetVolume);
+    SetAccessor("loop", GetLoop, SetLoop);
+}
+
+void StreamingSoundSource::New(const FunctionCallbackInfo<Value> &args) {
+    HandleScope scope(args.GetIsolate());
+    ScriptHelper helper(args.GetIsolate());
+    auto filename = ScriptEngine::current().resolvePath(
+            helper.GetString(args[0]));
+    try {
+        auto source = new StreamingSoundSource(args.GetIsolate(), filename);
+        args.GetReturnValue().Set(source->v8Object());
+    }
+    catch (std::exception& ex) {
+        ScriptEngine::current().ThrowTypeError(ex.what());
+    }
+}
+
+void StreamingSoundSource::Pause(const FunctionCallbackInfo<Value> &args) {
+    HandleScope scope(args.GetIsolate());
+    GetInternalObject(args.Holder())->Pause();
+}
+
+void StreamingSoundSource::Play(const FunctionCallbackInfo<Value> &args) {
+    HandleScope scope(args.GetIsolate());
+    GetInternalObject(args.Holder())->Play();
+}
+
+void StreamingSoundSource::Stop(const FunctionCallbackInfo<Value> &args) {
+    HandleScope scope(args.GetIsolate());
+    GetInternalObject(args.Holder())->Stop();
+}
+
+void StreamingSoundSource::Seek(const FunctionCallbackInfo<Value> &args) {
+    HandleScope scope(args.GetIsolate());
+    GetInternalObject(args.Holder())->Seek(args[0]->NumberValue());
+}
+
+void StreamingSoundSource::GetState(
+        Local<String> name, const PropertyCallbackInfo<Value> &args) {
+    HandleScope scope(args.GetIsolate());
+    auto self = GetInternalObject(args.Holder());
+    args.GetReturnValue().Set(String::NewFromUtf8(
+            args.GetIsolate(), GetStateName(self->GetState())));
+}
+
+void StreamingSoundSource::GetPosition(
+        Local<String> name, const PropertyCallbackInfo<Value> &args) {
+    auto self = GetInternalObject(args.Holder());
+    args.GetReturnValue().Set(self->position());
+}
+
+void StreamingSoundSource::GetDuration(
+        Local<String> name, const PropertyCallbackInfo<Value> &args) {
+    auto self = GetInternalObject(args.Holder());
+    args.GetReturnValue().Set(self->duration());
+}
+
+void StreamingSoundSource::GetVolume(
+        Local<String> name, const PropertyCallbackInfo<Value> &args) {
+    auto self = GetInternalObject(args.Holder());
+    args.GetReturnValue().Set(self->volume());
+}
+
+void StreamingSoundSource::SetVolume(Local<String> name, Local<Value> value,
+                                     const PropertyCallbackInfo<void> &info) {
+    auto self = GetInternalObject(info.Holder());
+    self->volume(static_cast<float>(value->NumberValue()));
+}
+
+void StreamingSoundSource::GetLoop(
+        Local<String> name, const PropertyCallbackInfo<Value> &args) {
+    auto self = GetInternalObject(args.Holder());
+    args.GetReturnValue().Set(self->loop());
+}
+
+void StreamingSoundSource::SetLoop(Local<String> name, Local<Value> value,
+                                   const PropertyCallbackInfo<void> &info) {
+    auto self = GetInternalObject(info.Holder());
+    self->loop(value->BooleanValue());
+}
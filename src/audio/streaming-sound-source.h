@@ -0,0 +1,140 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef GAMEPLAY_STREAMINGSOUNDSOURCE_H
+#define GAMEPLAY_STREAMINGSOUNDSOURCE_H
+
+#include <al/al.h>
+#include <script/script-object-wrap.h>
+#include <utils/virtual-file-system.h>
+#include <v8.h>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "sound-source.h"
+
+struct stb_vorbis;
+
+// Plays an Ogg Vorbis file (e.g. music) without decoding all of it. The file
+// is decoded a small part at a time on the audio streaming thread, into a
+// ring of buffers queued on the source. Short effects are better played from
+// a fully decoded SoundBuffer. Sounds decoded by gameplay-cook are streamed
+// from their samples.
+class StreamingSoundSource : public ScriptObjectWrap<StreamingSoundSource> {
+
+public:
+    static const bool Disposable = true;
+
+    StreamingSoundSource(v8::Isolate *isolate, std::string filename);
+    virtual ~StreamingSoundSource();
+
+    static void New(const v8::FunctionCallbackInfo<v8::Value> &args);
+    void Pause();
+    void Play();
+    void Stop();
+    void Seek(double seconds);
+    SoundState GetState();
+
+    // Decodes into the buffers which have been played and queues them again,
+    // called from the audio streaming thread.
+    void Stream();
+
+    // Playback position and length in seconds.
+    double position();
+    double duration();
+
+    float volume();
+    void volume(float value);
+
+    bool loop();
+    void loop(bool value);
+
+    // Stops the audio streaming thread, must be called before the audio
+    // context is destroyed.
+    static void StopStreaming();
+
+protected:
+    void Initialize() override;
+    void Release() override;
+
+private:
+    static void Pause(const v8::FunctionCallbackInfo<v8::Value> &args);
+    static void Play(const v8::FunctionCallbackInfo<v8::Value> &args);
+    static void Stop(const v8::FunctionCallbackInfo<v8::Value> &args);
+    static void Seek(const v8::FunctionCallbackInfo<v8::Value> &args);
+    static void GetState(v8::Local<v8::String> name,
+                         const v8::PropertyCallbackInfo<v8::Value>& args);
+    static void GetPosition(v8::Local<v8::String> name,
+                            const v8::PropertyCallbackInfo<v8::Value>& args);
+    static void GetDuration(v8::Local<v8::String> name,
+                            const v8::PropertyCallbackInfo<v8::Value>& args);
+    static void GetVolume(v8::Local<v8::String> name,
+                          const v8::PropertyCallbackInfo<v8::Value>& args);
+    static void SetVolume(v8::Local<v8::String> name,
+                          v8::Local<v8::Value> value,
+                          const v8::PropertyCallbackInfo<void>& args);
+    static void GetLoop(v8::Local<v8::String> name,
+                        const v8::PropertyCallbackInfo<v8::Value>& args);
+    static void SetLoop(v8::Local<v8::String> name,
+                        v8::Local<v8::Value> value,
+                        const v8::PropertyCallbackInfo<void>& args);
+
+    static const int BufferCount = 4;
+
+    // Decodes the next part of the file into the buffer and queues it,
+    // returns false at the end of the file.
+    bool Fill(ALuint buffer);
+    // Reads frames from the current position into the samples, returns the
+    // number of frames read.
+    int Read(short* samples, int frames);
+    // Moves the current position of the decoder.
+    void Rewind(unsigned int sample);
+    // Replaces the queued buffers with buffers from the current position.
+    void Refill();
+
+    std::unique_ptr<VirtualFile> file_;
+    stb_vorbis* vorbis_ = nullptr;
+    // The samples of a cooked sound, used instead of the decoder.
+    const short* cooked_ = nullptr;
+    int cookedChannels_ = 0;
+    ALuint al_source_ = 0;
+    ALuint al_buffers_[BufferCount];
+    ALenum format_;
+    int channels_;
+    int rate_;
+    unsigned int length_;
+    // The sample the next buffer starts at.
+    unsigned int decoded_ = 0;
+    // The samples the queued buffers starts at.
+    std::deque<unsigned int> queued_;
+    std::vector<short> samples_;
+    // The source should be playing, it's restarted if the queue ran dry.
+    bool playing_ = false;
+    // The source was paused, it stays paused when the queue is refilled.
+    bool paused_ = false;
+    bool loop_ = false;
+    // Guards the source and the decoder, used by the streaming thread.
+    std::mutex mutex_;
+};
+
+#endif // GAMEPLAY_STREAMINGSOUNDSOURCE_H
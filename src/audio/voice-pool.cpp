@@ -0,0 +1,290 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "voice-pool.h"
+#include <al/alc.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+// Voices quieter than this aren't given a source.
+const float MinAudibility = 0.001f;
+
+}
+
+VoicePool::~VoicePool() {
+    // The sources are gone with the audio context.
+    if (alcGetCurrentContext() && !sources_.empty()) {
+        alDeleteSources(static_cast<ALsizei>(sources_.size()),
+                        sources_.data());
+    }
+}
+
+Voice* VoicePool::Create(ALuint buffer, double duration) {
+    auto voice = new Voice();
+    voice->buffer = buffer;
+    voice->duration = duration;
+    voices_.push_back(std::unique_ptr<Voice>(voice));
+    return voice;
+}
+
+void VoicePool::Release(Voice* voice) {
+    Virtualize(voice);
+    voice->soundBuffer.Reset();
+    voices_.erase(std::remove_if(
+            voices_.begin(), voices_.end(),
+            [voice](const std::unique_ptr<Voice>& other) {
+                return other.get() == voice;
+            }), voices_.end());
+}
+
+void VoicePool::Detach(ALuint buffer) {
+    for (auto& voice : voices_) {
+        if (voice->buffer != buffer) {
+            continue;
+        }
+        Stop(voice.get());
+        voice->buffer = 0;
+        voice->duration = 0;
+    }
+}
+
+void VoicePool::Play(Voice* voice) {
+    // Playing a stopped or playing voice starts it from the beginning.
+    if (voice->state != SoundState::Paused) {
+        voice->position = 0;
+    }
+    voice->state = SoundState::Playing;
+    if (voice->source) {
+        alSourcePlay(voice->source);
+        return;
+    }
+    // A voice of a deleted buffer has nothing to play.
+    if (!voice->buffer) {
+        voice->state = SoundState::Stopped;
+        return;
+    }
+    if (Audibility(voice) < MinAudibility) {
+        return;
+    }
+    // When all sources are taken, a voice with lower priority may have to
+    // give up its source.
+    if (!Acquire(voice)) {
+        Assign();
+    }
+}
+
+void VoicePool::Pause(Voice* voice) {
+    if (voice->state != SoundState::Playing) {
+        return;
+    }
+    Virtualize(voice);
+    voice->state = SoundState::Paused;
+}
+
+void VoicePool::Stop(Voice* voice) {
+    Virtualize(voice);
+    voice->state = SoundState::Stopped;
+    voice->position = 0;
+}
+
+void VoicePool::Apply(Voice* voice) {
+    auto source = voice->source;
+    if (!source) {
+        return;
+    }
+    alSourcef(source, AL_GAIN, voice->volume);
+    alSourcef(source, AL_PITCH, voice->pitch);
+    alSourcei(source, AL_LOOPING, voice->loop ? AL_TRUE : AL_FALSE);
+    if (voice->positional) {
+        alSourcei(source, AL_SOURCE_RELATIVE, AL_FALSE);
+        alSource3f(source, AL_POSITION, voice->x, voice->y, 0);
+        alSourcef(source, AL_MAX_DISTANCE,
+                  voice->maxDistance > 0 ? voice->maxDistance : FLT_MAX);
+    }
+    else {
+        alSourcei(source, AL_SOURCE_RELATIVE, AL_TRUE);
+        alSource3f(source, AL_POSITION, 0, 0, 0);
+    }
+}
+
+void VoicePool::SetListener(float x, float y) {
+    listenerX_ = x;
+    listenerY_ = y;
+    if (alcGetCurrentContext()) {
+        alListener3f(AL_POSITION, x, y, 0);
+    }
+}
+
+void VoicePool::Update() {
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    if (updated_ != std::chrono::steady_clock::time_point()) {
+        elapsed = std::chrono::duration<double>(now - updated_).count();
+    }
+    updated_ = now;
+
+    for (auto& voice : voices_) {
+        if (voice->state != SoundState::Playing) {
+            continue;
+        }
+        if (voice->source) {
+            ALint state;
+            alGetSourcei(voice->source, AL_SOURCE_STATE, &state);
+            if (state == AL_STOPPED) {
+                Stop(voice.get());
+                continue;
+            }
+            ALfloat offset;
+            alGetSourcef(voice->source, AL_SEC_OFFSET, &offset);
+            voice->position = offset;
+            continue;
+        }
+        voice->position += elapsed * voice->pitch;
+        if (voice->position < voice->duration) {
+            continue;
+        }
+        if (voice->loop && voice->duration > 0) {
+            voice->position = std::fmod(voice->position, voice->duration);
+        }
+        else {
+            voice->state = SoundState::Stopped;
+            voice->position = 0;
+        }
+    }
+    voices_.erase(std::remove_if(
+            voices_.begin(), voices_.end(),
+            [](const std::unique_ptr<Voice>& voice) {
+                if (voice->oneShot && voice->state == SoundState::Stopped) {
+                    voice->soundBuffer.Reset();
+                    return true;
+                }
+                return false;
+            }), voices_.end());
+
+    // The listener or the voices may have moved since the last frame.
+    Assign();
+}
+
+void VoicePool::CreateSources() {
+    if (sourcesCreated_ || !alcGetCurrentContext()) {
+        return;
+    }
+    sourcesCreated_ = true;
+    // Attenuates positional voices to silence at their max distance.
+    alDistanceModel(AL_LINEAR_DISTANCE_CLAMPED);
+    for (int i = 0; i < SourceCount; i++) {
+        ALuint source;
+        alGetError();
+        alGenSources(1, &source);
+        // The device may support fewer sources.
+        if (alGetError() != AL_NO_ERROR) {
+            break;
+        }
+        alSourcef(source, AL_REFERENCE_DISTANCE, 0);
+        sources_.push_back(source);
+        free_.push_back(source);
+    }
+}
+
+float VoicePool::Audibility(const Voice* voice) {
+    if (voice->state != SoundState::Playing) {
+        return 0;
+    }
+    auto gain = voice->volume;
+    if (voice->positional && voice->maxDistance > 0) {
+        auto distance = std::hypot(voice->x - listenerX_,
+                                   voice->y - listenerY_);
+        if (distance >= voice->maxDistance) {
+            return 0;
+        }
+        gain *= 1 - distance / voice->maxDistance;
+    }
+    return gain;
+}
+
+bool VoicePool::Acquire(Voice* voice) {
+    CreateSources();
+    if (free_.empty()) {
+        return false;
+    }
+    voice->source = free_.back();
+    free_.pop_back();
+    alSourcei(voice->source, AL_BUFFER, voice->buffer);
+    Apply(voice);
+    // Continues from where the voice would have been if it had been playing
+    // all along.
+    alSourcef(voice->source, AL_SEC_OFFSET,
+              static_cast<ALfloat>(voice->position));
+    alSourcePlay(voice->source);
+    return true;
+}
+
+void VoicePool::Virtualize(Voice* voice) {
+    if (!voice->source) {
+        return;
+    }
+    ALfloat offset;
+    alGetSourcef(voice->source, AL_SEC_OFFSET, &offset);
+    voice->position = offset;
+    alSourceStop(voice->source);
+    alSourcei(voice->source, AL_BUFFER, 0);
+    free_.push_back(voice->source);
+    voice->source = 0;
+}
+
+void VoicePool::Assign() {
+    CreateSources();
+    std::vector<std::pair<float, Voice*>> audible;
+    for (auto& voice : voices_) {
+        auto audibility = Audibility(voice.get());
+        if (audibility >= MinAudibility) {
+            audible.push_back(std::make_pair(audibility, voice.get()));
+        }
+        else if (voice->state == SoundState::Playing) {
+            // Culled voices keep playing virtually.
+            Virtualize(voice.get());
+        }
+    }
+    std::stable_sort(audible.begin(), audible.end(),
+                     [](const std::pair<float, Voice*>& a,
+                        const std::pair<float, Voice*>& b) {
+        if (a.second->priority != b.second->priority) {
+            return a.second->priority > b.second->priority;
+        }
+        return a.first > b.first;
+    });
+    auto count = std::min(audible.size(), sources_.size());
+    // The least important voices give up their sources first, so they can
+    // be taken by the most important ones.
+    for (auto i = count; i < audible.size(); i++) {
+        Virtualize(audible[i].second);
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!audible[i].second->source) {
+            Acquire(audible[i].second);
+        }
+    }
+}
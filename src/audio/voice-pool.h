@@ -0,0 +1,115 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef GAMEPLAY_VOICEPOOL_H
+#define GAMEPLAY_VOICEPOOL_H
+
+#include <al/al.h>
+#include <v8.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "sound-source.h"
+
+// A sound played from a buffer. A voice is only given an AL source while it's
+// among the most important audible voices, otherwise it's virtual and just
+// keeps track of its playback position.
+struct Voice {
+    ALuint buffer = 0;
+    // Keeps the sound buffer from being collected while the voice uses it.
+    v8::Persistent<v8::Object> soundBuffer;
+    // Length of the buffer in seconds.
+    double duration = 0;
+    float volume = 1;
+    float pitch = 1;
+    bool loop = false;
+    // Voices with higher priority take the sources of lower ones.
+    int priority = 0;
+    // Positional voices are attenuated by the distance to the listener and
+    // culled beyond the max distance (when greater than zero).
+    bool positional = false;
+    float x = 0;
+    float y = 0;
+    float maxDistance = 0;
+    SoundState state = SoundState::Initial;
+    // Playback position in seconds.
+    double position = 0;
+    ALuint source = 0;
+    // One-shot voices are released when they stop playing.
+    bool oneShot = false;
+};
+
+// Shares a fixed number of AL sources between all voices, instead of each
+// sound holding on to its own source for its whole lifetime.
+class VoicePool {
+
+public:
+    // Maximum number of voices mixed at the same time.
+    static const int SourceCount = 32;
+
+    static VoicePool& current() {
+        static VoicePool instance;
+        return instance;
+    }
+
+    Voice* Create(ALuint buffer, double duration);
+    void Release(Voice* voice);
+
+    // Stops the voices playing the buffer, called before it's deleted.
+    void Detach(ALuint buffer);
+
+    void Play(Voice* voice);
+    void Pause(Voice* voice);
+    void Stop(Voice* voice);
+
+    // Applies changed properties of the voice to its source.
+    void Apply(Voice* voice);
+
+    void SetListener(float x, float y);
+
+    // Advances the virtual voices and gives the sources to the most important
+    // audible voices, called once each frame.
+    void Update();
+
+private:
+    VoicePool() { }
+    ~VoicePool();
+
+    VoicePool(VoicePool const& copy);
+    VoicePool& operator=(VoicePool const& copy);
+
+    void CreateSources();
+    float Audibility(const Voice* voice);
+    bool Acquire(Voice* voice);
+    void Virtualize(Voice* voice);
+    void Assign();
+
+    std::vector<std::unique_ptr<Voice>> voices_;
+    std::vector<ALuint> sources_;
+    std::vector<ALuint> free_;
+    bool sourcesCreated_ = false;
+    float listenerX_ = 0;
+    float listenerY_ = 0;
+    std::chrono::steady_clock::time_point updated_;
+};
+
+#endif // GAMEPLAY_VOICEPOOL_H
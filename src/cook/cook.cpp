@@ -0,0 +1,328 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+// Converts the files in a content directory into runtime-ready files, which
+// keep their names so the game runs unchanged from the output directory.
+// Images are decoded and mipmapped, short Ogg Vorbis sounds are decoded and
+// all other files (including music) are copied. A database of content hashes
+// in the output directory makes sure only changed files are converted again.
+
+#include <utils/cooked-formats.h>
+#include <utils/hash.h>
+#include <utils/memory-mapped-file.h>
+#include <utils/path-helper.h>
+#include <utils/virtual-file-system.h>
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include "stb_vorbis.c"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Increased when the output of a converter changes, all files are converted
+// again.
+const uint32_t CookVersion = 2;
+
+// Sounds longer than this (in seconds) are kept as Ogg Vorbis, they are
+// streamed (e.g. music) and would be many times larger decoded.
+const float StreamedSoundLength = 10;
+
+// Name of the database in the output directory, hidden files aren't packed.
+const char* DatabaseName = ".cook";
+
+typedef void (*Converter)(const unsigned char* data, size_t size,
+                          std::ofstream& output);
+
+void Write(std::ofstream& output, const void* data, size_t size) {
+    output.write(static_cast<const char*>(data),
+                 static_cast<std::streamsize>(size));
+}
+
+// Each level is the average of 2x2 pixels of the previous level, the last
+// row or column is repeated for odd sizes.
+std::vector<unsigned char> Downsample(const unsigned char* pixels, int width,
+                                      int height, int channels) {
+    auto levelWidth = width > 1 ? width / 2 : 1;
+    auto levelHeight = height > 1 ? height / 2 : 1;
+    std::vector<unsigned char> level(
+            static_cast<size_t>(levelWidth) * levelHeight * channels);
+    for (int y = 0; y < levelHeight; y++) {
+        auto y0 = std::min(y * 2, height - 1);
+        auto y1 = std::min(y * 2 + 1, height - 1);
+        for (int x = 0; x < levelWidth; x++) {
+            auto x0 = std::min(x * 2, width - 1);
+            auto x1 = std::min(x * 2 + 1, width - 1);
+            for (int c = 0; c < channels; c++) {
+                auto sum =
+                        pixels[(y0 * width + x0) * channels + c] +
+                        pixels[(y0 * width + x1) * channels + c] +
+                        pixels[(y1 * width + x0) * channels + c] +
+                        pixels[(y1 * width + x1) * channels + c];
+                level[(y * levelWidth + x) * channels + c] =
+                        static_cast<unsigned char>((sum + 2) / 4);
+            }
+        }
+    }
+    return level;
+}
+
+void ConvertImage(const unsigned char* data, size_t size,
+                  std::ofstream& output) {
+    CookedTextureHeader header {
+        CookedTextureMagic, CookedTextureVersion, 0, 0, 0, 1
+    };
+    auto pixels = stbi_load_from_memory(
+            data, static_cast<int>(size), &header.width, &header.height,
+            &header.channels, 0);
+    if (!pixels) {
+        throw std::runtime_error(stbi_failure_reason());
+    }
+    std::unique_ptr<unsigned char, void(*)(void*)> image(pixels,
+                                                        stbi_image_free);
+    auto width = header.width;
+    auto height = header.height;
+    while (width > 1 || height > 1) {
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+        header.levels++;
+    }
+    Write(output, &header, sizeof(header));
+
+    width = header.width;
+    height = header.height;
+    std::vector<unsigned char> level(
+            pixels, pixels + static_cast<size_t>(width) * height *
+                             header.channels);
+    for (int i = 0; i < header.levels; i++) {
+        Write(output, level.data(), level.size());
+        level = Downsample(level.data(), width, height, header.channels);
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+}
+
+void ConvertSound(const unsigned char* data, size_t size,
+                  std::ofstream& output) {
+    int error;
+    auto vorbis = stb_vorbis_open_memory(data, static_cast<int>(size),
+                                         &error, nullptr);
+    if (!vorbis) {
+        throw std::runtime_error("Failed to decode sound");
+    }
+    auto length = stb_vorbis_stream_length_in_samples(vorbis) /
+                  static_cast<float>(stb_vorbis_get_info(vorbis).sample_rate);
+    stb_vorbis_close(vorbis);
+    if (length > StreamedSoundLength) {
+        Write(output, data, size);
+        return;
+    }
+    CookedSoundHeader header { CookedSoundMagic, CookedSoundVersion };
+    short* samples;
+    header.count = stb_vorbis_decode_memory(
+            data, static_cast<int>(size), &header.channels, &header.rate,
+            &samples);
+    if (header.count < 0) {
+        throw std::runtime_error("Failed to decode sound");
+    }
+    Write(output, &header, sizeof(header));
+    Write(output, samples, static_cast<size_t>(header.count) *
+                           header.channels * sizeof(short));
+    free(samples);
+}
+
+void Copy(const unsigned char* data, size_t size, std::ofstream& output) {
+    Write(output, data, size);
+}
+
+Converter GetConverter(const std::string& name) {
+    if (PathHelper::FileNameEndsWith(name, ".png") ||
+            PathHelper::FileNameEndsWith(name, ".jpg") ||
+            PathHelper::FileNameEndsWith(name, ".tga") ||
+            PathHelper::FileNameEndsWith(name, ".bmp")) {
+        return ConvertImage;
+    }
+    if (PathHelper::FileNameEndsWith(name, ".ogg")) {
+        return ConvertSound;
+    }
+    return Copy;
+}
+
+// The content hash of each file when it was last converted.
+std::map<std::string, uint64_t> ReadDatabase(std::string filename) {
+    std::map<std::string, uint64_t> database;
+    std::ifstream file(filename);
+    std::string line;
+    while (std::getline(file, line)) {
+        auto separator = line.find(' ');
+        if (separator == std::string::npos) {
+            continue;
+        }
+        database[line.substr(separator + 1)] =
+                std::strtoull(line.substr(0, separator).c_str(), nullptr, 16);
+    }
+    return database;
+}
+
+void WriteDatabase(std::string filename,
+                   const std::map<std::string, uint64_t>& database) {
+    auto temporary = filename + ".tmp";
+    {
+        std::ofstream file(temporary);
+        for (auto& entry : database) {
+            file << Hash::ToHex(entry.second) << " " << entry.first << "\n";
+        }
+    }
+    std::remove(filename.c_str());
+    std::rename(temporary.c_str(), filename.c_str());
+}
+
+bool FileExists(std::string filename) {
+    std::ifstream file(filename);
+    return file.good();
+}
+
+int Cook(std::string input, std::string output, int jobs, bool force) {
+    auto files = VirtualFileSystem::ListFiles(input);
+    auto databaseFile = PathHelper::Append({output, DatabaseName});
+    auto previous = force ? std::map<std::string, uint64_t>() :
+                            ReadDatabase(databaseFile);
+
+    std::vector<uint64_t> keys(files.size());
+    std::atomic<size_t> next(0);
+    std::atomic<int> failed(0);
+    std::atomic<int> count(0);
+    std::mutex outputMutex;
+
+    // Each thread takes the next file until all files have been handled.
+    auto work = [&] {
+        for (auto i = next++; i < files.size(); i = next++) {
+            auto& name = files[i];
+            try {
+                MemoryMappedFile source(PathHelper::Append({input, name}));
+                auto key = Hash::Fnv1a(source.data(), source.size());
+                key = Hash::Fnv1a(&CookVersion, sizeof(CookVersion), key);
+                auto target = PathHelper::Append({output, name});
+                auto found = previous.find(name);
+                if (found != previous.end() && found->second == key &&
+                        FileExists(target)) {
+                    keys[i] = key;
+                    continue;
+                }
+                auto directory = target.substr(0, target.find_last_of('/'));
+                PathHelper::CreateDirectories(directory);
+                // Written to a temporary file first so a failed conversion
+                // never leaves a partial file behind.
+                auto temporary = target + ".tmp";
+                {
+                    std::ofstream file(temporary, std::ios::binary);
+                    if (!file) {
+                        throw std::runtime_error("Failed to create file");
+                    }
+                    GetConverter(name)(source.data(), source.size(), file);
+                    if (!file) {
+                        throw std::runtime_error("Failed to write file");
+                    }
+                }
+                std::remove(target.c_str());
+                std::rename(temporary.c_str(), target.c_str());
+                keys[i] = key;
+                count++;
+                std::lock_guard<std::mutex> lock(outputMutex);
+                std::cout << "Cooked " << name << std::endl;
+            }
+            catch (std::exception& error) {
+                failed++;
+                std::lock_guard<std::mutex> lock(outputMutex);
+                std::cout << "Failed to cook " << name << ": " <<
+                        error.what() << std::endl;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < jobs; i++) {
+        threads.push_back(std::thread(work));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Files which failed are left out of the database, they are converted
+    // again next time. Outputs of removed files are deleted.
+    std::map<std::string, uint64_t> database;
+    for (size_t i = 0; i < files.size(); i++) {
+        if (keys[i] != 0) {
+            database[files[i]] = keys[i];
+        }
+    }
+    for (auto& entry : previous) {
+        if (std::find(files.begin(), files.end(), entry.first) ==
+                files.end()) {
+            std::remove(PathHelper::Append({output, entry.first}).c_str());
+        }
+    }
+    PathHelper::CreateDirectories(output);
+    WriteDatabase(databaseFile, database);
+    std::cout << "Cooked " << count << " of " << files.size() <<
+            " files" << std::endl;
+    return failed > 0 ? 1 : 0;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<std::string> paths;
+    int jobs = std::max(1u, std::thread::hardware_concurrency());
+    bool force = false;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--jobs=", 7) == 0) {
+            jobs = std::max(1, atoi(argv[i] + 7));
+        } else if (strcmp(argv[i], "--force") == 0) {
+            force = true;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.size() != 2) {
+        std::cout << "Usage: gameplay-cook <content> <output> [--jobs=<n>] " <<
+                "[--force]" << std::endl;
+        return 1;
+    }
+    try {
+        return Cook(paths[0], paths[1], jobs, force);
+    }
+    catch (std::exception& error) {
+        std::cout << error.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,96 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "deletion-queue.h"
+
+void DeletionQueue::DeleteTexture(GLuint texture) {
+    Add(textures_, texture);
+}
+
+void DeletionQueue::DeleteBuffer(GLuint buffer) {
+    Add(buffers_, buffer);
+}
+
+void DeletionQueue::DeleteVertexArray(GLuint vertexArray) {
+    Add(vertexArrays_, vertexArray);
+}
+
+void DeletionQueue::DeleteFramebuffer(GLuint framebuffer) {
+    Add(framebuffers_, framebuffer);
+}
+
+void DeletionQueue::DeleteRenderbuffer(GLuint renderbuffer) {
+    Add(renderbuffers_, renderbuffer);
+}
+
+void DeletionQueue::DeleteProgram(GLuint program) {
+    Add(programs_, program);
+}
+
+std::vector<GLuint> DeletionQueue::Flush() {
+    std::vector<GLuint> textures, buffers, vertexArrays, framebuffers,
+            renderbuffers, programs;
+    {
+        // The queues are swapped out so objects can be queued from other
+        // threads while deleting.
+        std::lock_guard<std::mutex> lock(mutex_);
+        textures.swap(textures_);
+        buffers.swap(buffers_);
+        vertexArrays.swap(vertexArrays_);
+        framebuffers.swap(framebuffers_);
+        renderbuffers.swap(renderbuffers_);
+        programs.swap(programs_);
+    }
+    // Vertex arrays and framebuffers refers to buffers and textures, they are
+    // deleted first.
+    if (!vertexArrays.empty()) {
+        glDeleteVertexArrays(static_cast<GLsizei>(vertexArrays.size()),
+                             vertexArrays.data());
+    }
+    if (!framebuffers.empty()) {
+        glDeleteFramebuffers(static_cast<GLsizei>(framebuffers.size()),
+                             framebuffers.data());
+    }
+    if (!buffers.empty()) {
+        glDeleteBuffers(static_cast<GLsizei>(buffers.size()), buffers.data());
+    }
+    if (!renderbuffers.empty()) {
+        glDeleteRenderbuffers(static_cast<GLsizei>(renderbuffers.size()),
+                              renderbuffers.data());
+    }
+    if (!textures.empty()) {
+        glDeleteTextures(static_cast<GLsizei>(textures.size()),
+                         textures.data());
+    }
+    for (auto program : programs) {
+        glDeleteProgram(program);
+    }
+    return textures;
+}
+
+void DeletionQueue::Add(std::vector<GLuint>& queue, GLuint object) {
+    if (object == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue.push_back(object);
+}
@@ -0,0 +1,69 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef GAMEPLAY_DELETIONQUEUE_H
+#define GAMEPLAY_DELETIONQUEUE_H
+
+#include <gl/glew.h>
+#include <mutex>
+#include <vector>
+
+// GL objects are deleted through the queue, which is flushed after each frame
+// has been presented. Objects are mostly released by garbage collection, which
+// can happen in the middle of drawing or on a thread without the GL context.
+class DeletionQueue {
+
+public:
+    static DeletionQueue& current() {
+        static DeletionQueue instance;
+        return instance;
+    }
+
+    void DeleteTexture(GLuint texture);
+    void DeleteBuffer(GLuint buffer);
+    void DeleteVertexArray(GLuint vertexArray);
+    void DeleteFramebuffer(GLuint framebuffer);
+    void DeleteRenderbuffer(GLuint renderbuffer);
+    void DeleteProgram(GLuint program);
+
+    // Deletes the queued objects with a single call for each type of object.
+    // Returns the deleted textures, which are no longer bound to any texture
+    // unit. Must be called with the GL context current.
+    std::vector<GLuint> Flush();
+
+private:
+    DeletionQueue() { }
+    DeletionQueue(DeletionQueue const& copy);
+    DeletionQueue& operator=(DeletionQueue const& copy);
+
+    void Add(std::vector<GLuint>& queue, GLuint object);
+
+    std::mutex mutex_;
+    std::vector<GLuint> textures_;
+    std::vector<GLuint> buffers_;
+    std::vector<GLuint> vertexArrays_;
+    std::vector<GLuint> framebuffers_;
+    std::vector<GLuint> renderbuffers_;
+    std::vector<GLuint> programs_;
+};
+
+#endif // GAMEPLAY_DELETIONQUEUE_H
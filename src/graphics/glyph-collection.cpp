@@ -22,6 +22,8 @@ SOFTWARE.*/
 
 #include <script/scripthelper.h>
 #include <script/scriptobjecthelper.h>
+#include <script/script-engine.h>
+#include <utils/utf8.h>
 #include "texture-font.h"
 #include "glyph-collection.h"
 
@@ -37,7 +39,18 @@ void GetGlyphWithSymbol(Local<String> name,
 
     auto self = helper.GetObject<GlyphCollection>(info.Holder());
     auto str = helper.GetString(name);
-    auto glyph = (*self)[str[0]];
+    if (str.empty()) {
+        return;
+    }
+    size_t position = 0;
+    TextureFontGlyph glyph;
+    try {
+        glyph = (*self)[Utf8::Next(str, position)];
+    }
+    catch (std::exception& ex) {
+        ScriptEngine::current().ThrowTypeError(ex.what());
+        return;
+    }
 
     ScriptObjectHelper offset(info.GetIsolate());
     offset.SetInteger("x", glyph.offset.x);
@@ -57,6 +70,7 @@ void GetGlyphWithSymbol(Local<String> name,
     result.SetObject("offset", &offset);
     result.SetObject("advance", &advance);
     result.SetObject("source", &source);
+    result.SetInteger("page", glyph.page);
 
     info.GetReturnValue().Set(result.v8_object());
 }
@@ -71,6 +85,16 @@ void GetGlyphWithDigit(uint32_t index,
 }
 }
 
+TextureFontGlyph & GlyphCollection::operator[](uint32_t codepoint) {
+    if (font_->disposed()) {
+        throw std::runtime_error("Font has been disposed.");
+    }
+    auto& glyph = font_->GetGlyph(codepoint);
+    // The glyph is used by scripts directly, it needs to be in the texture.
+    font_->UploadPages();
+    return glyph;
+}
+
 void GlyphCollection::Initialize() {
     ScriptObjectWrap::Initialize();
     SetNamedPropertyHandler(GetGlyphWithSymbol, NULL);
@@ -24,23 +24,23 @@ SOFTWARE.*/
 #define JSPLAY_GLYPHCOLLECTION_H
 
 #include <script/script-object-wrap.h>
-#include <map>
+#include <stdint.h>
 
 struct TextureFontGlyph;
+class TextureFont;
 
 class GlyphCollection : public ScriptObjectWrap<GlyphCollection> {
 
 public:
-    GlyphCollection(v8::Isolate *isolate) : ScriptObjectWrap(isolate) { }
+    GlyphCollection(v8::Isolate *isolate, TextureFont *font) :
+            ScriptObjectWrap(isolate), font_(font) { }
 
-    TextureFontGlyph & operator[](const char glyphChar) {
-        return glyphs_[glyphChar];
-    }
+    TextureFontGlyph & operator[](uint32_t codepoint);
 
 private:
     virtual void Initialize() override;
 
-    std::map<char, TextureFontGlyph> glyphs_;
+    TextureFont *font_;
 };
 
 #endif // JSPLAY_GLYPHCOLLECTION_H
@@ -22,13 +22,15 @@ SOFTWARE.*/
 
 #include <script/scripthelper.h>
 #include <script/script-engine.h>
-#include <script/scriptobjecthelper.h>
+#include <script/script-binding.h>
 #include <iostream>
 #include "graphics-device.h"
+#include "deletion-queue.h"
 #include "window.h"
 #include "vertex-specification.h"
 #include "shader-program.h"
 #include "texture2d.h"
+#include "texture2d-array.h"
 
 using namespace v8;
 
@@ -55,150 +57,101 @@ void SetRenderTarget(const FunctionCallbackInfo<Value>& args) {
     }
 }
 
-void GetBlendState(Local<String> name,
-                   const PropertyCallbackInfo<Value> &args) {
-
-    HandleScope scope(args.GetIsolate());
-    ScriptHelper helper(args.GetIsolate());
-    auto graphics = helper.GetObject<GraphicsDevice>(args.Holder());
-
-    switch (graphics->blendState()) {
-        case BlendState::AlphaBlend:
-            args.GetReturnValue().Set(
-                String::NewFromUtf8(args.GetIsolate(), "alphaBlend"));
-            break;
-        case BlendState::Additive:
-            args.GetReturnValue().Set(
-                String::NewFromUtf8(args.GetIsolate(), "additive"));
-            break;
-        case BlendState::Opaque:
-            args.GetReturnValue().Set(
-                String::NewFromUtf8(args.GetIsolate(), "opaque"));
-            break;
-    }
+ScriptName IndexStartName("indexStart");
+ScriptName PrimitiveCountName("primitiveCount");
+ScriptName PrimitiveTypeName("primitiveType");
+ScriptName VertexStartName("vertexStart");
+ScriptName RedName("r");
+ScriptName GreenName("g");
+ScriptName BlueName("b");
+ScriptName AlphaName("a");
+
+constexpr ScriptEnumEntry<PrimitiveType> PrimitiveTypes[] = {
+    { "triangleList", PrimitiveType::TriangleList },
+    { "lineList", PrimitiveType::LineList },
+    { "pointList", PrimitiveType::PointList },
+};
+
+constexpr ScriptEnumEntry<BlendState> BlendStates[] = {
+    { "additive", BlendState::Additive },
+    { "alphaBlend", BlendState::AlphaBlend },
+    { "opaque", BlendState::Opaque },
+};
+
+constexpr ScriptEnumEntry<DepthState> DepthStates[] = {
+    { "default", DepthState::Default },
+    { "read", DepthState::Read },
+    { "none", DepthState::None },
+};
+
+constexpr ScriptEnumEntry<RasterizerState> RasterizerStates[] = {
+    { "cullNone", RasterizerState::CullNone },
+    { "cullClockwise", RasterizerState::CullClockwise },
+    { "cullCounterClockwise", RasterizerState::CullCounterClockwise },
+};
+
+constexpr ScriptEnumEntry<ClearType> ClearTypes[] = {
+    { "default", ClearType::Default },
+    { "color", ClearType::Color },
+    { "depth", ClearType::Depth },
+};
+
+typedef ScriptProperty<
+        decltype(&GraphicsDevice::blendState), &GraphicsDevice::blendState,
+        decltype(&GraphicsDevice::SetBlendState),
+        &GraphicsDevice::SetBlendState> BlendStateProperty;
+
+typedef ScriptProperty<
+        decltype(&GraphicsDevice::depthState), &GraphicsDevice::depthState,
+        decltype(&GraphicsDevice::SetDepthState),
+        &GraphicsDevice::SetDepthState> DepthStateProperty;
+
+typedef ScriptProperty<
+        decltype(&GraphicsDevice::rasterizerState),
+        &GraphicsDevice::rasterizerState,
+        decltype(&GraphicsDevice::SetRasterizerState),
+        &GraphicsDevice::SetRasterizerState> RasterizerStateProperty;
+
+typedef void (GraphicsDevice::*DrawFunction)(PrimitiveType, int, int);
+
+float GetNumber(Isolate* isolate, Local<Object> object, ScriptName& name) {
+    auto value = object->Get(name.Get(isolate));
+    if (!value->IsNumber()) {
+        return 0;
+    }
+    return static_cast<float>(value->NumberValue());
 }
 
-void SetBlendState(Local<String> name, Local<Value> value,
-                   const PropertyCallbackInfo<void> &args) {
-
-    HandleScope scope(args.GetIsolate());
-    ScriptHelper helper(args.GetIsolate());
-
-    auto state = helper.GetString(value);
-    if (state == "additive") {
-        helper.GetObject<GraphicsDevice>(args.Holder())->
-                SetBlendState(BlendState::Additive);
-    }
-    else if (state == "alphaBlend") {
-        helper.GetObject<GraphicsDevice>(args.Holder())->
-                SetBlendState(BlendState::AlphaBlend);
-    }
-    else if (state == "opaque") {
-        helper.GetObject<GraphicsDevice>(args.Holder())->
-                SetBlendState(BlendState::Opaque);
-    }
-    else {
-        ScriptEngine::current().ThrowTypeError(
-            "Couldn't set blend state to '" + state + "'.");
-    }
 }
 
-void GetDepthState(Local<String> name,
-                   const PropertyCallbackInfo<Value> &args) {
-
-    HandleScope scope(args.GetIsolate());
-    ScriptHelper helper(args.GetIsolate());
-    auto graphics = helper.GetObject<GraphicsDevice>(args.Holder());
-
-    switch (graphics->depthState()) {
-        case DepthState::Default:
-            args.GetReturnValue().Set(
-                String::NewFromUtf8(args.GetIsolate(), "default"));
-        break;
-        case DepthState::None:
-            args.GetReturnValue().Set(
-                String::NewFromUtf8(args.GetIsolate(), "none"));
-        break;
-        case DepthState::Read:
-            args.GetReturnValue().Set(
-                String::NewFromUtf8(args.GetIsolate(), "read"));
-        break;
-    }
+template <>
+ScriptEnum<PrimitiveType>& ScriptEnum<PrimitiveType>::Table() {
+    static ScriptEnum<PrimitiveType> table(PrimitiveTypes);
+    return table;
 }
 
-void SetDepthState(Local<String> name, Local<Value> value,
-                   const PropertyCallbackInfo<void> &args) {
-
-    HandleScope scope(args.GetIsolate());
-    ScriptHelper helper(args.GetIsolate());
-
-    auto state = helper.GetString(value);
-    if (state == "default") {
-        helper.GetObject<GraphicsDevice>(args.Holder())->
-                SetDepthState(DepthState::Default);
-    }
-    else if (state == "read") {
-        helper.GetObject<GraphicsDevice>(args.Holder())->
-                SetDepthState(DepthState::Read);
-    }
-    else if (state == "none") {
-        helper.GetObject<GraphicsDevice>(args.Holder())->
-                SetDepthState(DepthState::None);
-    }
-    else {
-        ScriptEngine::current().ThrowTypeError(
-                "Couldn't set depth state to '" + state + "'.");
-    }
+template <>
+ScriptEnum<BlendState>& ScriptEnum<BlendState>::Table() {
+    static ScriptEnum<BlendState> table(BlendStates);
+    return table;
 }
 
-void GetRasterizerState(Local<String> name,
-                        const PropertyCallbackInfo<Value> &args) {
-
-    HandleScope scope(args.GetIsolate());
-    ScriptHelper helper(args.GetIsolate());
-    auto graphics = helper.GetObject<GraphicsDevice>(args.Holder());
-
-    switch (graphics->rasterizerState()) {
-        case RasterizerState::CullNone:
-            args.GetReturnValue().Set(
-                String::NewFromUtf8(args.GetIsolate(), "cullNone"));
-        break;
-        case RasterizerState::CullCounterClockwise:
-            args.GetReturnValue().Set(
-                String::NewFromUtf8(args.GetIsolate(), "cullCounterClockwise"));
-        break;
-        case RasterizerState::CullClockwise:
-            args.GetReturnValue().Set(
-                String::NewFromUtf8(args.GetIsolate(), "cullClockwise"));
-        break;
-    }
+template <>
+ScriptEnum<DepthState>& ScriptEnum<DepthState>::Table() {
+    static ScriptEnum<DepthState> table(DepthStates);
+    return table;
 }
 
-void SetRasterizerState(Local<String> name, Local<Value> value,
-                        const PropertyCallbackInfo<void> &args) {
-
-    HandleScope scope(args.GetIsolate());
-    ScriptHelper helper(args.GetIsolate());
-
-    auto state = helper.GetString(value);
-    if (state == "cullNone") {
-        helper.GetObject<GraphicsDevice>(args.Holder())->
-                SetRasterizerState(RasterizerState::CullNone);
-    }
-    else if (state == "cullClockwise") {
-        helper.GetObject<GraphicsDevice>(args.Holder())->
-                SetRasterizerState(RasterizerState::CullClockwise);
-    }
-    else if (state == "cullCounterClockwise") {
-        helper.GetObject<GraphicsDevice>(args.Holder())->
-                SetRasterizerState(RasterizerState::CullCounterClockwise);
-    }
-    else {
-        ScriptEngine::current().ThrowTypeError(
-                "Couldn't set rasterizer state to '" + state + "'.");
-    }
+template <>
+ScriptEnum<RasterizerState>& ScriptEnum<RasterizerState>::Table() {
+    static ScriptEnum<RasterizerState> table(RasterizerStates);
+    return table;
 }
 
+template <>
+ScriptEnum<ClearType>& ScriptEnum<ClearType>::Table() {
+    static ScriptEnum<ClearType> table(ClearTypes);
+    return table;
 }
 
 GraphicsDevice::GraphicsDevice(Isolate *isolate, Window *window) :
@@ -276,7 +229,20 @@ void GraphicsDevice::DrawIndexedPrimitives(PrimitiveType primitiveType,
 }
 
 void GraphicsDevice::Present() {
+    auto& engine = ScriptEngine::current();
+    engine.FrameRendered();
     glfwSwapBuffers(window_->glfwWindow());
+    // GL forgets the binding of a deleted texture, the texture units are
+    // updated to match.
+    for (auto texture : DeletionQueue::current().Flush()) {
+        for (int i = 0; i < textures_.size(); i++) {
+            if (textures_[i].texture == texture) {
+                textures_[i].texture = 0;
+            }
+        }
+    }
+    engine.FramePresented(synchronizeWithVerticalRetrace_ ?
+                          window_->refreshInterval() : 0);
 }
 
 void GraphicsDevice::SetShaderProgram(ShaderProgram *shaderProgram) {
@@ -288,35 +254,36 @@ void GraphicsDevice::SetShaderProgram(ShaderProgram *shaderProgram) {
 
 void GraphicsDevice::SetSynchronizeWithVerticalRetrace(bool value) {
     glfwSwapInterval(value);
+    synchronizeWithVerticalRetrace_ = value;
 }
 
 void GraphicsDevice::SetTexture(int index, Texture2D* texture) {
-    if (textures_[index] == texture) {
-        return;
-    }
-    textures_[index] = texture;
-    switch (index) {
-        case 0:
-            glActiveTexture(GL_TEXTURE0);
-            break;
-        case 1:
-            glActiveTexture(GL_TEXTURE1);
-            break;
-        case 2:
-            glActiveTexture(GL_TEXTURE2);
-            break;
-        case 3:
-            glActiveTexture(GL_TEXTURE3);
-            break;
-        default:
-            throw std::runtime_error("Unknown texture unit");
+    SetTexture(index, GL_TEXTURE_2D,
+               texture == nullptr ? 0 : texture->glTexture());
+}
+
+void GraphicsDevice::SetTexture(int index, Texture2DArray* texture) {
+    SetTexture(index, GL_TEXTURE_2D_ARRAY,
+               texture == nullptr ? 0 : texture->glTexture());
+}
+
+void GraphicsDevice::SetTexture(int index, GLenum target, GLuint texture) {
+    if (index < 0 || index >= textures_.size()) {
+        throw std::runtime_error("Unknown texture unit");
     }
-    if (texture == nullptr) {
-        glBindTexture(GL_TEXTURE_2D, 0);
+    auto& unit = textures_[index];
+    if (unit.target == target && unit.texture == texture) {
+        return;
     }
-    else {
-        glBindTexture(GL_TEXTURE_2D, texture->glTexture());
+    glActiveTexture(GL_TEXTURE0 + index);
+    if (unit.target != target) {
+        // Unbind the previous texture, otherwise the texture unit would have
+        // textures bound to more than one target.
+        glBindTexture(unit.target, 0);
     }
+    glBindTexture(target, texture);
+    unit.target = target;
+    unit.texture = texture;
 }
 
 void GraphicsDevice::SetVertexSpecification(VertexSpecification *vertexSpec) {
@@ -412,65 +379,57 @@ void GraphicsDevice::Initialize() {
                 SetSynchronizeWithVerticalRetrace);
     SetFunction("setVertexSpecification", ::SetVertexSpecification);
     SetFunction("setRenderTarget", ::SetRenderTarget);
-    SetAccessor("blendState", ::GetBlendState, ::SetBlendState);
-    SetAccessor("depthState", ::GetDepthState, ::SetDepthState);
-    SetAccessor("rasterizerState", ::GetRasterizerState, ::SetRasterizerState);
+    SetAccessor("blendState", BlendStateProperty::Get,
+                BlendStateProperty::Set);
+    SetAccessor("depthState", DepthStateProperty::Get,
+                DepthStateProperty::Set);
+    SetAccessor("rasterizerState", RasterizerStateProperty::Get,
+                RasterizerStateProperty::Set);
 }
 
 void GraphicsDevice::Clear(const FunctionCallbackInfo<Value>& args) {
-    HandleScope scope(args.GetIsolate());
-    ScriptHelper helper(args.GetIsolate());
-
-    auto clearType = helper.GetString(args[0]);
-    ClearType type = ClearType::Default;
-
-    if (clearType == "color") {
-        type = ClearType::Color;
-    }
-    else if (clearType == "depth") {
-        type = ClearType::Depth;
-    }
+    auto isolate = args.GetIsolate();
+    HandleScope scope(isolate);
 
-    v8::Handle<v8::Object> color;
-    if (args[1]->IsObject()) {
-        color = args[1]->ToObject();
+    try {
+        auto type = ClearType::Default;
+        if (!args[0]->IsUndefined()) {
+            type = ScriptValue<ClearType>::From(isolate, args[0]);
+        }
+        float r = 0, g = 0, b = 0, a = 0;
+        if (args[1]->IsObject()) {
+            auto color = args[1]->ToObject();
+            r = GetNumber(isolate, color, RedName);
+            g = GetNumber(isolate, color, GreenName);
+            b = GetNumber(isolate, color, BlueName);
+            a = GetNumber(isolate, color, AlphaName);
+        }
+        GetInternalObject(args.Holder())->Clear(type, r, g, b, a);
     }
-    else {
-        color = v8::Object::New(args.GetIsolate());
+    catch (std::exception& ex) {
+        ScriptEngine::current().ThrowTypeError(ex.what());
     }
-
-    ScriptObjectHelper options(args.GetIsolate(), color);
-
-    auto r = options.GetFloat("r");
-    auto g = options.GetFloat("g");
-    auto b = options.GetFloat("b");
-    auto a = options.GetFloat("a");
-
-    GetInternalObject(args.Holder())->Clear(type, r, g, b, a);
 }
 
 void GraphicsDevice::DrawPrimitives(const FunctionCallbackInfo<Value> &args) {
-    HandleScope scope(args.GetIsolate());
-    ScriptObjectHelper options(args.GetIsolate(), args[0]->ToObject());
-
-    auto primitiveType = options.GetString("primitiveType");
-    auto vertexStart = options.GetInteger("vertexStart");
-    auto primitiveCount = options.GetInteger("primitiveCount");
-
-    PrimitiveType primitive;
-    if (primitiveType == "triangleList") {
-        primitive = PrimitiveType::TriangleList;
-    }
-    else if (primitiveType == "pointList") {
-        primitive = PrimitiveType::PointList;
-    }
-    else if (primitiveType == "lineList") {
-        primitive = PrimitiveType::LineList;
+    if (!args[0]->IsObject()) {
+        // drawPrimitives(primitiveType, vertexStart, primitiveCount)
+        ScriptMethod<DrawFunction, &GraphicsDevice::DrawPrimitives>::Call(args);
+        return;
     }
+    auto isolate = args.GetIsolate();
+    HandleScope scope(isolate);
+    auto options = args[0]->ToObject();
 
-    auto graphics = GetInternalObject(args.Holder());
     try {
-        graphics->DrawPrimitives(primitive, vertexStart, primitiveCount);
+        auto primitiveType = ScriptValue<PrimitiveType>::From(
+                isolate, options->Get(PrimitiveTypeName.Get(isolate)));
+        auto vertexStart =
+                options->Get(VertexStartName.Get(isolate))->Int32Value();
+        auto primitiveCount =
+                options->Get(PrimitiveCountName.Get(isolate))->Int32Value();
+        GetInternalObject(args.Holder())->DrawPrimitives(
+                primitiveType, vertexStart, primitiveCount);
     }
     catch (std::exception& ex) {
         ScriptEngine::current().ThrowTypeError(ex.what());
@@ -479,27 +438,25 @@ void GraphicsDevice::DrawPrimitives(const FunctionCallbackInfo<Value> &args) {
 
 void GraphicsDevice::DrawIndexedPrimitives(
         const FunctionCallbackInfo<Value> &args) {
-    HandleScope scope(args.GetIsolate());
-    ScriptObjectHelper options(args.GetIsolate(), args[0]->ToObject());
-
-    auto primitiveType = options.GetString("primitiveType");
-    auto indexStart = options.GetInteger("indexStart");
-    auto primitiveCount = options.GetInteger("primitiveCount");
-
-    PrimitiveType primitive;
-    if (primitiveType == "triangleList") {
-        primitive = PrimitiveType::TriangleList;
-    }
-    else if (primitiveType == "pointList") {
-        primitive = PrimitiveType::PointList;
-    }
-    else if (primitiveType == "lineList") {
-        primitive = PrimitiveType::LineList;
+    if (!args[0]->IsObject()) {
+        // drawIndexedPrimitives(primitiveType, indexStart, primitiveCount)
+        ScriptMethod<DrawFunction,
+                &GraphicsDevice::DrawIndexedPrimitives>::Call(args);
+        return;
     }
+    auto isolate = args.GetIsolate();
+    HandleScope scope(isolate);
+    auto options = args[0]->ToObject();
 
-    auto graphics = GetInternalObject(args.Holder());
     try {
-        graphics->DrawIndexedPrimitives(primitive, indexStart, primitiveCount);
+        auto primitiveType = ScriptValue<PrimitiveType>::From(
+                isolate, options->Get(PrimitiveTypeName.Get(isolate)));
+        auto indexStart =
+                options->Get(IndexStartName.Get(isolate))->Int32Value();
+        auto primitiveCount =
+                options->Get(PrimitiveCountName.Get(isolate))->Int32Value();
+        GetInternalObject(args.Holder())->DrawIndexedPrimitives(
+                primitiveType, indexStart, primitiveCount);
     }
     catch (std::exception& ex) {
         ScriptEngine::current().ThrowTypeError(ex.what());
@@ -66,6 +66,8 @@ enum class ClearType {
 class Window;
 class VertexSpecification;
 class ShaderProgram;
+class Texture2D;
+class Texture2DArray;
 
 class GraphicsDevice : public ScriptObjectWrap<GraphicsDevice> {
 
@@ -81,6 +83,7 @@ public:
     void SetShaderProgram(ShaderProgram *shaderProgram);
     void SetSynchronizeWithVerticalRetrace(bool value);
     void SetTexture(int index, Texture2D* texture);
+    void SetTexture(int index, Texture2DArray* texture);
     void SetVertexSpecification(VertexSpecification *vertexSpec);
     void SetRenderTarget(RenderTarget *renderTarget);
     void SetBlendState(BlendState state);
@@ -109,6 +112,7 @@ public:
 
 private:
     void Initialize() override;
+    void SetTexture(int index, GLenum target, GLuint texture);
     static void Clear(const v8::FunctionCallbackInfo<v8::Value>& args);
     static void DrawPrimitives(const v8::FunctionCallbackInfo<v8::Value> &args);
     static void DrawIndexedPrimitives(
@@ -123,6 +127,7 @@ private:
     VertexSpecification *vertexSpec_ = nullptr;
     ShaderProgram* shaderProgram_ = nullptr;
     Window* window_ = nullptr;
+    bool synchronizeWithVerticalRetrace_ = true;
     BlendState blendState_;
     DepthState depthState_;
     RasterizerState rasterizerState_;
@@ -21,6 +21,7 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.*/
 
 #include "render-target.h"
+#include "deletion-queue.h"
 #include "script/scripthelper.h"
 #include <script/script-engine.h>
 
@@ -86,11 +87,21 @@ RenderTarget::RenderTarget(Isolate* isolate, std::vector<Texture2D*> textures) :
     }
 
     glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(currentFrameBuffer));
+
+    // The color buffers are the textures, which are accounted for by
+    // themselves.
+    SetExternalMemory(textures[0]->width() * textures[0]->height() * 4);
 }
 
 RenderTarget::~RenderTarget() {
-    glDeleteRenderbuffers(1, &glDepthRenderBuffer_);
-    glDeleteFramebuffers(1, &glFramebuffer_);
+    Dispose();
+}
+
+void RenderTarget::Release() {
+    auto& queue = DeletionQueue::current();
+    queue.DeleteFramebuffer(glFramebuffer_);
+    queue.DeleteRenderbuffer(glDepthRenderBuffer_);
+    glDepthRenderBuffer_ = glFramebuffer_ = 0;
 }
 
 void RenderTarget::Initialize() {
@@ -32,6 +32,8 @@ SOFTWARE.*/
 class RenderTarget : public ScriptObjectWrap<RenderTarget> {
 
 public:
+    static const bool Disposable = true;
+
     RenderTarget(v8::Isolate* isolate, std::vector<Texture2D*> textures);
     ~RenderTarget();
 
@@ -43,6 +45,7 @@ public:
 
 protected:
     virtual void Initialize() override;
+    virtual void Release() override;
 
 private:
     GLuint glFramebuffer_;
@@ -22,6 +22,7 @@ SOFTWARE.*/
 
 #include <utils/file-reader.h>
 #include "shader-program.h"
+#include "deletion-queue.h"
 #include "graphics/window.h"
 #include "script/scripthelper.h"
 #include <script/script-engine.h>
@@ -51,7 +52,13 @@ ShaderProgram::ShaderProgram(Isolate* isolate, GraphicsDevice* graphicsDevice,
 }
 
 ShaderProgram::~ShaderProgram() {
-    glDeleteProgram(glProgram_);
+    Dispose();
+}
+
+void ShaderProgram::Release() {
+    DeletionQueue::current().DeleteProgram(glProgram_);
+    glProgram_ = 0;
+    uniforms_.clear();
 }
 
 void ShaderProgram::AttachShader(ShaderType shaderType, std::string source) {
@@ -60,16 +67,18 @@ void ShaderProgram::AttachShader(ShaderType shaderType, std::string source) {
 }
 
 int ShaderProgram::GetUniformLocation(std::string name) {
+    if (disposed()) {
+        throw std::runtime_error("Shader program has been disposed.");
+    }
     auto iterator = uniforms_.find(name);
     if (iterator == uniforms_.end()) {
+        // Uniforms which are not declared, or removed by the compiler since
+        // they are unused, are at -1 and setting them is ignored by OpenGL.
+        // This lets shared code set uniforms that a custom shader lacks.
         auto location = glGetUniformLocation(glProgram_, name.c_str());
-        if (location == -1) {
-            throw std::runtime_error(
-                    "Uniform value '" + name + "' does not exist");
-        }
-        uniforms_[name] = glGetUniformLocation(glProgram_, name.c_str());
+        iterator = uniforms_.insert(std::make_pair(name, location)).first;
     }
-    return static_cast<int>(uniforms_[name]);
+    return static_cast<int>(iterator->second);
 }
 
 void ShaderProgram::SetUniformFloat(std::string name, float value) {
@@ -35,6 +35,8 @@ class GraphicsDevice;
 class ShaderProgram : public ScriptObjectWrap<ShaderProgram> {
 
 public:
+    static const bool Disposable = true;
+
     ShaderProgram(v8::Isolate* isolate, GraphicsDevice* graphicsDevice,
                   std::string path);
     ~ShaderProgram();
@@ -53,6 +55,9 @@ public:
       return glProgram_;
     }
 
+protected:
+    virtual void Release() override;
+
 private:
     void AttachShader(ShaderType shaderType, std::string source);
     int GetUniformLocation(std::string name);
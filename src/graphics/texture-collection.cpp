@@ -1,12 +1,26 @@
 #include <script/scripthelper.h>
+#include <script/script-engine.h>
 #include "texture-collection.h"
+#include "texture2d-array.h"
 #include "graphics-device.h"
 
 using namespace v8;
 
+TextureCollection::TextureCollection(
+        v8::Isolate *isolate, GraphicsDevice *graphicsDevice_) :
+        ScriptObjectWrap(isolate), graphicsDevice_(graphicsDevice_) {
+
+    // This is the total number of texture units available to all shader
+    // stages combined, the fragment shader alone may have access to fewer.
+    GLint units;
+    glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &units);
+    units_.resize(static_cast<size_t>(units), TextureUnit { GL_TEXTURE_2D, 0 });
+}
+
 void TextureCollection::Initialize() {
     ScriptObjectWrap::Initialize();
     SetIndexedPropertyHandler(NULL, SetTexture);
+    SetAccessor("length", GetLength, NULL);
 }
 
 void TextureCollection::SetTexture(uint32_t index, Local<v8::Value> value,
@@ -14,12 +28,28 @@ void TextureCollection::SetTexture(uint32_t index, Local<v8::Value> value,
     HandleScope scope(info.GetIsolate());
     ScriptHelper helper(info.GetIsolate());
     auto self = GetInternalObject(info.Holder());
-    if (value->IsNull() || value->IsUndefined()) {
-        self->graphicsDevice_->SetTexture(index, nullptr);
+    try {
+        if (value->IsNull() || value->IsUndefined()) {
+            self->graphicsDevice_->SetTexture(index, (Texture2D*)nullptr);
+        }
+        else if (Texture2DArray::HasInstance(info.GetIsolate(), value)) {
+            auto texture = helper.GetObject<Texture2DArray>(value);
+            self->graphicsDevice_->SetTexture(index, texture);
+        }
+        else {
+            auto texture = helper.GetObject<Texture2D>(value);
+            self->graphicsDevice_->SetTexture(index, texture);
+        }
     }
-    else {
-        auto texture = helper.GetObject<Texture2D>(value);
-        self->graphicsDevice_->SetTexture(index, texture);
+    catch (std::exception& ex) {
+        ScriptEngine::current().ThrowTypeError(ex.what());
     }
     info.GetReturnValue().Set(value);
-}
\ No newline at end of file
+}
+
+void TextureCollection::GetLength(Local<String> name,
+                                  const PropertyCallbackInfo<Value>& info) {
+    HandleScope scope(info.GetIsolate());
+    auto self = GetInternalObject(info.Holder());
+    info.GetReturnValue().Set(self->size());
+}
@@ -23,20 +23,30 @@ SOFTWARE.*/
 #ifndef JSPLAY_TEXTURECOLLECTION_H
 #define JSPLAY_TEXTURECOLLECTION_H
 
+#include <gl/glew.h>
 #include <script/script-object-wrap.h>
-#include <array>
+#include <vector>
 
 class GraphicsDevice;
-class Texture2D;
+
+// The texture currently bound to a texture unit, a texture unit can only have
+// one texture bound regardless of the target (2D or 2D array).
+struct TextureUnit {
+    GLenum target;
+    GLuint texture;
+};
 
 class TextureCollection : public ScriptObjectWrap<TextureCollection> {
 
 public:
-    TextureCollection(v8::Isolate *isolate, GraphicsDevice *graphicsDevice_)
-            : ScriptObjectWrap(isolate), graphicsDevice_(graphicsDevice_) { }
+    TextureCollection(v8::Isolate *isolate, GraphicsDevice *graphicsDevice_);
+
+    TextureUnit& operator[](const int index) {
+        return units_[index];
+    }
 
-    Texture2D*& operator[](const int index) {
-        return textures_[index];
+    int size() {
+        return static_cast<int>(units_.size());
     }
 
 protected:
@@ -46,9 +56,11 @@ private:
     static void SetTexture(
             uint32_t index, v8::Local<v8::Value> value,
             const v8::PropertyCallbackInfo<v8::Value> &info);
+    static void GetLength(v8::Local<v8::String> name,
+                          const v8::PropertyCallbackInfo<v8::Value>& info);
 
     GraphicsDevice* graphicsDevice_;
-    std::array<Texture2D*, 4> textures_;
+    std::vector<TextureUnit> units_;
 };
 
 #endif // JSPLAY_TEXTURECOLLECTION_H
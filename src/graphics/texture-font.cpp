@@ -22,37 +22,264 @@ SOFTWARE.*/
 
 #include "texture-font.h"
 #include <script/script-engine.h>
-#include <array>
+#include <utils/utf8.h>
+#include <utils/hash.h>
+#include <utils/memory-mapped-file.h>
+#include <utils/virtual-file-system.h>
 #include "script/scripthelper.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <thread>
 
 using namespace v8;
 
+namespace {
+
+uint64_t GetGlyphKey(uint32_t codepoint, int size) {
+    return (static_cast<uint64_t>(size) << 32) | codepoint;
+}
+
+// Identifies atlas cache files, the version is increased when the format or
+// the way glyphs are rendered changes.
+const uint32_t AtlasMagic = 0x41545046;
+const uint32_t AtlasVersion = 1;
+
+struct AtlasHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    int32_t pageSize;
+    int32_t pageCount;
+    int32_t glyphCount;
+};
+
+struct AtlasGlyph {
+    uint32_t codepoint;
+    TextureFontGlyph glyph;
+};
+
+// Max number of threads used when rasterizing glyphs.
+const unsigned int MaxLoadThreads = 8;
+
+// Max number of cached layouts, all layouts are cleared when reached. Text
+// that changes every frame (e.g. counters) would otherwise fill up the cache.
+const size_t MaxLayouts = 256;
+
+// Copies the rows of the 8-bit bitmap into a tightly packed buffer, the
+// rows of the rendered bitmap can be padded (pitch).
+std::vector<unsigned char> ReadBitmap(const FT_Bitmap& bitmap) {
+    std::vector<unsigned char> result(bitmap.width * bitmap.rows);
+    for (unsigned int y = 0; y < bitmap.rows; y++) {
+        auto row = bitmap.buffer + y * bitmap.pitch;
+        std::copy(row, row + bitmap.width, result.begin() + y * bitmap.width);
+    }
+    return result;
+}
+
+// Creates a signed distance field from an 8-bit coverage bitmap. The result
+// is padded with spread pixels on each side. A value of 128 is on the edge of
+// the glyph, the distance is clamped to spread pixels inside and outside.
+std::vector<unsigned char> CreateDistanceField(
+        const std::vector<unsigned char>& bitmap, int width, int height,
+        int spread) {
+
+    auto w = width + spread * 2;
+    auto h = height + spread * 2;
+
+    std::vector<bool> inside(w * h, false);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            inside[(y + spread) * w + x + spread] =
+                    bitmap[y * width + x] >= 128;
+        }
+    }
+    std::vector<unsigned char> result(w * h);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            auto in = inside[y * w + x];
+            auto nearest = spread * spread;
+            // Search the surrounding pixels for the closest pixel on the
+            // other side of the edge.
+            for (int dy = std::max(-spread, -y);
+                 dy <= std::min(spread, h - 1 - y); dy++) {
+                for (int dx = std::max(-spread, -x);
+                     dx <= std::min(spread, w - 1 - x); dx++) {
+                    if (inside[(y + dy) * w + x + dx] != in) {
+                        nearest = std::min(nearest, dx * dx + dy * dy);
+                    }
+                }
+            }
+            // The edge is halfway between the two pixels.
+            auto distance = std::sqrt(static_cast<float>(nearest)) - 0.5f;
+            if (!in) {
+                distance = -distance;
+            }
+            auto value = 128.f + distance / spread * 127.f;
+            result[y * w + x] = static_cast<unsigned char>(
+                    std::min(255.f, std::max(0.f, value)));
+        }
+    }
+    return result;
+}
+
+// Renders the glyph of the code point and copies the bitmap. When spread is
+// greater than 0 the bitmap is converted to a distance field.
+TextureFontGlyph RasterizeGlyph(FT_Face face, uint32_t codepoint, int spread,
+                                std::vector<unsigned char> *bitmap) {
+    auto error = FT_Load_Char(face, codepoint, FT_LOAD_RENDER);
+    if (error) {
+        throw std::runtime_error("Failed to load font character");
+    }
+    TextureFontGlyph glyph;
+    glyph.offset.x = face->glyph->bitmap_left;
+    glyph.offset.y = face->glyph->bitmap_top;
+    glyph.source.x = 0;
+    glyph.source.y = 0;
+    glyph.source.w = face->glyph->bitmap.width;
+    glyph.source.h = face->glyph->bitmap.rows;
+    glyph.page = 0;
+    glyph.index = FT_Get_Char_Index(face, codepoint);
+    // We increment the pen position with the vector slot->advance, which
+    // correspond to the glyph's advance width (also known as its escapement).
+    // The advance vector is expressed in 1/64th of pixels, and is truncated to
+    // integer pixels on each iteration.
+    glyph.advance.x = (face->glyph->advance.x >> 6);
+    glyph.advance.y = (face->glyph->advance.y >> 6);
+
+    *bitmap = ReadBitmap(face->glyph->bitmap);
+    if (spread > 0 && glyph.source.w > 0 && glyph.source.h > 0) {
+        *bitmap = CreateDistanceField(
+                *bitmap, glyph.source.w, glyph.source.h, spread);
+        // The distance field is larger than the glyph bitmap, move the offset
+        // so the glyph is still positioned at the same place.
+        glyph.source.w += spread * 2;
+        glyph.source.h += spread * 2;
+        glyph.offset.x -= spread;
+        glyph.offset.y += spread;
+    }
+    return glyph;
+}
+
+std::vector<unsigned char> ReadFile(std::string filename) {
+    std::unique_ptr<VirtualFile> file;
+    try {
+        file = VirtualFileSystem::current().Open(filename);
+    }
+    catch (std::exception&) {
+        throw std::runtime_error("Failed to load font '" + filename + "'");
+    }
+    return std::vector<unsigned char>(file->data(),
+                                      file->data() + file->size());
+}
+
+// Copies the quads of a layout into a new script array.
+Local<Float32Array> CreateQuads(Isolate* isolate,
+                                const std::vector<float>& quads) {
+    auto buffer = ArrayBuffer::New(isolate, quads.size() * sizeof(float));
+    if (!quads.empty()) {
+        std::memcpy(buffer->GetContents().Data(), quads.data(),
+                    quads.size() * sizeof(float));
+    }
+    return Float32Array::New(buffer, 0, quads.size());
+}
+
+}
+
 TextureFont::TextureFont(v8::Isolate *isolate, std::string filename, int size,
-                       std::string chars) : ScriptObjectWrap(isolate),
-                                            glyphs_(isolate) {
+                         std::string chars, int pageSize, int maxPages,
+                         bool distanceField) :
+        ScriptObjectWrap(isolate), glyphs_(isolate, this), size_(size),
+        pageSize_(pageSize), maxPages_(maxPages),
+        distanceField_(distanceField) {
+
+    // The spread is the distance (in pixels) covered by the distance field
+    // on each side of the glyph edge, it's scaled with the glyph size to keep
+    // the same smoothness at different sizes.
+    spread_ = distanceField ? std::max(2, size / 8) : 0;
 
-    texture_ = new Texture2D(
-            isolate, 1024, 1024, GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE);
-    texture_->InstallAsObject("texture", this->v8Object());
     glyphs_.InstallAsObject("glyphs", this->v8Object());
+    v8Object()->Set(String::NewFromUtf8(isolate, "pages"),
+                    Array::New(isolate));
+    v8Object()->Set(String::NewFromUtf8(isolate, "size"),
+                    Integer::New(isolate, size));
+    v8Object()->Set(String::NewFromUtf8(isolate, "distanceField"),
+                    Boolean::New(isolate, distanceField));
 
-    FT_Library library;
-    auto error = FT_Init_FreeType(&library);
+    // The font file is kept in memory, it's used by the face and by the
+    // threads rasterizing glyphs.
+    fontData_ = ReadFile(filename);
+
+    auto error = FT_Init_FreeType(&library_);
     if (error) {
         throw std::runtime_error("Failed to initialize font library");
     }
-    error = FT_New_Face(library, filename.c_str(), 0, &face_);
+    error = FT_New_Memory_Face(library_, fontData_.data(),
+                               static_cast<FT_Long>(fontData_.size()), 0,
+                               &face_);
     if (error) {
+        FT_Done_FreeType(library_);
         throw std::runtime_error("Failed to load font '" + filename + "'");
     }
     FT_Set_Pixel_Sizes(face_, 0, size);
-    SetupGlyphs(chars);
-    FT_Done_Face(face_);
-    FT_Done_FreeType(library);
+    lineHeight_ = face_->size->metrics.height >> 6;
+    v8Object()->Set(String::NewFromUtf8(isolate, "lineHeight"),
+                    Integer::New(isolate, lineHeight_));
+
+    AddPage();
+    pages_[0].texture->InstallAsObject("texture", this->v8Object());
+
+    // The specified characters are loaded up front, all other characters
+    // are loaded when they are first used. The atlas with the preloaded
+    // characters is cached between runs.
+    auto key = Hash::Fnv1a(fontData_.data(), fontData_.size());
+    int options[] = { size, pageSize, maxPages, distanceField };
+    key = Hash::Fnv1a(options, sizeof(options), key);
+    key = Hash::Fnv1a(chars, key);
+    auto directory = PathHelper::Append(
+            {ScriptEngine::current().cachePath(), "fonts"});
+    auto cacheFile = PathHelper::Append(
+            {directory, Hash::ToHex(key) + ".atlas"});
+
+    if (!LoadAtlas(cacheFile, key)) {
+        LoadGlyphs(Utf8::Decode(chars));
+        PathHelper::CreateDirectories(directory);
+        SaveAtlas(cacheFile, key);
+    }
+    UploadPages();
 }
 
 TextureFont::~TextureFont() {
-    delete texture_;
+    Dispose();
+    // The textures are deleted when their script objects are collected.
+    for (auto& page: pages_) {
+        page.object.Reset();
+    }
+}
+
+void TextureFont::Release() {
+    ClearLayouts();
+    cache_.clear();
+    // The page textures are kept since they are referenced by the script
+    // object, only their resources are released.
+    for (auto& page: pages_) {
+        page.texture->Dispose();
+        page.pixels = std::vector<unsigned char>();
+        page.glyphs.clear();
+    }
+    FT_Done_Face(face_);
+    FT_Done_FreeType(library_);
+    fontData_ = std::vector<unsigned char>();
+}
+
+void TextureFont::UpdateExternalMemory() {
+    // The page textures report their own size, the font holds the font file
+    // and a copy of each page.
+    SetExternalMemory(static_cast<int64_t>(fontData_.size()) +
+            static_cast<int64_t>(pages_.size()) * pageSize_ * pageSize_);
 }
 
 void TextureFont::New(const v8::FunctionCallbackInfo<v8::Value>& args) {
@@ -66,9 +293,19 @@ void TextureFont::New(const v8::FunctionCallbackInfo<v8::Value>& args) {
     auto chars = helper.GetString(arg, "chars",
             "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ.,"
             "[0123456789] (!?&-+=*/:+%@)");
+    auto distanceField = helper.GetBoolean(arg, "distanceField", false);
+    // A distance field font is rendered at any size from a single atlas so
+    // it doesn't need as much space.
+    auto pageSize = helper.GetInteger(
+            arg, "pageSize", distanceField ? 512 : 1024);
+    auto maxPages = helper.GetInteger(arg, "maxPages", 4);
 
     try {
-        auto font = new TextureFont(args.GetIsolate(), filename, size, chars);
+        if (maxPages < 1) {
+            throw std::runtime_error("TextureFont: Must have at least 1 page.");
+        }
+        auto font = new TextureFont(args.GetIsolate(), filename, size, chars,
+                                    pageSize, maxPages, distanceField);
         args.GetReturnValue().Set(font->v8Object());
     }
     catch (std::exception& ex) {
@@ -76,110 +313,550 @@ void TextureFont::New(const v8::FunctionCallbackInfo<v8::Value>& args) {
     }
 }
 
-TextureFontGlyph TextureFont::LoadGlyph(char c) {
-    auto error = FT_Load_Char(face_, c, FT_LOAD_RENDER);
-    if (error) {
-        throw std::runtime_error("Failed to load font character");
+TextureFontGlyph& TextureFont::GetGlyph(uint32_t codepoint) {
+    auto key = GetGlyphKey(codepoint, size_);
+    auto iterator = cache_.find(key);
+    if (iterator == cache_.end()) {
+        std::vector<unsigned char> bitmap;
+        auto glyph = RasterizeGlyph(face_, codepoint, spread_, &bitmap);
+        return AddGlyph(codepoint, glyph, bitmap);
     }
-    TextureFontGlyph glyph;
-    glyph.offset.x = face_->glyph->bitmap_left;
-    glyph.offset.y = face_->glyph->bitmap_top;
-    glyph.source.w = face_->glyph->bitmap.width;
-    glyph.source.h = face_->glyph->bitmap.rows;
-    // We increment the pen position with the vector slot->advance, which
-    // correspond to the glyph's advance width (also known as its escapement).
-    // The advance vector is expressed in 1/64th of pixels, and is truncated to
-    // integer pixels on each iteration.
-    glyph.advance.x = (face_->glyph->advance.x >> 6);
-    glyph.advance.y = (face_->glyph->advance.y >> 6);
-    return glyph;
+    pages_[iterator->second.page].lastUsed = ++useCount_;
+    return iterator->second;
 }
 
-void TextureFont::SetupGlyphs(std::string chars) {
-    // Remember the current texture
-    GLint old_active_unit, old_texture;
-    glGetIntegerv(GL_ACTIVE_TEXTURE, &old_active_unit);
-    glActiveTexture(GL_TEXTURE0);
-    glGetIntegerv(GL_TEXTURE_BINDING_2D, &old_texture);
+TextureFontGlyph& TextureFont::AddGlyph(
+        uint32_t codepoint, TextureFontGlyph glyph,
+        const std::vector<unsigned char> &bitmap) {
+    auto key = GetGlyphKey(codepoint, size_);
+    glyph.page = currentPage_;
+    PlaceGlyph(&glyph, bitmap);
+    if (glyph.source.w > 0 && glyph.source.h > 0) {
+        // Glyphs without a bitmap (e.g. space) doesn't take up any space
+        // in the atlas and doesn't need to be removed when evicting.
+        pages_[glyph.page].glyphs.push_back(key);
+    }
+    auto& result = cache_[key] = glyph;
+    pages_[glyph.page].lastUsed = ++useCount_;
+    return result;
+}
 
-    glBindTexture(GL_TEXTURE_2D, texture_->glTexture());
-    // It is also very important to disable the default 4-byte alignment
-    // restrictions that OpenGL uses for uploading textures and other data.
-    // Normally you won't be affected by this restriction, as most textures have
-    // a width that is a multiple of 4, and/or use 4 bytes per pixel. The glyph
-    // images are in a 1-byte greyscale format though, and can have any possible
-    // width. To ensure there are no alignment restrictions, we have to use:
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+void TextureFont::LoadGlyphs(const std::vector<uint32_t> &codepoints) {
+    std::vector<uint32_t> missing;
+    for (auto codepoint: codepoints) {
+        if (cache_.find(GetGlyphKey(codepoint, size_)) == cache_.end() &&
+                std::find(missing.begin(), missing.end(), codepoint) ==
+                        missing.end()) {
+            missing.push_back(codepoint);
+        }
+    }
+    if (missing.empty()) {
+        return;
+    }
+    // FreeType faces can't be shared between threads, each thread creates
+    // its own face from the font data in memory.
+    auto threads = std::max(1u, std::min(MaxLoadThreads,
+            std::thread::hardware_concurrency()));
+    threads = std::min(threads, static_cast<unsigned int>(missing.size()));
+
+    std::vector<TextureFontGlyph> glyphs(missing.size());
+    std::vector<std::vector<unsigned char>> bitmaps(missing.size());
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            FT_Library library;
+            FT_Face face;
+            if (FT_Init_FreeType(&library)) {
+                errors[t] = std::make_exception_ptr(std::runtime_error(
+                        "Failed to initialize font library"));
+                return;
+            }
+            auto error = FT_New_Memory_Face(
+                    library, fontData_.data(),
+                    static_cast<FT_Long>(fontData_.size()), 0, &face);
+            if (error) {
+                FT_Done_FreeType(library);
+                errors[t] = std::make_exception_ptr(std::runtime_error(
+                        "Failed to load font"));
+                return;
+            }
+            FT_Set_Pixel_Sizes(face, 0, size_);
+            try {
+                for (auto i = t; i < missing.size(); i += threads) {
+                    glyphs[i] = RasterizeGlyph(
+                            face, missing[i], spread_, &bitmaps[i]);
+                }
+            }
+            catch (...) {
+                errors[t] = std::current_exception();
+            }
+            FT_Done_Face(face);
+            FT_Done_FreeType(library);
+        });
+    }
+    for (auto& worker: workers) {
+        worker.join();
+    }
+    for (auto& error: errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    // The glyphs are placed in the same order every time, which keeps the
+    // atlas the same between runs.
+    for (size_t i = 0; i < missing.size(); i++) {
+        AddGlyph(missing[i], glyphs[i], bitmaps[i]);
+    }
+}
+
+bool TextureFont::LoadAtlas(std::string filename, uint64_t key) {
+    try {
+        MemoryMappedFile file(filename);
+        auto data = file.data();
+        auto end = data + file.size();
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        // Reads the next value from the file and checks that the file is
+        // large enough, the file could have been truncated.
+        auto read = [&](void* value, size_t size) {
+            if (static_cast<size_t>(end - data) < size) {
+                throw std::runtime_error("Font atlas cache is truncated");
+            }
+            std::memcpy(value, data, size);
+            data += size;
+        };
+        AtlasHeader header;
+        read(&header, sizeof(header));
+        if (header.magic != AtlasMagic || header.version != AtlasVersion ||
+                header.key != key || header.pageSize != pageSize_ ||
+                header.pageCount < 1 || header.pageCount > maxPages_ ||
+                header.glyphCount < 0 || static_cast<size_t>(end - data) <
+                        header.glyphCount * sizeof(AtlasGlyph)) {
+            return false;
+        }
+        std::vector<AtlasGlyph> glyphs(header.glyphCount);
+        read(glyphs.data(), glyphs.size() * sizeof(AtlasGlyph));
 
-    int x = 0, y = 0;
-    for (auto c: chars) {
-        auto glyph = LoadGlyph(c);
-        PlaceGlyph(&glyph, x, y);
-        x = glyph.source.x + glyph.source.w + 1;
-        y = glyph.source.y;
-        glyphs_[c] = glyph;
+        std::vector<std::vector<SkylinePacker::Segment>> skylines;
+        std::vector<const unsigned char*> pixels;
+        for (int i = 0; i < header.pageCount; i++) {
+            uint32_t segments;
+            read(&segments, sizeof(segments));
+            if (static_cast<size_t>(end - data) <
+                    segments * sizeof(SkylinePacker::Segment)) {
+                return false;
+            }
+            skylines.emplace_back(segments);
+            read(skylines.back().data(),
+                 segments * sizeof(SkylinePacker::Segment));
+            // The pixels are copied directly from the mapped file.
+            auto size = static_cast<size_t>(pageSize_ * pageSize_);
+            if (static_cast<size_t>(end - data) < size) {
+                throw std::runtime_error("Font atlas cache is truncated");
+            }
+            pixels.push_back(data);
+            data += size;
+        }
+
+        for (auto& glyph: glyphs) {
+            if (glyph.glyph.page < 0 || glyph.glyph.page >= header.pageCount) {
+                return false;
+            }
+        }
+        // The whole file is valid, the atlas can be replaced.
+        while (static_cast<int>(pages_.size()) < header.pageCount) {
+            AddPage();
+        }
+        for (int i = 0; i < header.pageCount; i++) {
+            auto& page = pages_[i];
+            page.packer.SetSkyline(skylines[i]);
+            std::memcpy(page.pixels.data(), pixels[i], page.pixels.size());
+            page.changedTop = 0;
+            page.changedBottom = pageSize_;
+        }
+        for (auto& glyph: glyphs) {
+            auto glyphKey = GetGlyphKey(glyph.codepoint, size_);
+            if (glyph.glyph.source.w > 0 && glyph.glyph.source.h > 0) {
+                pages_[glyph.glyph.page].glyphs.push_back(glyphKey);
+            }
+            cache_[glyphKey] = glyph.glyph;
+        }
+        currentPage_ = header.pageCount - 1;
+        return true;
+    }
+    catch (std::exception&) {
+        // The atlas is created again when the cache is missing or broken.
+        return false;
     }
+}
 
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+void TextureFont::SaveAtlas(std::string filename, uint64_t key) {
+    std::vector<AtlasGlyph> glyphs;
+    for (auto& glyph: cache_) {
+        glyphs.push_back(AtlasGlyph {
+            static_cast<uint32_t>(glyph.first & 0xFFFFFFFF), glyph.second
+        });
+    }
+    AtlasHeader header {
+        AtlasMagic, AtlasVersion, key, pageSize_,
+        static_cast<int32_t>(pages_.size()),
+        static_cast<int32_t>(glyphs.size())
+    };
+    // The atlas is written to a temporary file first so a partially written
+    // file is never read.
+    auto temporary = filename + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        if (!file) {
+            return;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(glyphs.data()),
+                   glyphs.size() * sizeof(AtlasGlyph));
+        for (auto& page: pages_) {
+            auto& skyline = page.packer.skyline();
+            auto segments = static_cast<uint32_t>(skyline.size());
+            file.write(reinterpret_cast<const char*>(&segments),
+                       sizeof(segments));
+            file.write(reinterpret_cast<const char*>(skyline.data()),
+                       segments * sizeof(SkylinePacker::Segment));
+            file.write(reinterpret_cast<const char*>(page.pixels.data()),
+                       page.pixels.size());
+        }
+        if (!file) {
+            file.close();
+            std::remove(temporary.c_str());
+            return;
+        }
+    }
+    std::remove(filename.c_str());
+    std::rename(temporary.c_str(), filename.c_str());
+}
 
-    // Restore the previous texture
-    glBindTexture(GL_TEXTURE_2D, old_texture);
-    glActiveTexture(old_active_unit);
+int TextureFont::AddPage() {
+    HandleScope scope(v8Isolate());
+    // The glyphs only need a single channel, the swizzle makes the texture
+    // sample as white with the glyph coverage as alpha like an RGBA texture.
+    auto texture = new Texture2D(v8Isolate(), pageSize_, pageSize_, GL_R8,
+                                 GL_RED, GL_UNSIGNED_BYTE);
+    texture->SetSwizzle(GL_ONE, GL_ONE, GL_ONE, GL_RED);
+    auto index = static_cast<int>(pages_.size());
+    // The whole page is marked as changed to clear the texture.
+    pages_.push_back(TextureFontPage {
+        texture, SkylinePacker(pageSize_, pageSize_),
+        std::vector<unsigned char>(pageSize_ * pageSize_), 0, pageSize_, 0
+    });
+    pages_.back().object.Reset(v8Isolate(), texture->v8Object());
+
+    auto pages = Handle<Array>::Cast(
+            v8Object()->Get(String::NewFromUtf8(v8Isolate(), "pages")));
+    pages->Set(static_cast<uint32_t>(index), texture->v8Object());
+    UpdateExternalMemory();
+    return index;
 }
 
-void TextureFont::PlaceGlyph(TextureFontGlyph * glyph, int x, int y) {
-    if (glyph->source.h > maxGlyphHeight_) {
-        maxGlyphHeight_ = glyph->source.h;
+int TextureFont::EvictPage() {
+    int index = 0;
+    for (int i = 1; i < static_cast<int>(pages_.size()); i++) {
+        if (pages_[i].lastUsed < pages_[index].lastUsed) {
+            index = i;
+        }
     }
-    if (x + glyph->source.w > texture_->width()) {
-        x = 0;
-        y += maxGlyphHeight_;
-        maxGlyphHeight_ = glyph->source.h;
+    auto& page = pages_[index];
+    for (auto key: page.glyphs) {
+        cache_.erase(key);
     }
-    if (y + glyph->source.h > texture_->height()) {
+    page.glyphs.clear();
+    // Layouts may refer to the glyphs that were removed.
+    ClearLayouts();
+    evictions_++;
+    page.packer.Clear();
+    std::fill(page.pixels.begin(), page.pixels.end(), 0);
+    page.changedTop = 0;
+    page.changedBottom = pageSize_;
+    return index;
+}
+
+void TextureFont::PlaceGlyph(TextureFontGlyph * glyph,
+                             const std::vector<unsigned char>& bitmap) {
+    if (glyph->source.w == 0 || glyph->source.h == 0) {
+        return;
+    }
+    if (glyph->source.w > pageSize_ || glyph->source.h > pageSize_) {
         throw std::runtime_error(
-                "Could not fit all characters on font texture");
+                "Could not fit character on font texture");
+    }
+    int x, y;
+    auto page = &pages_[currentPage_];
+    if (!page->packer.Pack(glyph->source.w, glyph->source.h, &x, &y)) {
+        // The current page is full, the atlas grows with another page until
+        // the max number of pages has been reached. After that the least
+        // recently used page is cleared and reused.
+        if (static_cast<int>(pages_.size()) < maxPages_) {
+            currentPage_ = AddPage();
+        }
+        else {
+            currentPage_ = EvictPage();
+        }
+        page = &pages_[currentPage_];
+        if (!page->packer.Pack(glyph->source.w, glyph->source.h, &x, &y)) {
+            throw std::runtime_error(
+                    "Could not fit character on font texture");
+        }
     }
+    glyph->page = currentPage_;
     glyph->source.x = x;
     glyph->source.y = y;
-    auto bitmap = face_->glyph->bitmap;
 
-    // Convert 8-bit anti-aliased bitmap to RGBA
-    std::vector<unsigned char> rgba;
-    for (auto i = 0; i < bitmap.width * bitmap.rows; i++) {
-        rgba.push_back(255);
-        rgba.push_back(255);
-        rgba.push_back(255);
-        rgba.push_back(bitmap.buffer[i]);
+    // The glyph is copied to the page, the texture is updated later with all
+    // the glyphs placed since the last upload.
+    for (int row = 0; row < glyph->source.h; row++) {
+        std::copy(bitmap.begin() + row * glyph->source.w,
+                  bitmap.begin() + (row + 1) * glyph->source.w,
+                  page->pixels.begin() + (y + row) * pageSize_ + x);
     }
+    page->changedTop = std::min(page->changedTop, y);
+    page->changedBottom = std::max(page->changedBottom, y + glyph->source.h);
+}
 
-    glTexSubImage2D(GL_TEXTURE_2D, 0, (GLint)x, (GLint)y, bitmap.width,
-                    bitmap.rows, GL_RGBA, GL_UNSIGNED_BYTE, &rgba[0]);
+void TextureFont::UploadPages() {
+    GLint old_texture;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &old_texture);
+    // It is also very important to disable the default 4-byte alignment
+    // restrictions that OpenGL uses for uploading textures and other data.
+    // Normally you won't be affected by this restriction, as most textures have
+    // a width that is a multiple of 4, and/or use 4 bytes per pixel. The glyph
+    // images are in a 1-byte greyscale format though, and can have any possible
+    // width. To ensure there are no alignment restrictions, we have to use:
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (auto& page: pages_) {
+        if (page.changedTop >= page.changedBottom) {
+            continue;
+        }
+        // The changed rows are uploaded in a single call.
+        glBindTexture(GL_TEXTURE_2D, page.texture->glTexture());
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, page.changedTop, pageSize_,
+                        page.changedBottom - page.changedTop, GL_RED,
+                        GL_UNSIGNED_BYTE,
+                        &page.pixels[page.changedTop * pageSize_]);
+        page.changedTop = pageSize_;
+        page.changedBottom = 0;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, old_texture);
 }
 
 void TextureFont::Initialize() {
     ScriptObjectWrap::Initialize();
     SetFunction("measureString", MeasureString);
+    SetFunction("layout", Layout);
 }
 
 int TextureFont::MeasureString(std::string text) {
+    auto codepoints = Utf8::Decode(text);
+    return MeasureLine(codepoints.data(), codepoints.size());
+}
+
+int TextureFont::GetKerning(const TextureFontGlyph &left,
+                            const TextureFontGlyph &right) {
+    if (!FT_HAS_KERNING(face_)) {
+        return 0;
+    }
+    FT_Vector delta;
+    auto error = FT_Get_Kerning(
+            face_, left.index, right.index, FT_KERNING_DEFAULT, &delta);
+    if (error) {
+        return 0;
+    }
+    return delta.x >> 6;
+}
+
+int TextureFont::MeasureLine(const uint32_t *codepoints, size_t length) {
     int size = 0;
-    for (int i = 0; i < text.length(); i++) {
-        auto glyph = glyphs_[text.at(i)];
+    TextureFontGlyph previous;
+    for (size_t i = 0; i < length; i++) {
+        // The glyph is copied, the reference may not be valid after loading
+        // the next glyph.
+        auto glyph = GetGlyph(codepoints[i]);
+        if (i > 0) {
+            size += GetKerning(previous, glyph);
+        }
         size += glyph.advance.x;
+        previous = glyph;
     }
     return size;
 }
 
+std::vector<float> TextureFont::Layout(const std::string &text,
+                                       TextAlignment alignment, int maxWidth,
+                                       int lineHeight) {
+    auto codepoints = Utf8::Decode(text);
+
+    // Split the text into lines. A word is moved to the next line when it
+    // doesn't fit, spaces after a word are kept on the same line.
+    std::vector<std::vector<uint32_t>> lines(1);
+    size_t i = 0;
+    while (i < codepoints.size()) {
+        if (codepoints[i] == '\n') {
+            lines.emplace_back();
+            i++;
+            continue;
+        }
+        auto wordEnd = i;
+        while (wordEnd < codepoints.size() && codepoints[wordEnd] != ' ' &&
+               codepoints[wordEnd] != '\n') {
+            wordEnd++;
+        }
+        auto end = wordEnd;
+        while (end < codepoints.size() && codepoints[end] == ' ') {
+            end++;
+        }
+        if (maxWidth > 0 && !lines.back().empty()) {
+            auto line = lines.back();
+            line.insert(line.end(), codepoints.begin() + i,
+                        codepoints.begin() + wordEnd);
+            if (MeasureLine(line.data(), line.size()) > maxWidth) {
+                lines.emplace_back();
+            }
+        }
+        lines.back().insert(lines.back().end(), codepoints.begin() + i,
+                            codepoints.begin() + end);
+        i = end;
+    }
+
+    std::vector<float> quads;
+    for (size_t line = 0; line < lines.size(); line++) {
+        auto& chars = lines[line];
+        // Trailing spaces are not included when aligning the line.
+        auto length = chars.size();
+        while (length > 0 && chars[length - 1] == ' ') {
+            length--;
+        }
+        auto width = static_cast<float>(MeasureLine(chars.data(), length));
+        auto x = 0.f;
+        if (alignment == TextAlignment::Center) {
+            x = -width / 2;
+        }
+        else if (alignment == TextAlignment::Right) {
+            x = -width;
+        }
+        auto y = static_cast<float>(line * lineHeight);
+        TextureFontGlyph previous;
+        for (size_t j = 0; j < length; j++) {
+            auto glyph = GetGlyph(chars[j]);
+            if (j > 0) {
+                x += GetKerning(previous, glyph);
+            }
+            if (glyph.source.w > 0 && glyph.source.h > 0) {
+                auto size = static_cast<float>(pageSize_);
+                quads.insert(quads.end(), {
+                    x + glyph.offset.x,
+                    y - glyph.offset.y,
+                    static_cast<float>(glyph.source.w),
+                    static_cast<float>(glyph.source.h),
+                    glyph.source.x / size,
+                    glyph.source.y / size,
+                    (glyph.source.x + glyph.source.w) / size,
+                    (glyph.source.y + glyph.source.h) / size,
+                    static_cast<float>(glyph.page),
+                    static_cast<float>(glyph.advance.x)
+                });
+            }
+            x += glyph.advance.x;
+            previous = glyph;
+        }
+    }
+    return quads;
+}
+
+void TextureFont::ClearLayouts() {
+    layouts_.clear();
+}
+
 void TextureFont::MeasureString(
         const v8::FunctionCallbackInfo<v8::Value> &args) {
     HandleScope scope(args.GetIsolate());
     ScriptHelper helper(args.GetIsolate());
     auto self = GetInternalObject(args.Holder());
     auto text = helper.GetString(args[0]);
-    auto size = self->MeasureString(text);
-    args.GetReturnValue().Set(size);
+    try {
+        auto size = self->MeasureString(text);
+        args.GetReturnValue().Set(size);
+    }
+    catch (std::exception& ex) {
+        ScriptEngine::current().ThrowTypeError(ex.what());
+    }
+}
+
+void TextureFont::Layout(const v8::FunctionCallbackInfo<v8::Value> &args) {
+    HandleScope scope(args.GetIsolate());
+    ScriptHelper helper(args.GetIsolate());
+    auto self = GetInternalObject(args.Holder());
+    auto text = helper.GetString(args[0]);
+
+    auto align = std::string("left");
+    auto maxWidth = 0;
+    auto lineHeight = self->lineHeight_;
+    if (args[1]->IsObject()) {
+        auto options = args[1]->ToObject();
+        align = helper.GetString(options, "align", align);
+        maxWidth = helper.GetInteger(options, "maxWidth", maxWidth);
+        lineHeight = helper.GetInteger(options, "lineHeight", lineHeight);
+    }
+    auto key = text + '\0' + align + '\0' + std::to_string(maxWidth) +
+               '\0' + std::to_string(lineHeight);
+
+    auto iterator = self->layouts_.find(key);
+    if (iterator != self->layouts_.end()) {
+        // The glyphs are not requested from the atlas when the layout is
+        // cached, the pages still needs to be marked as used.
+        for (auto page: iterator->second.pages) {
+            self->pages_[page].lastUsed = ++self->useCount_;
+        }
+        self->UploadPages();
+        args.GetReturnValue().Set(
+                CreateQuads(args.GetIsolate(), iterator->second.quads));
+        return;
+    }
+    try {
+        TextAlignment alignment;
+        if (align == "left") {
+            alignment = TextAlignment::Left;
+        }
+        else if (align == "center") {
+            alignment = TextAlignment::Center;
+        }
+        else if (align == "right") {
+            alignment = TextAlignment::Right;
+        }
+        else {
+            throw std::runtime_error("Unknown text alignment '" + align + "'");
+        }
+        auto evictions = self->evictions_;
+        auto quads = self->Layout(text, alignment, maxWidth, lineHeight);
+        if (evictions != self->evictions_) {
+            // A page was evicted while loading the glyphs, glyphs positioned
+            // earlier may have been removed from the atlas.
+            quads = self->Layout(text, alignment, maxWidth, lineHeight);
+        }
+        if (self->layouts_.size() >= MaxLayouts) {
+            self->ClearLayouts();
+        }
+        auto& layout = self->layouts_[key];
+        // The page is stored at offset 8 of each quad.
+        for (size_t i = 8; i < quads.size(); i += LayoutStride) {
+            auto page = static_cast<int>(quads[i]);
+            if (std::find(layout.pages.begin(), layout.pages.end(), page) ==
+                    layout.pages.end()) {
+                layout.pages.push_back(page);
+            }
+        }
+        layout.quads = std::move(quads);
+        self->UploadPages();
+        args.GetReturnValue().Set(
+                CreateQuads(args.GetIsolate(), layout.quads));
+    }
+    catch (std::exception& ex) {
+        ScriptEngine::current().ThrowTypeError(ex.what());
+    }
 }
@@ -26,10 +26,13 @@ SOFTWARE.*/
 #include "texture2d.h"
 #include <map>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include "v8.h"
 #include "ft2build.h"
 #include FT_FREETYPE_H
 #include "glyph-collection.h"
+#include <utils/skyline-packer.h>
 
 struct TextureFontGlyph {
     struct Rectangle {
@@ -43,34 +46,122 @@ struct TextureFontGlyph {
         int y;
     } offset;
     Point advance;
+    // Index of the atlas page that contains the glyph.
+    int page;
+    // Index of the glyph in the font face, used for kerning.
+    FT_UInt index;
+};
+
+enum class TextAlignment {
+    Left,
+    Center,
+    Right
+};
+
+// A text layout reused by all calls with the same text and options until the
+// glyphs are moved in the atlas. Each call gets its own copy of the quads.
+struct TextureFontLayout {
+    std::vector<float> quads;
+    std::vector<int> pages;
+};
+
+// A single texture in the glyph atlas. The page is cleared and reused when
+// it's the least recently used page and the atlas can't grow anymore.
+struct TextureFontPage {
+    Texture2D* texture;
+    SkylinePacker packer;
+    // Copy of the texture, the rows between changedTop and changedBottom
+    // has not been uploaded yet.
+    std::vector<unsigned char> pixels;
+    int changedTop;
+    int changedBottom;
+    uint64_t lastUsed;
+    std::vector<uint64_t> glyphs;
+    // The texture is owned by its script object, which is kept alive while
+    // the font uses it.
+    v8::Persistent<v8::Object,
+                   v8::CopyablePersistentTraits<v8::Object>> object;
 };
 
 class TextureFont : public ScriptObjectWrap<TextureFont> {
 
 public:
-    TextureFont(v8::Isolate* isolate,
-               std::string filename, int size, std::string chars);
+    static const bool Disposable = true;
+
+    TextureFont(v8::Isolate* isolate, std::string filename, int size,
+                std::string chars, int pageSize, int maxPages,
+                bool distanceField);
     ~TextureFont();
 
     static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
     int MeasureString(std::string text);
 
+    // Positions the glyphs of the text and returns LayoutStride floats for
+    // each visible glyph: x, y, width, height (in pixels, y pointing down from
+    // the baseline of the first line), u0, v0, u1, v1, page and advance. Lines
+    // are broken at line breaks and at spaces when wider than maxWidth (when
+    // it's greater than 0).
+    std::vector<float> Layout(const std::string& text, TextAlignment alignment,
+                              int maxWidth, int lineHeight);
+
+    static const int LayoutStride = 10;
+
+    // Returns the glyph for the code point, the glyph is rasterized and added
+    // to the atlas the first time it's requested.
+    TextureFontGlyph& GetGlyph(uint32_t codepoint);
+
+    // Uploads the glyphs placed in the atlas since the last call, must be
+    // called before the pages are used for drawing.
+    void UploadPages();
+
     GlyphCollection* glyphs() { return &glyphs_; }
-    Texture2D* texture() { return texture_; }
+    Texture2D* texture() { return pages_[0].texture; }
+    bool distanceField() { return distanceField_; }
 
 protected:
     virtual void Initialize() override;
+    virtual void Release() override;
 
 private:
-    TextureFontGlyph LoadGlyph(char c);
-    void SetupGlyphs(std::string chars);
-    void PlaceGlyph(TextureFontGlyph * glyph, int x, int y);
+    TextureFontGlyph& AddGlyph(uint32_t codepoint, TextureFontGlyph glyph,
+                               const std::vector<unsigned char>& bitmap);
+    // Rasterizes the glyphs not already loaded on multiple threads.
+    void LoadGlyphs(const std::vector<uint32_t>& codepoints);
+    // Loads the atlas from the cache file, returns false if it doesn't exist
+    // or was created with a different font or options.
+    bool LoadAtlas(std::string filename, uint64_t key);
+    void SaveAtlas(std::string filename, uint64_t key);
+    void PlaceGlyph(TextureFontGlyph * glyph,
+                    const std::vector<unsigned char>& bitmap);
+    int AddPage();
+    int EvictPage();
+    int GetKerning(const TextureFontGlyph& left, const TextureFontGlyph& right);
+    int MeasureLine(const uint32_t* codepoints, size_t length);
+    void ClearLayouts();
+    void UpdateExternalMemory();
     static void MeasureString(const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void Layout(const v8::FunctionCallbackInfo<v8::Value>& args);
 
     GlyphCollection glyphs_;
-    Texture2D * texture_ = nullptr;
+    std::vector<unsigned char> fontData_;
+    FT_Library library_;
     FT_Face face_;
-    int maxGlyphHeight_ = 0;
+    int size_;
+    int pageSize_;
+    int maxPages_;
+    int lineHeight_;
+    // Increased every time a page is evicted and the glyphs on it are moved.
+    int evictions_ = 0;
+    // Glyphs are stored as signed distance fields instead of coverage.
+    bool distanceField_;
+    int spread_;
+    int currentPage_ = 0;
+    uint64_t useCount_ = 0;
+    std::vector<TextureFontPage> pages_;
+    // Glyphs are stored by both code point and size.
+    std::unordered_map<uint64_t, TextureFontGlyph> cache_;
+    // Layouts by text and options.
+    std::map<std::string, TextureFontLayout> layouts_;
 };
 
 #endif // JSPLAY_FONTTEXTURE_H
\ No newline at end of file
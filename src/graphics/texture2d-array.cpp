@@ -0,0 +1,322 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "texture2d-array.h"
+#include "deletion-queue.h"
+#include <script/script-engine.h>
+#include "script/scripthelper.h"
+#include "graphics/window.h"
+#include "graphics/texture2d.h"
+#include <vector>
+
+using namespace v8;
+
+namespace {
+
+void GetId(Local<String> name, const PropertyCallbackInfo<Value>& args) {
+    HandleScope scope(args.GetIsolate());
+    ScriptHelper helper(args.GetIsolate());
+    auto self = helper.GetObject<Texture2DArray>(args.Holder());
+    args.GetReturnValue().Set(self->glTexture());
+}
+
+void GetWidth(Local<String> name, const PropertyCallbackInfo<Value>& args) {
+    HandleScope scope(args.GetIsolate());
+    ScriptHelper helper(args.GetIsolate());
+    auto self = helper.GetObject<Texture2DArray>(args.Holder());
+    args.GetReturnValue().Set(self->width());
+}
+
+void GetHeight(Local<String> name, const PropertyCallbackInfo<Value>& args) {
+    HandleScope scope(args.GetIsolate());
+    ScriptHelper helper(args.GetIsolate());
+    auto self = helper.GetObject<Texture2DArray>(args.Holder());
+    args.GetReturnValue().Set(self->height());
+}
+
+void GetLayers(Local<String> name, const PropertyCallbackInfo<Value>& args) {
+    HandleScope scope(args.GetIsolate());
+    ScriptHelper helper(args.GetIsolate());
+    auto self = helper.GetObject<Texture2DArray>(args.Holder());
+    args.GetReturnValue().Set(self->layers());
+}
+
+void GetFilter(Local<String> name,
+               const PropertyCallbackInfo<Value> &args) {
+
+    HandleScope scope(args.GetIsolate());
+    ScriptHelper helper(args.GetIsolate());
+    auto texture = helper.GetObject<Texture2DArray>(args.Holder());
+
+    switch (texture->filter()) {
+        case TextureFilter::Linear:
+            args.GetReturnValue().Set(
+                    String::NewFromUtf8(args.GetIsolate(), "linear"));
+            break;
+        case TextureFilter::Nearest:
+            args.GetReturnValue().Set(
+                    String::NewFromUtf8(args.GetIsolate(), "nearest"));
+            break;
+    }
+}
+
+void SetFilter(Local<String> name, Local<Value> value,
+               const PropertyCallbackInfo<void> &args) {
+
+    HandleScope scope(args.GetIsolate());
+    ScriptHelper helper(args.GetIsolate());
+
+    auto texture = helper.GetObject<Texture2DArray>(args.Holder());
+    auto filter = helper.GetString(value);
+    if (filter == "linear") {
+        texture->SetFilter(TextureFilter::Linear);
+    }
+    else if (filter == "nearest") {
+        texture->SetFilter(TextureFilter::Nearest);
+    }
+    else {
+        ScriptEngine::current().ThrowTypeError(
+                "Unknown texture filter '" + filter + "'.");
+    }
+}
+
+void GetWrap(Local<String> name,
+             const PropertyCallbackInfo<Value> &args) {
+
+    HandleScope scope(args.GetIsolate());
+    ScriptHelper helper(args.GetIsolate());
+    auto texture = helper.GetObject<Texture2DArray>(args.Holder());
+
+    switch (texture->wrap()) {
+        case TextureWrap::Repeat:
+            args.GetReturnValue().Set(
+                String::NewFromUtf8(args.GetIsolate(), "repeat"));
+            break;
+        case TextureWrap::ClampToEdge:
+            args.GetReturnValue().Set(
+                String::NewFromUtf8(args.GetIsolate(), "clampToEdge"));
+            break;
+    }
+}
+
+void SetWrap(Local<String> name, Local<Value> value,
+             const PropertyCallbackInfo<void>& args) {
+
+    HandleScope scope(args.GetIsolate());
+    ScriptHelper helper(args.GetIsolate());
+
+    auto texture = helper.GetObject<Texture2DArray>(args.Holder());
+    auto wrap = helper.GetString(value);
+    if (wrap == "repeat") {
+        texture->SetWrap(TextureWrap::Repeat);
+    }
+    else if (wrap == "clampToEdge") {
+        texture->SetWrap(TextureWrap::ClampToEdge);
+    }
+    else {
+        ScriptEngine::current().ThrowTypeError(
+            "Unknown texture wrap '" + wrap + "'.");
+    }
+}
+
+// Expands the first mip level of the image to RGBA the same way stb_image
+// converts when loading, gray is copied to all color channels.
+std::vector<unsigned char> ToRgba(const Texture2D::Image& image) {
+    auto count = static_cast<size_t>(image.width) * image.height;
+    auto in = image.pixels.get();
+    std::vector<unsigned char> rgba(count * 4);
+    for (size_t i = 0; i < count; i++, in += image.channels) {
+        auto out = &rgba[i * 4];
+        switch (image.channels) {
+            case 1:
+            case 2:
+                out[0] = out[1] = out[2] = in[0];
+                out[3] = image.channels == 2 ? in[1] : 255;
+                break;
+            default:
+                out[0] = in[0];
+                out[1] = in[1];
+                out[2] = in[2];
+                out[3] = image.channels == 4 ? in[3] : 255;
+                break;
+        }
+    }
+    return rgba;
+}
+
+}
+
+Texture2DArray::Texture2DArray(Isolate* isolate,
+                               std::vector<std::string> filenames) :
+        ScriptObjectWrap(isolate) {
+
+    Window::EnsureCurrentContext();
+
+    if (filenames.size() == 0) {
+        throw std::runtime_error(
+                "Texture2DArray: Must be created with at least one image.");
+    }
+    GLint maxLayers;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    if (filenames.size() > static_cast<size_t>(maxLayers)) {
+        throw std::runtime_error(
+                "Texture2DArray: Can't be created with more than " +
+                std::to_string(maxLayers) + " images.");
+    }
+
+    GLint old_texture;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &old_texture);
+
+    glGenTextures(1, &glTexture_);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, glTexture_);
+
+    SetFilter(TextureFilter::Linear);
+    SetWrap(TextureWrap::Repeat);
+
+    layers_ = static_cast<int>(filenames.size());
+
+    for (int i = 0; i < layers_; i++) {
+        // All the images are converted to RGBA, layers can't have different
+        // formats. They are decoded like 2D textures, so cooked images can be
+        // used as well.
+        Texture2D::Image image;
+        try {
+            image = Texture2D::Decode(filenames[i]);
+        }
+        catch (std::exception&) {
+            glBindTexture(GL_TEXTURE_2D_ARRAY, old_texture);
+            glDeleteTextures(1, &glTexture_);
+            throw;
+        }
+        auto width = image.width;
+        auto height = image.height;
+        if (i == 0) {
+            width_ = width;
+            height_ = height;
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, width_, height_,
+                         layers_, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+        }
+        else if (width != width_ || height != height_) {
+            glBindTexture(GL_TEXTURE_2D_ARRAY, old_texture);
+            glDeleteTextures(1, &glTexture_);
+            throw std::runtime_error(
+                    "Texture2DArray: Image '" + filenames[i] +
+                    "' does not have the same size as the first image.");
+        }
+        std::vector<unsigned char> rgba;
+        auto pixels = image.pixels.get();
+        if (image.channels != 4) {
+            rgba = ToRgba(image);
+            pixels = rgba.data();
+        }
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, width_, height_, 1,
+                        GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, old_texture);
+    SetExternalMemory(width_ * height_ * layers_ * 4);
+}
+
+Texture2DArray::~Texture2DArray() {
+    Dispose();
+}
+
+void Texture2DArray::Release() {
+    DeletionQueue::current().DeleteTexture(glTexture_);
+    glTexture_ = 0;
+}
+
+void Texture2DArray::SetFilter(TextureFilter filter) {
+    GLint old_texture;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &old_texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, glTexture_);
+    switch (filter) {
+        case TextureFilter::Linear:
+            glTexParameteri(
+                    GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(
+                    GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            break;
+        case TextureFilter::Nearest:
+            glTexParameteri(
+                    GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(
+                    GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            break;
+    }
+    filter_ = filter;
+    glBindTexture(GL_TEXTURE_2D_ARRAY, old_texture);
+}
+
+void Texture2DArray::SetWrap(TextureWrap wrap) {
+    GLint old_texture;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &old_texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, glTexture_);
+    switch (wrap) {
+        case TextureWrap::Repeat:
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            break;
+        case TextureWrap::ClampToEdge:
+            glTexParameteri(
+                    GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(
+                    GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            break;
+    }
+    wrap_ = wrap;
+    glBindTexture(GL_TEXTURE_2D_ARRAY, old_texture);
+}
+
+void Texture2DArray::Initialize() {
+    ScriptObjectWrap::Initialize();
+    SetAccessor("id", GetId, NULL);
+    SetAccessor("width", ::GetWidth, NULL);
+    SetAccessor("height", ::GetHeight, NULL);
+    SetAccessor("layers", ::GetLayers, NULL);
+    SetAccessor("filter", ::GetFilter, ::SetFilter);
+    SetAccessor("wrap", ::GetWrap, ::SetWrap);
+}
+
+void Texture2DArray::New(const FunctionCallbackInfo<Value>& args) {
+    HandleScope scope(args.GetIsolate());
+    ScriptHelper helper(args.GetIsolate());
+
+    if (!args[0]->IsArray()) {
+        ScriptEngine::current().ThrowTypeError(
+                "Texture2DArray: Expected an array of image filenames.");
+        return;
+    }
+    std::vector<std::string> filenames;
+    auto array = Handle<Array>::Cast(args[0]);
+    for (uint32_t i = 0; i < array->Length(); i++) {
+        filenames.push_back(ScriptEngine::current().resolvePath(
+                helper.GetString(array->Get(i))));
+    }
+    try {
+        auto texture = new Texture2DArray(args.GetIsolate(), filenames);
+        args.GetReturnValue().Set(texture->v8Object());
+    }
+    catch (std::exception& ex) {
+        ScriptEngine::current().ThrowTypeError(ex.what());
+    }
+}
@@ -0,0 +1,68 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef GAMEPLAY_TEXTURE2DARRAY_H
+#define GAMEPLAY_TEXTURE2DARRAY_H
+
+#include <gl/glew.h>
+#include "v8.h"
+#include <string>
+#include <vector>
+#include <script/script-object-wrap.h>
+#include "texture2d.h"
+
+// A texture with multiple layers where each layer is an image with the same
+// width and height. All layers can be sampled from a single texture unit.
+
+class Texture2DArray : public ScriptObjectWrap<Texture2DArray> {
+public:
+  static const bool Disposable = true;
+
+  Texture2DArray(v8::Isolate* isolate, std::vector<std::string> filenames);
+  ~Texture2DArray();
+
+  void SetFilter(TextureFilter filter);
+  void SetWrap(TextureWrap wrap);
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  int width() { return width_; }
+  int height() { return height_; }
+  int layers() { return layers_; }
+  TextureFilter filter() { return filter_; }
+  TextureWrap wrap() { return wrap_; }
+  GLuint glTexture() { return glTexture_; }
+
+protected:
+  virtual void Initialize() override;
+  virtual void Release() override;
+
+private:
+  GLuint glTexture_;
+  TextureFilter filter_;
+  TextureWrap wrap_;
+  int width_ = 0;
+  int height_ = 0;
+  int layers_ = 0;
+};
+
+#endif // GAMEPLAY_TEXTURE2DARRAY_H
@@ -21,9 +21,12 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.*/
 
 #include "texture2d.h"
+#include "deletion-queue.h"
 #include <script/script-engine.h>
 #include "script/scripthelper.h"
 #include "graphics/window.h"
+#include "utils/virtual-file-system.h"
+#include "utils/cooked-formats.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
@@ -70,6 +73,19 @@ GLenum GetTextureFormat(int channels) {
     }
 }
 
+int GetBytesPerPixel(GLenum internalFormat) {
+    switch (internalFormat) {
+        case GL_RED: return 1;
+        case GL_R8: return 1;
+        case GL_LUMINANCE: return 1;
+        case GL_LUMINANCE_ALPHA: return 2;
+        case GL_RGB: return 3;
+        case GL_RGB16F: return 6;
+        case GL_RGBA16F: return 8;
+        default: return 4;
+    }
+}
+
 GLint GetImageAlignment(int width, int channels) {
     if (width * channels % 4 == 0) {
         return 4;
@@ -195,16 +211,49 @@ void SetWrap(Local<String> name, Local<Value> value,
 
 }
 
+Texture2D::Image Texture2D::Decode(std::string filename) {
+    std::shared_ptr<VirtualFile> file(
+            VirtualFileSystem::current().Open(filename));
+    Image image;
+    auto cooked = GetCookedHeader<CookedTextureHeader>(
+            file->data(), file->size(), CookedTextureMagic,
+            CookedTextureVersion);
+    if (cooked) {
+        if (cooked->levels < 1 || file->size() - sizeof(*cooked) <
+                GetCookedTextureSize(cooked->width, cooked->height,
+                                     cooked->channels, cooked->levels)) {
+            throw std::runtime_error(
+                    "Cooked texture '" + filename + "' is truncated");
+        }
+        image.width = cooked->width;
+        image.height = cooked->height;
+        image.channels = cooked->channels;
+        image.levels = cooked->levels;
+        // The pixels are used directly from the file, which is kept open.
+        image.pixels = std::shared_ptr<unsigned char>(
+                file, const_cast<unsigned char*>(file->data()) +
+                      sizeof(*cooked));
+        return image;
+    }
+    auto pixels = stbi_load_from_memory(
+            file->data(), static_cast<int>(file->size()), &image.width,
+            &image.height, &image.channels, 0);
+    if (pixels == NULL) {
+        throw std::runtime_error("Failed to load image '" + filename + "'");
+    }
+    image.pixels.reset(pixels, stbi_image_free);
+    return image;
+}
+
 Texture2D::Texture2D(Isolate* isolate, std::string filename) :
-        ScriptObjectWrap(isolate) {
+        Texture2D(isolate, Decode(filename)) {
+}
 
-    Window::EnsureCurrentContext();
+Texture2D::Texture2D(Isolate* isolate, const Image& image) :
+        ScriptObjectWrap(isolate), width_(image.width), height_(image.height),
+        channels_(image.channels), levels_(image.levels) {
 
-    unsigned char *image = stbi_load(
-            filename.c_str(), &width_, &height_, &channels_, 0);
-    if (image == NULL) {
-        throw std::runtime_error("Failed to load image '" + filename + "'");
-    }
+    Window::EnsureCurrentContext();
 
     GLint old_texture;
     glGetIntegerv(GL_TEXTURE_BINDING_2D, &old_texture);
@@ -215,18 +264,29 @@ Texture2D::Texture2D(Isolate* isolate, std::string filename) :
     SetFilter(TextureFilter::Linear);
     SetWrap(TextureWrap::Repeat);
 
-    glPixelStorei(GL_UNPACK_ALIGNMENT, GetImageAlignment(width_, channels_));
-    glTexImage2D(GL_TEXTURE_2D, 0, GetTextureFormat(channels_), width_, height_,
-                 0, GetTextureFormat(channels_), GL_UNSIGNED_BYTE, image);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-
-    glBindTexture(GL_TEXTURE_2D, old_texture);
-
     glFormat_ = GetTextureFormat(channels_);
     glInternalFormat_ = GetTextureFormat(channels_);
     glType_ = GL_UNSIGNED_BYTE;
 
-    stbi_image_free(image);
+    auto pixels = image.pixels.get();
+    auto width = width_;
+    auto height = height_;
+    int64_t memory = 0;
+    for (int level = 0; level < levels_; level++) {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, GetImageAlignment(width, channels_));
+        glTexImage2D(GL_TEXTURE_2D, level, glInternalFormat_, width, height,
+                     0, glFormat_, GL_UNSIGNED_BYTE, pixels);
+        pixels += width * height * channels_;
+        memory += width * height * GetBytesPerPixel(glInternalFormat_);
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels_ - 1);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glBindTexture(GL_TEXTURE_2D, old_texture);
+
+    SetExternalMemory(memory);
 }
 
 Texture2D::Texture2D(Isolate* isolate, int width, int height,
@@ -253,10 +313,16 @@ Texture2D::Texture2D(Isolate* isolate, int width, int height,
     glType_ = type;
     width_ = width;
     height_ = height;
+    SetExternalMemory(width_ * height_ * GetBytesPerPixel(internalFormat));
 }
 
 Texture2D::~Texture2D() {
-    glDeleteTextures(1, &glTexture_);
+    Dispose();
+}
+
+void Texture2D::Release() {
+    DeletionQueue::current().DeleteTexture(glTexture_);
+    glTexture_ = 0;
 }
 
 void Texture2D::GetData(float* pixels) {
@@ -286,12 +352,15 @@ void Texture2D::SetFilter(TextureFilter filter) {
     glGetIntegerv(GL_TEXTURE_BINDING_2D, &old_texture);
     glBindTexture(GL_TEXTURE_2D, glTexture_);
     switch (filter) {
+        // Textures with mipmap levels use them when minified.
         case TextureFilter::Linear:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    levels_ > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
             break;
         case TextureFilter::Nearest:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    levels_ > 1 ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
             break;
     }
@@ -319,6 +388,15 @@ void Texture2D::SetWrap(TextureWrap wrap) {
     glBindTexture(GL_TEXTURE_2D, old_texture);
 }
 
+void Texture2D::SetSwizzle(GLint r, GLint g, GLint b, GLint a) {
+    GLint old_texture;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &old_texture);
+    glBindTexture(GL_TEXTURE_2D, glTexture_);
+    GLint swizzle[] = { r, g, b, a };
+    glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    glBindTexture(GL_TEXTURE_2D, old_texture);
+}
+
 void Texture2D::Initialize() {
     ScriptObjectWrap::Initialize();
     SetAccessor("id", GetId, NULL);
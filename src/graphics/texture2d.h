@@ -27,6 +27,7 @@ SOFTWARE.*/
 #include "v8.h"
 #include <string>
 #include <script/script-object-wrap.h>
+#include <memory>
 #include <vector>
 
 enum class TextureFilter {
@@ -41,7 +42,23 @@ enum class TextureWrap {
 
 class Texture2D : public ScriptObjectWrap<Texture2D> {
 public:
+  static const bool Disposable = true;
+
+  // Pixels decoded from an image file. Decoding doesn't use the GL context and
+  // can be done on any thread. Cooked textures have mipmap levels, which
+  // follows the first level in the pixels.
+  struct Image {
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    int levels = 1;
+    std::shared_ptr<unsigned char> pixels;
+  };
+
+  static Image Decode(std::string filename);
+
   Texture2D(v8::Isolate* isolate, std::string filename);
+  Texture2D(v8::Isolate* isolate, const Image& image);
   Texture2D(v8::Isolate* isolate, int width, int height,
             GLenum internalFormat, GLenum format, GLenum type);
   ~Texture2D();
@@ -50,6 +67,7 @@ public:
   void SetData(std::vector<float> pixels);
   void SetFilter(TextureFilter filter);
   void SetWrap(TextureWrap wrap);
+  void SetSwizzle(GLint r, GLint g, GLint b, GLint a);
 
   static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
 
@@ -62,6 +80,7 @@ public:
 
 protected:
   virtual void Initialize() override;
+  virtual void Release() override;
 
 private:
   GLuint glTexture_;
@@ -73,6 +92,7 @@ private:
   int width_;
   int height_;
   int channels_;
+  int levels_ = 1;
 };
 
 #endif // GAMEPLAY_TEXTURE2D_H
\ No newline at end of file
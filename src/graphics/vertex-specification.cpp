@@ -23,6 +23,7 @@ SOFTWARE.*/
 #include <script/scripthelper.h>
 #include <script/script-engine.h>
 #include "vertex-specification.h"
+#include "deletion-queue.h"
 #include "graphics-device.h"
 
 using namespace v8;
@@ -123,9 +124,15 @@ VertexSpecification::VertexSpecification(
 }
 
 VertexSpecification::~VertexSpecification() {
-    glDeleteVertexArrays(1, &glVertexArray_);
-    glDeleteBuffers(1, &glVertexBuffer_);
-    glDeleteBuffers(1, &glElementBuffer_);
+    Dispose();
+}
+
+void VertexSpecification::Release() {
+    auto& queue = DeletionQueue::current();
+    queue.DeleteVertexArray(glVertexArray_);
+    queue.DeleteBuffer(glVertexBuffer_);
+    queue.DeleteBuffer(glElementBuffer_);
+    glVertexArray_ = glVertexBuffer_ = glElementBuffer_ = 0;
 }
 
 void VertexSpecification::SetVertexData(
@@ -137,6 +144,8 @@ void VertexSpecification::SetVertexData(
     glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(size),
                  vertices, GetGLUsage(usage));
     graphicsDevice_->SetVertexSpecification(old);
+    vertexBytes_ = size;
+    SetExternalMemory(vertexBytes_ + indexBytes_);
 }
 
 void VertexSpecification::SetIndexData(
@@ -148,6 +157,8 @@ void VertexSpecification::SetIndexData(
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(size),
                  indices, GetGLUsage(usage));
     graphicsDevice_->SetVertexSpecification(old);
+    indexBytes_ = size;
+    SetExternalMemory(vertexBytes_ + indexBytes_);
 }
 
 void VertexSpecification::SetupVertexDeclaration(
@@ -46,6 +46,8 @@ struct VertexElement {
 class VertexSpecification : public ScriptObjectWrap<VertexSpecification> {
 
 public:
+    static const bool Disposable = true;
+
     VertexSpecification(v8::Isolate *isolate, GraphicsDevice* graphicsDevice,
                         std::vector<VertexElement> elements);
     ~VertexSpecification();
@@ -61,6 +63,7 @@ public:
 
 protected:
     virtual void Initialize() override;
+    virtual void Release() override;
 
 private:
     void SetupVertexDeclaration(std::vector<VertexElement> elements);
@@ -69,6 +72,8 @@ private:
     GLuint glVertexArray_;
     GLuint glVertexBuffer_;
     GLuint glElementBuffer_;
+    size_t vertexBytes_ = 0;
+    size_t indexBytes_ = 0;
 };
 
 
@@ -72,6 +72,11 @@ Window::Window(Isolate* isolate, std::string title, int width, int height,
         glfwGetWindowSize(glfwWindow_, &width_, &height_);
     }
 
+    auto mode = glfwGetVideoMode(monitor ? monitor : glfwGetPrimaryMonitor());
+    if (mode && mode->refreshRate > 0) {
+        refreshInterval_ = 1.0 / mode->refreshRate;
+    }
+
     glfwMakeContextCurrent(glfwWindow_);
     glfwSwapInterval(1);
     glViewport(0, 0, width_, height_);
@@ -159,6 +164,7 @@ void Window::PollEvents(const FunctionCallbackInfo<Value>& args) {
     HandleScope scope(args.GetIsolate());
     auto self = GetInternalObject(args.Holder());
     self->PollEvents();
+    ScriptEngine::current().RunCompletions();
 }
 
 void Window::IsClosing(const FunctionCallbackInfo<Value>& args) {
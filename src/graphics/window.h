@@ -59,6 +59,11 @@ public:
         return height_;
     }
 
+    // Time in seconds between vertical retraces of the monitor.
+    double refreshInterval() const {
+        return refreshInterval_;
+    }
+
 protected:
     virtual void Initialize() override;
 
@@ -76,6 +81,7 @@ private:
     GLFWwindow* glfwWindow_;
     int width_;
     int height_;
+    double refreshInterval_ = 0;
 };
 
 
@@ -22,8 +22,10 @@ SOFTWARE.*/
 
 #include <script/script-engine.h>
 #include <audio/audio-manager.h>
+#include <utils/virtual-file-system.h>
 #include <gl/glew.h>
 #include <glfw/glfw3.h>
+#include <cstring>
 #include <memory>
 #include <iostream>
 
@@ -36,6 +38,45 @@ int main(int argc, char *argv[]) {
     for (int i=1; i<argc; i++) {
         if (strcmp(argv[i], "--version") == 0) {
             std::cout << "Gameplay v" << GAMEPLAY_VERSION << std::endl;
+        } else if (strcmp(argv[i], "--create-snapshot") == 0) {
+            // Creates a startup snapshot from an entry script, usage:
+            // gameplay --create-snapshot lib/lib.js lib/snapshot.bin
+            if (i + 2 >= argc) {
+                std::cout << "Usage: --create-snapshot <entry> <output>" <<
+                        std::endl;
+                return 1;
+            }
+            try {
+                ScriptEngine::current().CreateSnapshot(argv[i + 1],
+                                                       argv[i + 2]);
+            }
+            catch (std::exception& error) {
+                std::cout << error.what() << std::endl;
+                return 1;
+            }
+            return 0;
+        } else if (strcmp(argv[i], "--create-pack") == 0) {
+            // Packs the files in a directory, usage:
+            // gameplay --create-pack samples/platformer
+            //     samples/platformer/platformer.pack
+            // The pack is mounted at the directory containing it, so it's
+            // written to the packed directory.
+            if (i + 2 >= argc) {
+                std::cout << "Usage: --create-pack <directory> " <<
+                        "<directory>/<output> [--compress]" << std::endl;
+                return 1;
+            }
+            auto compress = i + 3 < argc &&
+                    strcmp(argv[i + 3], "--compress") == 0;
+            try {
+                VirtualFileSystem::CreatePack(argv[i + 1], argv[i + 2],
+                                              compress);
+            }
+            catch (std::exception& error) {
+                std::cout << error.what() << std::endl;
+                return 1;
+            }
+            return 0;
         } else if (strncmp(argv[i], "--", 2) != 0) {
             // Ignore other arguments that have a double dash.
             filename = argv[i];
@@ -0,0 +1,216 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "script-allocator.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// The small size classes are 16, 32, 64 ... MaxSmallSize bytes.
+const size_t MinSmallSize = 16;
+const size_t MaxSmallSize = 1024;
+const size_t SlabSize = 64 * 1024;
+
+// Large blocks up to MaxArenaBlockSize are kept in the arena when freed, at
+// most MaxArenaBlocks of each size and MaxArenaBytes in total per thread.
+const size_t MaxArenaBlockSize = 16 * 1024 * 1024;
+const size_t MaxArenaBlocks = 8;
+const size_t MaxArenaBytes = 32 * 1024 * 1024;
+
+int SizeClassOf(size_t length) {
+    int sizeClass = 0;
+    for (auto size = MinSmallSize; size < length; size <<= 1) {
+        sizeClass++;
+    }
+    return sizeClass;
+}
+
+size_t SizeOfClass(int sizeClass) {
+    return MinSmallSize << sizeClass;
+}
+
+size_t RoundUpToPowerOfTwo(size_t length) {
+    size_t size = MaxSmallSize * 2;
+    while (size < length) {
+        size <<= 1;
+    }
+    return size;
+}
+
+int BucketOf(size_t size) {
+    int bucket = 0;
+    for (auto bucketSize = MaxSmallSize * 2; bucketSize < size;
+            bucketSize <<= 1) {
+        bucket++;
+    }
+    return bucket;
+}
+
+const int ArenaBuckets = BucketOf(MaxArenaBlockSize) + 1;
+
+// Freed large blocks owned by a single thread, released when the thread
+// exits.
+struct Arena {
+    Arena() : buckets(ArenaBuckets) { }
+
+    ~Arena() {
+        for (auto& bucket : buckets) {
+            for (auto block : bucket) {
+                std::free(block);
+            }
+        }
+    }
+
+    std::vector<std::vector<void*>> buckets;
+    size_t bytes = 0;
+};
+
+thread_local Arena arena;
+
+}
+
+ScriptAllocator::ScriptAllocator() :
+        sizeClasses_(SizeClassOf(MaxSmallSize) + 1), allocations_(0),
+        frees_(0), bytesInUse_(0), peakBytesInUse_(0), slabBytes_(0),
+        arenaHits_(0), arenaMisses_(0), arenaBytes_(0) {
+}
+
+ScriptAllocator::~ScriptAllocator() {
+    for (auto slab : slabs_) {
+        std::free(slab);
+    }
+}
+
+void* ScriptAllocator::Allocate(size_t length) {
+    auto data = AllocateUninitialized(length);
+    return data == NULL ? data : std::memset(data, 0, length);
+}
+
+void* ScriptAllocator::AllocateUninitialized(size_t length) {
+    void* data;
+    if (length <= MaxSmallSize) {
+        data = AllocateSmall(SizeClassOf(length));
+    }
+    else {
+        data = AllocateLarge(length);
+    }
+    if (data != NULL) {
+        Allocated(length);
+    }
+    return data;
+}
+
+void ScriptAllocator::Free(void* data, size_t length) {
+    if (data == NULL) {
+        return;
+    }
+    if (length <= MaxSmallSize) {
+        FreeSmall(data, SizeClassOf(length));
+    }
+    else {
+        FreeLarge(data, length);
+    }
+    frees_++;
+    bytesInUse_ -= length;
+}
+
+ScriptAllocatorStatistics ScriptAllocator::statistics() {
+    return ScriptAllocatorStatistics {
+        allocations_, frees_, bytesInUse_, peakBytesInUse_, slabBytes_,
+        arenaHits_, arenaMisses_, arenaBytes_
+    };
+}
+
+void* ScriptAllocator::AllocateSmall(int sizeClass) {
+    auto& pool = sizeClasses_[sizeClass];
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    if (pool.free.empty()) {
+        // Carve a new slab into blocks of the size class.
+        auto slab = static_cast<unsigned char*>(std::malloc(SlabSize));
+        if (slab == NULL) {
+            return NULL;
+        }
+        {
+            std::lock_guard<std::mutex> slabsLock(slabsMutex_);
+            slabs_.push_back(slab);
+        }
+        slabBytes_ += SlabSize;
+        auto size = SizeOfClass(sizeClass);
+        for (auto offset = SlabSize; offset >= size; offset -= size) {
+            pool.free.push_back(slab + offset - size);
+        }
+    }
+    auto data = pool.free.back();
+    pool.free.pop_back();
+    return data;
+}
+
+void ScriptAllocator::FreeSmall(void* data, int sizeClass) {
+    auto& pool = sizeClasses_[sizeClass];
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    pool.free.push_back(data);
+}
+
+void* ScriptAllocator::AllocateLarge(size_t length) {
+    if (length > MaxArenaBlockSize) {
+        return std::malloc(length);
+    }
+    auto size = RoundUpToPowerOfTwo(length);
+    auto& bucket = arena.buckets[BucketOf(size)];
+    if (!bucket.empty()) {
+        auto data = bucket.back();
+        bucket.pop_back();
+        arena.bytes -= size;
+        arenaBytes_ -= size;
+        arenaHits_++;
+        return data;
+    }
+    arenaMisses_++;
+    return std::malloc(size);
+}
+
+void ScriptAllocator::FreeLarge(void* data, size_t length) {
+    if (length > MaxArenaBlockSize) {
+        std::free(data);
+        return;
+    }
+    auto size = RoundUpToPowerOfTwo(length);
+    auto& bucket = arena.buckets[BucketOf(size)];
+    if (bucket.size() == MaxArenaBlocks ||
+            arena.bytes + size > MaxArenaBytes) {
+        std::free(data);
+        return;
+    }
+    bucket.push_back(data);
+    arena.bytes += size;
+    arenaBytes_ += size;
+}
+
+void ScriptAllocator::Allocated(size_t length) {
+    allocations_++;
+    auto bytesInUse = bytesInUse_ += length;
+    auto peak = peakBytesInUse_.load();
+    while (bytesInUse > peak &&
+            !peakBytesInUse_.compare_exchange_weak(peak, bytesInUse)) {
+    }
+}
@@ -0,0 +1,90 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef GAMEPLAY_SCRIPTALLOCATOR_H
+#define GAMEPLAY_SCRIPTALLOCATOR_H
+
+#include <v8.h>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+struct ScriptAllocatorStatistics {
+    size_t allocations;
+    size_t frees;
+    size_t bytesInUse;
+    size_t peakBytesInUse;
+    // Memory reserved for the small size classes.
+    size_t slabBytes;
+    // Large blocks reused from, and currently held by, the per-thread arenas.
+    size_t arenaHits;
+    size_t arenaMisses;
+    size_t arenaBytes;
+};
+
+// Allocates the backing stores of array buffers. Small buffers (e.g. the
+// vectors and matrices in lib/math) are carved out of slabs by size class,
+// which avoids a malloc for every object. Large buffers are rounded up to a
+// power of two and kept in a per-thread arena when freed, so buffers that are
+// created every frame (e.g. sprite batch vertices) reuse the same memory.
+class ScriptAllocator : public v8::ArrayBuffer::Allocator {
+
+public:
+    ScriptAllocator();
+    ~ScriptAllocator();
+
+    void* Allocate(size_t length) override;
+    void* AllocateUninitialized(size_t length) override;
+    void Free(void* data, size_t length) override;
+
+    ScriptAllocatorStatistics statistics();
+
+private:
+    ScriptAllocator(ScriptAllocator const& copy);
+    ScriptAllocator& operator=(ScriptAllocator const& copy);
+
+    struct SizeClass {
+        std::mutex mutex;
+        std::vector<void*> free;
+    };
+
+    void* AllocateSmall(int sizeClass);
+    void FreeSmall(void* data, int sizeClass);
+    void* AllocateLarge(size_t length);
+    void FreeLarge(void* data, size_t length);
+    void Allocated(size_t length);
+
+    std::vector<SizeClass> sizeClasses_;
+    std::mutex slabsMutex_;
+    std::vector<void*> slabs_;
+    std::atomic<size_t> allocations_;
+    std::atomic<size_t> frees_;
+    std::atomic<size_t> bytesInUse_;
+    std::atomic<size_t> peakBytesInUse_;
+    std::atomic<size_t> slabBytes_;
+    std::atomic<size_t> arenaHits_;
+    std::atomic<size_t> arenaMisses_;
+    std::atomic<size_t> arenaBytes_;
+};
+
+#endif // GAMEPLAY_SCRIPTALLOCATOR_H
@@ -0,0 +1,306 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef GAMEPLAY_SCRIPTBINDING_H
+#define GAMEPLAY_SCRIPTBINDING_H
+
+#include <v8.h>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "script-engine.h"
+#include "script-object-wrap.h"
+
+// Property name which is internalized once and kept alive for the lifetime of
+// the isolate. Looking up a property with it avoids creating a new string on
+// every call.
+class ScriptName {
+
+public:
+    explicit ScriptName(const char* value) : value_(value) { }
+
+    v8::Local<v8::String> Get(v8::Isolate* isolate) {
+        if (handle_.IsEmpty()) {
+            handle_.Set(isolate, v8::String::NewFromUtf8(
+                    isolate, value_, v8::String::kInternalizedString));
+        }
+        return handle_.Get(isolate);
+    }
+
+private:
+    const char* value_;
+    v8::Eternal<v8::String> handle_;
+};
+
+template <typename T>
+struct ScriptEnumEntry {
+    const char* name;
+    T value;
+};
+
+// Maps the values of an enum to the names used by scripts. A value can be
+// given either by name or by its integer value. Each enum that is used by a
+// binding specializes Table() with its constexpr entries.
+template <typename T>
+class ScriptEnum {
+
+public:
+    template <size_t N>
+    explicit ScriptEnum(const ScriptEnumEntry<T> (&entries)[N]) {
+        for (size_t i = 0; i < N; i++) {
+            names_.emplace_back(entries[i].name);
+            values_.push_back(entries[i].value);
+        }
+    }
+
+    static ScriptEnum<T>& Table();
+
+    T Parse(v8::Isolate* isolate, v8::Local<v8::Value> value) {
+        if (value->IsInt32()) {
+            auto number = value->Int32Value();
+            for (auto enumValue : values_) {
+                if (static_cast<int>(enumValue) == number) {
+                    return enumValue;
+                }
+            }
+        }
+        else if (value->IsString()) {
+            for (size_t i = 0; i < names_.size(); i++) {
+                // String literals from scripts are internalized as well, which
+                // makes the comparison a pointer compare.
+                if (names_[i].Get(isolate)->StrictEquals(value)) {
+                    return values_[i];
+                }
+            }
+        }
+        throw std::runtime_error("Unknown value '" +
+                std::string(*v8::String::Utf8Value(value)) + "'.");
+    }
+
+    v8::Local<v8::String> Name(v8::Isolate* isolate, T value) {
+        for (size_t i = 0; i < values_.size(); i++) {
+            if (values_[i] == value) {
+                return names_[i].Get(isolate);
+            }
+        }
+        return v8::String::Empty(isolate);
+    }
+
+private:
+    std::vector<ScriptName> names_;
+    std::vector<T> values_;
+};
+
+// Converts between script values and native values. Arguments which can't be
+// converted throws std::runtime_error.
+template <typename T, typename Enable = void>
+struct ScriptValue;
+
+template <>
+struct ScriptValue<bool> {
+    static bool From(v8::Isolate* isolate, v8::Local<v8::Value> value) {
+        return value->BooleanValue();
+    }
+    static v8::Local<v8::Value> To(v8::Isolate* isolate, bool value) {
+        return v8::Boolean::New(isolate, value);
+    }
+};
+
+template <>
+struct ScriptValue<int> {
+    static int From(v8::Isolate* isolate, v8::Local<v8::Value> value) {
+        return value->Int32Value();
+    }
+    static v8::Local<v8::Value> To(v8::Isolate* isolate, int value) {
+        return v8::Integer::New(isolate, value);
+    }
+};
+
+template <>
+struct ScriptValue<float> {
+    static float From(v8::Isolate* isolate, v8::Local<v8::Value> value) {
+        return static_cast<float>(value->NumberValue());
+    }
+    static v8::Local<v8::Value> To(v8::Isolate* isolate, float value) {
+        return v8::Number::New(isolate, value);
+    }
+};
+
+template <>
+struct ScriptValue<double> {
+    static double From(v8::Isolate* isolate, v8::Local<v8::Value> value) {
+        return value->NumberValue();
+    }
+    static v8::Local<v8::Value> To(v8::Isolate* isolate, double value) {
+        return v8::Number::New(isolate, value);
+    }
+};
+
+template <>
+struct ScriptValue<std::string> {
+    static std::string From(
+            v8::Isolate* isolate, v8::Local<v8::Value> value) {
+        if (!value->IsString()) {
+            throw std::runtime_error("Expected a string.");
+        }
+        return std::string(*v8::String::Utf8Value(value));
+    }
+    static v8::Local<v8::Value> To(
+            v8::Isolate* isolate, const std::string& value) {
+        return v8::String::NewFromUtf8(isolate, value.c_str());
+    }
+};
+
+template <typename T>
+struct ScriptValue<T, typename std::enable_if<std::is_enum<T>::value>::type> {
+    static T From(v8::Isolate* isolate, v8::Local<v8::Value> value) {
+        return ScriptEnum<T>::Table().Parse(isolate, value);
+    }
+    static v8::Local<v8::Value> To(v8::Isolate* isolate, T value) {
+        return ScriptEnum<T>::Table().Name(isolate, value);
+    }
+};
+
+template <typename T>
+struct ScriptValue<T*, typename std::enable_if<
+        std::is_base_of<ScriptObjectWrap<T>, T>::value>::type> {
+    static T* From(v8::Isolate* isolate, v8::Local<v8::Value> value) {
+        if (value->IsNull() || value->IsUndefined()) {
+            return nullptr;
+        }
+        if (!ScriptObjectWrap<T>::HasInstance(isolate, value)) {
+            throw std::runtime_error("Argument has the wrong type.");
+        }
+        return ScriptObjectWrap<T>::GetInternalObject(value->ToObject());
+    }
+    static v8::Local<v8::Value> To(v8::Isolate* isolate, T* value) {
+        if (value == nullptr) {
+            return v8::Null(isolate);
+        }
+        return value->v8Object();
+    }
+};
+
+template <size_t... I>
+struct ScriptIndices { };
+
+template <size_t N, size_t... I>
+struct ScriptMakeIndices : ScriptMakeIndices<N - 1, N - 1, I...> { };
+
+template <size_t... I>
+struct ScriptMakeIndices<0, I...> {
+    typedef ScriptIndices<I...> Type;
+};
+
+template <typename M, M method, typename C, typename R, typename... A>
+class ScriptMethodBase {
+
+public:
+    static void Call(const v8::FunctionCallbackInfo<v8::Value>& args) {
+        v8::HandleScope scope(args.GetIsolate());
+        try {
+            Invoke(args, typename ScriptMakeIndices<sizeof...(A)>::Type(),
+                   std::is_void<R>());
+        }
+        catch (std::exception& ex) {
+            ScriptEngine::current().ThrowTypeError(ex.what());
+        }
+    }
+
+private:
+    template <size_t I>
+    using Argument = typename std::decay<
+            typename std::tuple_element<I, std::tuple<A...>>::type>::type;
+
+    template <size_t... I>
+    static void Invoke(const v8::FunctionCallbackInfo<v8::Value>& args,
+                       ScriptIndices<I...>, std::true_type) {
+        auto isolate = args.GetIsolate();
+        auto object = ScriptObjectWrap<C>::GetInternalObject(args.Holder());
+        (object->*method)(
+                ScriptValue<Argument<I>>::From(isolate, args[I])...);
+    }
+
+    template <size_t... I>
+    static void Invoke(const v8::FunctionCallbackInfo<v8::Value>& args,
+                       ScriptIndices<I...>, std::false_type) {
+        auto isolate = args.GetIsolate();
+        auto object = ScriptObjectWrap<C>::GetInternalObject(args.Holder());
+        args.GetReturnValue().Set(
+                ScriptValue<typename std::decay<R>::type>::To(isolate,
+                (object->*method)(
+                        ScriptValue<Argument<I>>::From(isolate, args[I])...)));
+    }
+};
+
+// Generates a function callback for a member function of a wrapped class,
+// the arguments are converted with ScriptValue. When the member function is
+// overloaded, the type has to be given explicitly.
+//
+//   SetFunction("present", ScriptMethod<
+//       void (GraphicsDevice::*)(), &GraphicsDevice::Present>::Call);
+template <typename M, M method>
+class ScriptMethod;
+
+template <typename C, typename R, typename... A, R (C::*method)(A...)>
+class ScriptMethod<R (C::*)(A...), method> :
+        public ScriptMethodBase<R (C::*)(A...), method, C, R, A...> { };
+
+template <typename C, typename R, typename... A, R (C::*method)(A...) const>
+class ScriptMethod<R (C::*)(A...) const, method> :
+        public ScriptMethodBase<R (C::*)(A...) const, method, C, R, A...> { };
+
+// Generates accessor callbacks from a getter and a setter member function.
+template <typename G, G getter, typename S, S setter>
+class ScriptProperty;
+
+template <typename C, typename R, R (C::*getter)(),
+          typename V, void (C::*setter)(V)>
+class ScriptProperty<R (C::*)(), getter, void (C::*)(V), setter> {
+
+public:
+    static void Get(v8::Local<v8::String> name,
+                    const v8::PropertyCallbackInfo<v8::Value>& args) {
+        v8::HandleScope scope(args.GetIsolate());
+        auto object = ScriptObjectWrap<C>::GetInternalObject(args.Holder());
+        args.GetReturnValue().Set(ScriptValue<typename std::decay<R>::type>::
+                To(args.GetIsolate(), (object->*getter)()));
+    }
+
+    static void Set(v8::Local<v8::String> name, v8::Local<v8::Value> value,
+                    const v8::PropertyCallbackInfo<void>& args) {
+        v8::HandleScope scope(args.GetIsolate());
+        auto object = ScriptObjectWrap<C>::GetInternalObject(args.Holder());
+        try {
+            (object->*setter)(ScriptValue<typename std::decay<V>::type>::
+                    From(args.GetIsolate(), value));
+        }
+        catch (std::exception& ex) {
+            ScriptEngine::current().ThrowTypeError(ex.what());
+        }
+    }
+};
+
+#endif // GAMEPLAY_SCRIPTBINDING_H
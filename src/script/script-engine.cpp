@@ -20,11 +20,23 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.*/
 
+#include <audio/voice-pool.h>
 #include <utils/path-helper.h>
+#include <utils/hash.h>
+#include <utils/memory-mapped-file.h>
+#include <utils/virtual-file-system.h>
 #include "script-engine.h"
 #include "script-global.h"
+#include "script-snapshot.h"
 #include "debug/debug-server.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 
 #ifdef WIN32
 #define NewLine "\r\n"
@@ -50,22 +62,61 @@ public:
     }
 };
 
-class ArrayBufferAllocator : public ArrayBuffer::Allocator {
+// Identifies code cache files.
+const uint32_t CodeCacheMagic = 0x43435047;
 
-public:
-    virtual void* Allocate(size_t length) {
-        void* data = AllocateUninitialized(length);
-        return data == NULL ? data : memset(data, 0, length);
-    }
+// The code cache is stored together with a hash of the source it was created
+// from and the V8 version tag, the cache is stale when either one differs.
+struct CodeCacheHeader {
+    uint32_t magic;
+    uint32_t versionTag;
+    uint64_t sourceHash;
+    uint32_t length;
+};
 
-    virtual void* AllocateUninitialized(size_t length) {
-        return malloc(length);
+// Returns the code cache in the file if it was created from the same source
+// with the current V8 version, otherwise NULL. The data refers to the mapped
+// file and is only valid as long as the file is.
+ScriptCompiler::CachedData* ReadCodeCache(MemoryMappedFile* file,
+                                          uint64_t sourceHash) {
+    CodeCacheHeader header;
+    if (file->size() < sizeof(header)) {
+        return NULL;
     }
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (header.magic != CodeCacheMagic ||
+            header.versionTag != ScriptCompiler::CachedDataVersionTag() ||
+            header.sourceHash != sourceHash ||
+            header.length != file->size() - sizeof(header)) {
+        return NULL;
+    }
+    return new ScriptCompiler::CachedData(
+            file->data() + sizeof(header), header.length,
+            ScriptCompiler::CachedData::BufferNotOwned);
+}
 
-    virtual void Free(void* data, size_t) {
-        free(data);
+void WriteCodeCache(std::string filename, uint64_t sourceHash,
+                    const ScriptCompiler::CachedData* data) {
+    CodeCacheHeader header {
+        CodeCacheMagic, ScriptCompiler::CachedDataVersionTag(), sourceHash,
+        static_cast<uint32_t>(data->length)
+    };
+    // Written to a temporary file first so a partially written cache is
+    // never read.
+    auto temporary = filename + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(data->data), data->length);
+        if (!file) {
+            file.close();
+            std::remove(temporary.c_str());
+            return;
+        }
     }
-};
+    std::remove(filename.c_str());
+    std::rename(temporary.c_str(), filename.c_str());
+}
 
 void PrintStackTrace(Isolate* isolate, TryCatch* tryCatch) {
     HandleScope scope(isolate);
@@ -101,10 +152,13 @@ ScriptEngine::~ScriptEngine() {
 }
 
 void ScriptEngine::Run(std::string filename, int argc, char* argv[]) {
+    startTime_ = platform_->MonotonicallyIncreasingTime();
     V8::SetFlagsFromCommandLine(&argc, argv, true);
 
     executionPath_ = PathHelper::Append(
             {PathHelper::Current(), PathHelper::GetPath(filename)});
+    // Paths resolved before the execution path was known are stale.
+    resolvedPaths_.clear();
 
     filename = PathHelper::GetFileName(filename);
 
@@ -113,13 +167,40 @@ void ScriptEngine::Run(std::string filename, int argc, char* argv[]) {
         if (strcmp(argv[i], "debug") == 0) {
             debug = true;
         }
+        if (strcmp(argv[i], "profile") == 0) {
+            profile_ = true;
+        }
+        if (strncmp(argv[i], "--min-idle-time=", 16) == 0) {
+            minIdleTime_ = atof(argv[i] + 16) / 1000;
+        }
+        if (strncmp(argv[i], "--pack=", 7) == 0) {
+            std::string pack = argv[i] + 7;
+            if (!PathHelper::IsAbsolute(pack)) {
+                pack = PathHelper::Append({PathHelper::Current(), pack});
+            }
+            VirtualFileSystem::current().Mount(pack);
+        }
+        if (strcmp(argv[i], "--no-loose-files") == 0) {
+            VirtualFileSystem::current().SetLooseFiles(false);
+        }
+        if (strncmp(argv[i], "--snapshot=", 11) == 0) {
+            snapshot_.reset(new ScriptSnapshot(PathHelper::Append(
+                    {PathHelper::Current(), argv[i] + 11})));
+        }
     }
+    PathHelper::CreateDirectories(codeCachePath());
 
-    ArrayBufferAllocator array_buffer_allocator;
     Isolate::CreateParams create_params;
-    create_params.array_buffer_allocator = &array_buffer_allocator;
+    create_params.array_buffer_allocator = &allocator_;
+    if (snapshot_) {
+        // The context is created from the snapshot with the modules already
+        // evaluated, the native bindings are added by the global template.
+        create_params.snapshot_blob = snapshot_->data();
+    }
 
     isolate_ = v8::Isolate::New(create_params);
+    gcTracker_.reset(new ScriptGCTracker(platform_));
+    gcTracker_->Install(isolate_);
     {
         Isolate::Scope isolate_scope(isolate_);
         HandleScope handle_scope(isolate_);
@@ -130,7 +211,30 @@ void ScriptEngine::Run(std::string filename, int argc, char* argv[]) {
         context_ = Context::New(isolate_, NULL, global_->v8Template());
         Context::Scope context_scope(context_);
         Execute(filename);
+        // Scripts without a game loop are kept running until their
+        // asynchronous work has completed.
+        while (ioThreadPool_.pending() > 0 ||
+               workerThreadPool_.pending() > 0 ||
+               global_->loader().loading()) {
+            if (ioThreadPool_.pending() > 0) {
+                ioThreadPool_.WaitForCompletion();
+            }
+            else {
+                workerThreadPool_.WaitForCompletion();
+            }
+            RunCompletions();
+        }
+    }
+    if (profile_ && frameTimes_.count() > 0) {
+        std::ostringstream milliseconds;
+        milliseconds << std::fixed << std::setprecision(2) << idleTime();
+        std::cout << "Frame times (ms): " << frameTimes_.ToString("ms") <<
+                "Idle time given to garbage collection: " <<
+                milliseconds.str() << " ms" << std::endl;
+        std::cout << "Garbage collection:" << std::endl <<
+                gcTracker_->ToString();
     }
+    gcTracker_->Uninstall(isolate_);
     isolate_->Dispose();
 }
 
@@ -144,6 +248,16 @@ Handle<Value> ScriptEngine::Execute(std::string filepath) {
     auto filename = PathHelper::GetFileName(filepath);
     auto resolvedPath = resolvePath(filepath);
 
+    if (snapshot_) {
+        auto key = snapshot_->GetModuleKey(resolvedPath);
+        if (!key.empty()) {
+            auto exports = ExecuteSnapshot(key, filepath, filename);
+            if (!exports.IsEmpty()) {
+                return handle_scope.Escape(exports);
+            }
+        }
+    }
+
     // The original script source is being wrapped in an anonymous function
     // just to define a local scope.
     auto source = "(function (module, exports) { " +
@@ -153,13 +267,61 @@ Handle<Value> ScriptEngine::Execute(std::string filepath) {
 
     TryCatch tryCatch;
 
-    auto compiled = Script::Compile(
-        script, String::NewFromUtf8(isolate_, resolvedPath.c_str()));
-
-    if (compiled.IsEmpty()) {
+    // The code cache from an earlier compilation of the same source is used
+    // when available, otherwise a new code cache is produced.
+    auto sourceHash = Hash::Fnv1a(source);
+    auto cacheFilename = PathHelper::Append(
+            {codeCachePath(), Hash::ToHex(Hash::Fnv1a(resolvedPath)) +
+                    ".cache"});
+    std::unique_ptr<MemoryMappedFile> cacheFile;
+    ScriptCompiler::CachedData* cachedData = NULL;
+    try {
+        cacheFile.reset(new MemoryMappedFile(cacheFilename));
+        cachedData = ReadCodeCache(cacheFile.get(), sourceHash);
+    }
+    catch (std::exception&) {
+        // There is no code cache for the script yet.
+    }
+    auto options = cachedData ? ScriptCompiler::kConsumeCodeCache :
+                   ScriptCompiler::kProduceCodeCache;
+    ScriptOrigin origin(String::NewFromUtf8(isolate_, resolvedPath.c_str()));
+    ScriptCompiler::Source scriptSource(script, origin, cachedData);
+
+    auto startTime = platform_->MonotonicallyIncreasingTime();
+    Local<Script> compiled;
+    if (!ScriptCompiler::Compile(isolate_->GetCurrentContext(), &scriptSource,
+                                 options).ToLocal(&compiled)) {
         PrintCompileError(isolate_, &tryCatch);
         return v8::Null(isolate_);
     }
+    auto compileTime = platform_->MonotonicallyIncreasingTime() - startTime;
+
+    std::string codeCache;
+    if (options == ScriptCompiler::kConsumeCodeCache) {
+        codeCache = "hit";
+        if (scriptSource.GetCachedData()->rejected) {
+            // V8 compiled the script without the code cache, it's replaced
+            // the next time the script is compiled.
+            codeCache = "rejected";
+            cacheFile.reset();
+            std::remove(cacheFilename.c_str());
+        }
+    }
+    else {
+        codeCache = "miss";
+        if (scriptSource.GetCachedData() != NULL) {
+            cacheFile.reset();
+            WriteCodeCache(cacheFilename, sourceHash,
+                           scriptSource.GetCachedData());
+        }
+    }
+    if (profile_) {
+        std::ostringstream milliseconds;
+        milliseconds << std::fixed << std::setprecision(2) << compileTime * 1000;
+        std::cout << "Compiled " << resolvedPath << " in " <<
+                milliseconds.str() << " ms (code cache " << codeCache << ")" <<
+                std::endl;
+    }
 
     if (filepath.compare(0, 2, "./") == 0) {
         filepath.erase(0, 2);
@@ -168,7 +330,7 @@ Handle<Value> ScriptEngine::Execute(std::string filepath) {
         filepath.erase(0, 1);
     }
     auto p = PathHelper::GetPath(filepath);
-    scriptPath_.push_back(p);
+    PushScriptPath(p);
 
     // The result from the running script is a function that defines the local
     // scope for the script.
@@ -185,16 +347,205 @@ Handle<Value> ScriptEngine::Execute(std::string filepath) {
     // is passed as an argument). An error has occurred when result is empty.
     if (scope->Call(scope, 2, args).IsEmpty()) {
         PrintStackTrace(isolate_, &tryCatch);
-        scriptPath_.pop_back();
+        PopScriptPath();
         return v8::Null(isolate_);
     }
 
-    scriptPath_.pop_back();
+    PopScriptPath();
+
+    return handle_scope.Escape(
+        module->v8Object()->Get(String::NewFromUtf8(isolate_, "exports")));
+}
+
+Handle<Value> ScriptEngine::ExecuteSnapshot(std::string key,
+                                            std::string filepath,
+                                            std::string filename) {
+    EscapableHandleScope handle_scope(isolate_);
+
+    auto global = isolate_->GetCurrentContext()->Global();
+    auto value = global->Get(String::NewFromUtf8(isolate_, "__snapshot"));
+    if (!value->IsObject()) {
+        return Handle<Value>();
+    }
+    auto snapshot = value->ToObject();
+    auto exports = snapshot->Get(
+            String::NewFromUtf8(isolate_, "exports"))->ToObject();
+    auto modules = snapshot->Get(
+            String::NewFromUtf8(isolate_, "modules"))->ToObject();
+    auto name = String::NewFromUtf8(isolate_, key.c_str());
+    if (!exports->Has(name) && !modules->Has(name)) {
+        return Handle<Value>();
+    }
+
+    if (filepath.compare(0, 2, "./") == 0) {
+        filepath.erase(0, 2);
+    }
+    if (filepath.compare(0, 1, "/") == 0) {
+        filepath.erase(0, 1);
+    }
+    PushScriptPath(PathHelper::GetPath(filepath));
+
+    if (!snapshotRootSet_) {
+        // The modules evaluated in the snapshot doesn't know where the
+        // snapshot is relative to the execution path, it's known from the
+        // path of the first module loaded from the snapshot.
+        auto root = scriptPath();
+        auto directory = PathHelper::GetPath(key);
+        if (!directory.empty()) {
+            directory.pop_back();
+            if (PathHelper::FileNameEndsWith(root, directory)) {
+                root = root.substr(0, root.length() - directory.length());
+            }
+            if (!root.empty() && root.back() == '/') {
+                root.pop_back();
+            }
+        }
+        auto setRoot = Handle<Function>::Cast(snapshot->Get(
+                String::NewFromUtf8(isolate_, "setRoot")));
+        Handle<Value> args[] = { String::NewFromUtf8(isolate_, root.c_str()) };
+        setRoot->Call(snapshot, 1, args);
+        snapshotRootSet_ = true;
+    }
+
+    if (exports->Has(name)) {
+        PopScriptPath();
+        return handle_scope.Escape(exports->Get(name));
+    }
+
+    // The module couldn't be evaluated when the snapshot was created, but it
+    // has already been compiled.
+    TryCatch tryCatch;
+    auto scope = Handle<Function>::Cast(modules->Get(name));
+    auto module = new ScriptModule(isolate_, scriptPath(), filename);
+    Handle<Value> args[] = {
+        module->v8Object(),
+        module->v8Object()->Get(String::NewFromUtf8(isolate_, "exports")),
+        global->Get(String::NewFromUtf8(isolate_, "require"))
+    };
+    if (scope->Call(scope, 3, args).IsEmpty()) {
+        PrintStackTrace(isolate_, &tryCatch);
+        PopScriptPath();
+        return v8::Null(isolate_);
+    }
+    PopScriptPath();
 
     return handle_scope.Escape(
         module->v8Object()->Get(String::NewFromUtf8(isolate_, "exports")));
 }
 
+uint32_t ScriptEngine::ResolvePathId(const std::string& filepath) {
+    ResolveKey key { scriptPathId_, filepath };
+    auto cached = resolvedPaths_.find(key);
+    if (cached != resolvedPaths_.end()) {
+        return cached->second;
+    }
+    std::string resolved;
+    if (filepath.compare(0, 2, "./") == 0) {
+        resolved = PathHelper::Append(
+                {executionPath(), scriptPath(), filepath.substr(2)});
+    }
+    else if (filepath.compare(0, 1, "/") == 0) {
+        resolved = PathHelper::Append(
+                {executionPath(), filepath.substr(1)});
+    }
+    else {
+        resolved = PathHelper::Append(
+                {executionPath(), scriptPath(), filepath});
+    }
+    auto id = InternPath(PathHelper::Normalize(resolved));
+    resolvedPaths_.emplace(std::move(key), id);
+    return id;
+}
+
+uint32_t ScriptEngine::InternPath(const std::string& path) {
+    auto interned = pathIds_.find(path);
+    if (interned != pathIds_.end()) {
+        return interned->second;
+    }
+    auto id = static_cast<uint32_t>(paths_.size());
+    paths_.push_back(path);
+    pathIds_.emplace(path, id);
+    return id;
+}
+
+void ScriptEngine::PushScriptPath(std::string path) {
+    scriptPath_.push_back(path);
+    scriptPathId_ = InternPath(PathHelper::Append(scriptPath_));
+}
+
+void ScriptEngine::PopScriptPath() {
+    scriptPath_.pop_back();
+    scriptPathId_ = scriptPath_.empty() ?
+            0 : InternPath(PathHelper::Append(scriptPath_));
+}
+
+void ScriptEngine::CreateSnapshot(std::string entry, std::string output) {
+    ScriptSnapshot::Create(PathHelper::Append({PathHelper::Current(), entry}),
+                           output);
+}
+
+void ScriptEngine::RunCompletions() {
+    auto completed = ioThreadPool_.RunCompletions();
+    completed += workerThreadPool_.RunCompletions();
+    completed += global_->loader().Update();
+    VoicePool::current().Update();
+    if (completed > 0) {
+        isolate_->RunMicrotasks();
+    }
+}
+
+void ScriptEngine::FrameRendered() {
+    frameRenderedTime_ = platform_->MonotonicallyIncreasingTime();
+}
+
+void ScriptEngine::FramePresented(double refreshInterval) {
+    auto now = platform_->MonotonicallyIncreasingTime();
+    auto gcTime = gcTracker_->FrameCompleted();
+    if (framePresentedTime_ > 0) {
+        auto frameTime = (now - framePresentedTime_) * 1000;
+        frameTimes_.Add(frameTime);
+        if (profile_ && refreshInterval > 0 &&
+                frameTime > refreshInterval * 1500) {
+            // The frame missed at least one vertical retrace.
+            std::ostringstream message;
+            message << std::fixed << std::setprecision(2) << "Slow frame " <<
+                    frameTimes_.count() << ": " << frameTime <<
+                    " ms (garbage collection " << gcTime << " ms)";
+            std::cout << message.str() << std::endl;
+        }
+        // The work time is smoothed so that a single fast frame doesn't give
+        // away time that the next frame needs.
+        auto workTime = frameRenderedTime_ - frameStartTime_;
+        workTime_ = std::max(workTime, workTime_ * 0.9 + workTime * 0.1);
+    }
+    framePresentedTime_ = now;
+
+    if (refreshInterval > 0 && frameTimes_.count() > 0) {
+        // The time left until the next vertical retrace, when the next frame
+        // has done its work, is given to V8 for garbage collection.
+        auto idleTime = refreshInterval - workTime_;
+        if (idleTime >= minIdleTime_) {
+            gcTracker_->SetIdle(true);
+            isolate_->IdleNotificationDeadline(now + idleTime);
+            gcTracker_->SetIdle(false);
+            idleTime_ += platform_->MonotonicallyIncreasingTime() - now;
+        }
+    }
+    frameStartTime_ = platform_->MonotonicallyIncreasingTime();
+
+    if (firstFramePresented_) {
+        return;
+    }
+    firstFramePresented_ = true;
+    if (profile_) {
+        std::ostringstream milliseconds;
+        milliseconds << std::fixed << std::setprecision(2) <<
+                (now - startTime_) * 1000;
+        std::cout << "Time to first frame: " << milliseconds.str() << " ms" <<
+                (snapshot_ ? " (snapshot)" : "") << std::endl;
+    }
+}
+
 void ScriptEngine::ThrowTypeError(std::string message) {
     isolate_->ThrowException(Exception::TypeError(
             String::NewFromUtf8(isolate_, message.c_str())));
@@ -25,13 +25,22 @@ SOFTWARE.*/
 
 #include "v8.h"
 #include "libplatform/libplatform.h"
+#include <deque>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <numeric>
 #include <memory>
+#include <algorithm>
+#include <thread>
 #include <utils/path-helper.h>
+#include <utils/histogram.h>
+#include <utils/thread-pool.h>
+#include "script-allocator.h"
+#include "script-gc-tracker.h"
 
 class ScriptGlobal;
+class ScriptSnapshot;
 
 class ScriptEngine {
 
@@ -39,41 +48,125 @@ public:
     v8::Handle<v8::Value> Execute(std::string filepath);
     void Run(std::string filename, int argc, char* argv[]);
     void ThrowTypeError(std::string message);
+    void CreateSnapshot(std::string entry, std::string output);
+
+    // Calls the completions of finished asynchronous work (e.g. resolving
+    // the promises of file reads), creates the assets loaded in the
+    // background, updates the playing voices and runs the microtasks they
+    // queued. The game loop never returns to V8, so it's called when polling
+    // events.
+    void RunCompletions();
+
+    // Called before the back buffer is swapped.
+    void FrameRendered();
+    // Called after each frame has been presented. The refresh interval is the
+    // time in seconds until the next vertical retrace, or 0 when presenting
+    // isn't synchronized with it.
+    void FramePresented(double refreshInterval);
 
     static ScriptEngine& current() {
         static ScriptEngine instance;
         return instance;
     }
 
+    // Allocates the backing stores of all array buffers.
+    ScriptAllocator& allocator() {
+        return allocator_;
+    }
+
+    // The global object of the scripts, which owns the global services
+    // (e.g. the asset cache).
+    ScriptGlobal& global() {
+        return *global_;
+    }
+
+    // Threads reading files in the background.
+    ThreadPool& ioThreadPool() {
+        return ioThreadPool_;
+    }
+
+    // Threads doing CPU bound work (e.g. decoding sounds), one per core.
+    ThreadPool& workerThreadPool() {
+        return workerThreadPool_;
+    }
+
     std::string executionPath() {
         return executionPath_;
     }
 
-    std::string scriptPath() {
-        if (scriptPath_.empty()) {
-            return "";
-        }
-        return PathHelper::Append(scriptPath_);
+    // Directory where data derived from the game files (e.g. font atlases) is
+    // stored between runs.
+    std::string cachePath() {
+        return PathHelper::Append({executionPath_, ".cache"});
     }
 
-    std::string resolvePath(std::string filepath) {
-        std::string resolved;
-        if (filepath.compare(0, 2, "./") == 0) {
-            resolved = PathHelper::Append(
-                    {executionPath(), scriptPath(), filepath.substr(2)});
-        }
-        else if (filepath.compare(0, 1, "/") == 0) {
-            resolved = PathHelper::Append(
-                    {executionPath(), filepath.substr(1)});
-        }
-        else {
-            resolved = PathHelper::Append(
-                    {executionPath(), scriptPath(), filepath});
-        }
-        return PathHelper::Normalize(resolved);
+    // Directory where the code cache for compiled scripts is stored.
+    std::string codeCachePath() {
+        return PathHelper::Append({cachePath(), "scripts"});
+    }
+
+    // True when timing information should be printed (started with the
+    // "profile" argument).
+    bool profile() {
+        return profile_;
+    }
+
+    // Records the garbage collections and the frames they happened in.
+    ScriptGCTracker& gcTracker() {
+        return *gcTracker_;
     }
 
+    // Time in milliseconds between presented frames.
+    const Histogram& frameTimes() {
+        return frameTimes_;
+    }
+
+    // Total time in milliseconds given to V8 for garbage collection while the
+    // frame loop was idle.
+    double idleTime() {
+        return idleTime_ * 1000;
+    }
+
+    // Path of the running script relative to the execution path.
+    const std::string& scriptPath() {
+        return paths_[scriptPathId_];
+    }
+
+    // Resolves a path relative to the running script ("./"), the execution
+    // path ("/") or otherwise the script path.
+    std::string resolvePath(const std::string& filepath) {
+        return paths_[ResolvePathId(filepath)];
+    }
+
+    // Returns the interned id of the resolved path. The paths are cached by
+    // the script path and the requested path, so each is only resolved once.
+    uint32_t ResolvePathId(const std::string& filepath);
+
 private:
+    struct ResolveKey {
+        uint32_t scriptPath;
+        std::string filepath;
+
+        bool operator==(const ResolveKey& other) const {
+            return scriptPath == other.scriptPath &&
+                   filepath == other.filepath;
+        }
+    };
+
+    struct ResolveKeyHash {
+        size_t operator()(const ResolveKey& key) const {
+            return std::hash<std::string>()(key.filepath) ^
+                   (key.scriptPath * 2654435761u);
+        }
+    };
+
+    uint32_t InternPath(const std::string& path);
+    void PushScriptPath(std::string path);
+    void PopScriptPath();
+
+    v8::Handle<v8::Value> ExecuteSnapshot(std::string key, std::string filepath,
+                                          std::string filename);
+
     ScriptEngine();
     ~ScriptEngine();
 
@@ -81,11 +174,35 @@ private:
     ScriptEngine& operator=(ScriptEngine const& copy);
 
     v8::Platform* platform_;
+    ScriptAllocator allocator_;
+    ThreadPool ioThreadPool_ {2};
+    ThreadPool workerThreadPool_ {
+        static_cast<int>(std::max(1u, std::thread::hardware_concurrency())) };
     v8::Isolate* isolate_;
     v8::Local<v8::Context> context_;
     std::unique_ptr<ScriptGlobal> global_;
     std::vector<std::string> scriptPath_;
+    // The interned paths, a deque keeps references to them valid.
+    std::deque<std::string> paths_ { "" };
+    std::unordered_map<std::string, uint32_t> pathIds_ { { "", 0 } };
+    std::unordered_map<ResolveKey, uint32_t, ResolveKeyHash> resolvedPaths_;
+    uint32_t scriptPathId_ = 0;
     std::string executionPath_;
+    bool profile_ = false;
+    std::unique_ptr<ScriptSnapshot> snapshot_;
+    bool snapshotRootSet_ = false;
+    double startTime_ = 0;
+    bool firstFramePresented_ = false;
+    Histogram frameTimes_ {1, 100};
+    std::unique_ptr<ScriptGCTracker> gcTracker_;
+    // Minimum time left of a frame for it to be given to V8 as idle time, can
+    // be set with --min-idle-time=<ms>.
+    double minIdleTime_ = 0.002;
+    double frameStartTime_ = 0;
+    double frameRenderedTime_ = 0;
+    double framePresentedTime_ = 0;
+    double workTime_ = 0;
+    double idleTime_ = 0;
 };
 
 #endif
\ No newline at end of file
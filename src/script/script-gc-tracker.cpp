@@ -0,0 +1,159 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "script-gc-tracker.h"
+#include "script-engine.h"
+#include <algorithm>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+using namespace v8;
+
+namespace {
+
+// Number of collections kept in the records.
+const size_t MaxRecords = 64;
+
+const GCType Types[] = {
+    kGCTypeScavenge,
+    kGCTypeMarkSweepCompact,
+    kGCTypeIncrementalMarking,
+    kGCTypeProcessWeakCallbacks,
+};
+
+size_t UsedHeapSize(Isolate* isolate) {
+    HeapStatistics statistics;
+    isolate->GetHeapStatistics(&statistics);
+    return statistics.used_heap_size();
+}
+
+}
+
+void ScriptGCTracker::Install(Isolate* isolate) {
+    startTime_ = platform_->MonotonicallyIncreasingTime();
+    types_.assign(std::begin(Types), std::end(Types));
+    counters_.assign(types_.size(), ScriptGCCounter { 0, 0, 0 });
+    isolate->AddGCPrologueCallback(Prologue);
+    isolate->AddGCEpilogueCallback(Epilogue);
+}
+
+void ScriptGCTracker::Uninstall(Isolate* isolate) {
+    isolate->RemoveGCPrologueCallback(Prologue);
+    isolate->RemoveGCEpilogueCallback(Epilogue);
+}
+
+double ScriptGCTracker::FrameCompleted() {
+    frameTimes_.Add(frameTime_);
+    lastFrameTime_ = frameTime_;
+    frameTime_ = 0;
+    frame_++;
+    return lastFrameTime_;
+}
+
+const ScriptGCCounter& ScriptGCTracker::counter(GCType type) const {
+    for (size_t i = 0; i < types_.size(); i++) {
+        if (types_[i] == type) {
+            return counters_[i];
+        }
+    }
+    throw std::runtime_error("Unknown garbage collection type");
+}
+
+const char* ScriptGCTracker::TypeName(GCType type) {
+    switch (type) {
+        case kGCTypeScavenge:
+            return "scavenge";
+        case kGCTypeMarkSweepCompact:
+            return "markSweepCompact";
+        case kGCTypeIncrementalMarking:
+            return "incrementalMarking";
+        case kGCTypeProcessWeakCallbacks:
+            return "processWeakCallbacks";
+        default:
+            return "unknown";
+    }
+}
+
+std::string ScriptGCTracker::ToString() const {
+    std::ostringstream output;
+    output << std::fixed << std::setprecision(2);
+    for (size_t i = 0; i < types_.size(); i++) {
+        auto& counter = counters_[i];
+        if (counter.count == 0) {
+            continue;
+        }
+        output << "  " << TypeName(types_[i]) << ": " << counter.count <<
+                " collections, " << counter.time << " ms, max pause " <<
+                counter.maxPause << " ms" << std::endl;
+    }
+    output << "  total " << time_ << " ms, in idle time " << idleTime_ <<
+            " ms" << std::endl;
+    output << "Garbage collection per frame (ms): " <<
+            frameTimes_.ToString("ms");
+    return output.str();
+}
+
+void ScriptGCTracker::Prologue(Isolate* isolate, GCType type,
+                               GCCallbackFlags flags) {
+    auto& tracker = ScriptEngine::current().gcTracker();
+    tracker.active_.push_back(ScriptGCRecord {
+        type, tracker.now(), 0, UsedHeapSize(isolate), 0, tracker.idle_,
+        tracker.frame_
+    });
+}
+
+void ScriptGCTracker::Epilogue(Isolate* isolate, GCType type,
+                               GCCallbackFlags flags) {
+    auto& tracker = ScriptEngine::current().gcTracker();
+    if (tracker.active_.empty()) {
+        return;
+    }
+    auto record = tracker.active_.back();
+    tracker.active_.pop_back();
+    record.duration = tracker.now() - record.start;
+    record.heapAfter = UsedHeapSize(isolate);
+
+    for (size_t i = 0; i < tracker.types_.size(); i++) {
+        if (tracker.types_[i] == record.type) {
+            auto& counter = tracker.counters_[i];
+            counter.count++;
+            counter.time += record.duration;
+            counter.maxPause = std::max(counter.maxPause, record.duration);
+        }
+    }
+    // Nested collections are already part of the outer collection's time.
+    if (tracker.active_.empty()) {
+        tracker.time_ += record.duration;
+        if (record.idle) {
+            tracker.idleTime_ += record.duration;
+        }
+        else {
+            tracker.frameTime_ += record.duration;
+        }
+    }
+    tracker.records_.push_back(record);
+    if (tracker.records_.size() > MaxRecords) {
+        tracker.records_.pop_front();
+    }
+}
@@ -0,0 +1,129 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef GAMEPLAY_SCRIPTGCTRACKER_H
+#define GAMEPLAY_SCRIPTGCTRACKER_H
+
+#include <v8.h>
+#include <v8-platform.h>
+#include <utils/histogram.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+struct ScriptGCRecord {
+    v8::GCType type;
+    // Time in milliseconds since the tracker was installed.
+    double start;
+    double duration;
+    size_t heapBefore;
+    size_t heapAfter;
+    // True when the collection ran in the idle time after a frame.
+    bool idle;
+    int frame;
+};
+
+struct ScriptGCCounter {
+    int count;
+    double time;
+    double maxPause;
+};
+
+// Records every garbage collection with GC prologue and epilogue callbacks,
+// and attributes the time to the frame it happened in.
+class ScriptGCTracker {
+
+public:
+    ScriptGCTracker(v8::Platform* platform) : platform_(platform) { }
+
+    void Install(v8::Isolate* isolate);
+    void Uninstall(v8::Isolate* isolate);
+
+    // Called while V8 is given idle time, collections are then not counted
+    // towards the frame.
+    void SetIdle(bool idle) {
+        idle_ = idle;
+    }
+
+    // Ends the current frame and returns the time in milliseconds that
+    // garbage collection took during it.
+    double FrameCompleted();
+
+    std::string ToString() const;
+
+    static const char* TypeName(v8::GCType type);
+
+    // The most recent collections, oldest first.
+    const std::deque<ScriptGCRecord>& records() const {
+        return records_;
+    }
+
+    const std::vector<v8::GCType>& types() const {
+        return types_;
+    }
+
+    const ScriptGCCounter& counter(v8::GCType type) const;
+
+    // Time in milliseconds that garbage collection took per frame.
+    const Histogram& frameTimes() const {
+        return frameTimes_;
+    }
+
+    double time() const {
+        return time_;
+    }
+
+    double idleTime() const {
+        return idleTime_;
+    }
+
+    double lastFrameTime() const {
+        return lastFrameTime_;
+    }
+
+private:
+    static void Prologue(v8::Isolate* isolate, v8::GCType type,
+                         v8::GCCallbackFlags flags);
+    static void Epilogue(v8::Isolate* isolate, v8::GCType type,
+                         v8::GCCallbackFlags flags);
+
+    double now() const {
+        return (platform_->MonotonicallyIncreasingTime() - startTime_) * 1000;
+    }
+
+    v8::Platform* platform_;
+    double startTime_ = 0;
+    // Collections can be nested, e.g. a scavenge during incremental marking.
+    std::vector<ScriptGCRecord> active_;
+    std::deque<ScriptGCRecord> records_;
+    std::vector<v8::GCType> types_;
+    std::vector<ScriptGCCounter> counters_;
+    Histogram frameTimes_ {1, 50};
+    bool idle_ = false;
+    int frame_ = 0;
+    double time_ = 0;
+    double idleTime_ = 0;
+    double frameTime_ = 0;
+    double lastFrameTime_ = 0;
+};
+
+#endif // GAMEPLAY_SCRIPTGCTRACKER_H
@@ -23,14 +23,17 @@ SOFTWARE.*/
 #include <graphics/window.h>
 #include <audio/sound-buffer.h>
 #include <audio/sound-source.h>
+#include <audio/streaming-sound-source.h>
 #include <input/keyboard.h>
 #include <input/mouse.h>
 #include <utils/timer.h>
 #include <graphics/texture-font.h>
+#include <graphics/texture2d-array.h>
 #include <graphics/vertex-specification.h>
 #include <graphics/shader-program.h>
 #include <utils/path-helper.h>
 #include <utils/file-watcher.h>
+#include <utils/world-stream.h>
 #include <graphics/render-target.h>
 #include <iostream>
 #include "script-object-wrap.h"
@@ -39,23 +42,32 @@ SOFTWARE.*/
 #include "script-engine.h"
 
 ScriptGlobal::ScriptGlobal(v8::Isolate *isolate) :
-        ScriptObjectWrap(isolate), console_(isolate), fileReader_(isolate) {
+        ScriptObjectWrap(isolate), console_(isolate), fileReader_(isolate),
+        memory_(isolate), profiler_(isolate), assets_(isolate),
+        loader_(isolate) {
 
     InstallConstructor<Window>("Window");
     InstallConstructor<TextureFont>("TextureFont");
     InstallConstructor<Texture2D>("Texture2D");
+    InstallConstructor<Texture2DArray>("Texture2DArray");
     InstallConstructor<ShaderProgram>("ShaderProgram");
     InstallConstructor<VertexSpecification>("VertexSpecification");
     InstallConstructor<Keyboard>("Keyboard");
     InstallConstructor<Mouse>("Mouse");
     InstallConstructor<SoundBuffer>("SoundBuffer");
     InstallConstructor<SoundSource>("SoundSource");
+    InstallConstructor<StreamingSoundSource>("StreamingSoundSource");
     InstallConstructor<Timer>("Timer");
     InstallConstructor<FileWatcher>("FileWatcher");
     InstallConstructor<RenderTarget>("RenderTarget");
+    InstallConstructor<WorldStream>("WorldStream");
 
     console_.InstallAsTemplate("console", v8Template());
     fileReader_.InstallAsTemplate("file", v8Template());
+    memory_.InstallAsTemplate("memory", v8Template());
+    profiler_.InstallAsTemplate("profiler", v8Template());
+    assets_.InstallAsTemplate("assets", v8Template());
+    loader_.InstallAsTemplate("loader", v8Template());
 }
 
 void ScriptGlobal::Initialize() {
@@ -83,13 +95,14 @@ void ScriptGlobal::Require(const v8::FunctionCallbackInfo<v8::Value>& args) {
     ScriptHelper helper(args.GetIsolate());
     try {
         auto filepath = helper.GetString(args[0]);
-        auto resolved = ScriptEngine::current().resolvePath(filepath);
-        if (moduleCache.count(resolved) == 1) {
-            args.GetReturnValue().Set(moduleCache[resolved]);
+        auto id = ScriptEngine::current().ResolvePathId(filepath);
+        auto cached = moduleCache.find(id);
+        if (cached != moduleCache.end()) {
+            args.GetReturnValue().Set(cached->second);
             return;
         }
         auto result = ScriptEngine::current().Execute(filepath);
-        moduleCache[resolved].Reset(args.GetIsolate(), result);
+        moduleCache[id].Reset(args.GetIsolate(), result);
         args.GetReturnValue().Set(result);
     }
     catch (std::exception& ex) {
@@ -97,4 +110,5 @@ void ScriptGlobal::Require(const v8::FunctionCallbackInfo<v8::Value>& args) {
     }
 }
 
-std::map<std::string, v8::Persistent<v8::Value>> ScriptGlobal::moduleCache;
\ No newline at end of file
+std::unordered_map<uint32_t, v8::Persistent<v8::Value>>
+        ScriptGlobal::moduleCache;
\ No newline at end of file
@@ -26,13 +26,25 @@ SOFTWARE.*/
 #include <utils/console.h>
 #include <utils/file-reader.h>
 #include "script-object-wrap.h"
-#include <map>
+#include "script-memory.h"
+#include "script-profiler.h"
+#include <utils/asset-cache.h>
+#include <utils/asset-loader.h>
+#include <unordered_map>
 
 class ScriptGlobal : public ScriptObjectWrap<ScriptGlobal> {
 
 public:
     ScriptGlobal(v8::Isolate *isolate);
 
+    AssetCache& assets() {
+        return assets_;
+    }
+
+    AssetLoader& loader() {
+        return loader_;
+    }
+
 protected:
     void Initialize() override;
 
@@ -45,10 +57,16 @@ private:
     static void Load(const v8::FunctionCallbackInfo<v8::Value>& args);
     static void Require(const v8::FunctionCallbackInfo<v8::Value>& args);
 
-    static std::map<std::string, v8::Persistent<v8::Value>> moduleCache;
+    // The exports of required modules by the interned id of their path.
+    static std::unordered_map<uint32_t, v8::Persistent<v8::Value>>
+            moduleCache;
 
     Console console_;
     FileReader fileReader_;
+    ScriptMemory memory_;
+    ScriptProfiler profiler_;
+    AssetCache assets_;
+    AssetLoader loader_;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,54 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "script-memory.h"
+#include "script-engine.h"
+#include "scripthelper.h"
+
+using namespace v8;
+
+void ScriptMemory::Initialize() {
+    ScriptObjectWrap::Initialize();
+    SetFunction("arrayBufferStatistics", ArrayBufferStatistics);
+}
+
+void ScriptMemory::ArrayBufferStatistics(
+        const FunctionCallbackInfo<Value>& args) {
+    HandleScope scope(args.GetIsolate());
+    ScriptHelper helper(args.GetIsolate());
+
+    auto statistics = ScriptEngine::current().allocator().statistics();
+    auto result = helper.NewObject();
+    auto set = [&](std::string name, size_t value) {
+        helper.Set(result, name, Number::New(
+                args.GetIsolate(), static_cast<double>(value)));
+    };
+    set("allocations", statistics.allocations);
+    set("frees", statistics.frees);
+    set("bytesInUse", statistics.bytesInUse);
+    set("peakBytesInUse", statistics.peakBytesInUse);
+    set("slabBytes", statistics.slabBytes);
+    set("arenaHits", statistics.arenaHits);
+    set("arenaMisses", statistics.arenaMisses);
+    set("arenaBytes", statistics.arenaBytes);
+    args.GetReturnValue().Set(result);
+}
@@ -24,15 +24,27 @@ SOFTWARE.*/
 #define GAMEPLAY_SCRIPTOBJECTWRAP_H
 
 #include <v8.h>
+#include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 
 template <typename T>
 class ScriptObjectWrap {
 
 public:
+    // Types with native resources that can be released before the object is
+    // collected declares Disposable as true. They get a dispose function, and
+    // their functions and accessors throws when used after dispose.
+    static const bool Disposable = false;
+
     ScriptObjectWrap(v8::Isolate* isolate) : v8Isolate_(isolate) { }
 
     virtual ~ScriptObjectWrap() {
+        if (externalMemory_ != 0) {
+            v8Isolate_->AdjustAmountOfExternalAllocatedMemory(
+                    -externalMemory_);
+        }
         if (!v8Object_.IsEmpty()) {
             // If the v8 object isn't empty when the destructor gets called, it
             // means that the destructor wasn't triggered from the weak
@@ -73,6 +85,14 @@ public:
                          v8::FunctionTemplate::New(isolate, function));
     }
 
+    static bool HasInstance(v8::Isolate* isolate, v8::Handle<v8::Value> value) {
+        if (v8Type_.IsEmpty()) {
+            return false;
+        }
+        return v8::Local<v8::FunctionTemplate>::New(
+                isolate, v8Type_)->HasInstance(value);
+    }
+
     static T* GetInternalObject(v8::Handle<v8::Object> object) {
         auto field = v8::Handle<v8::External>::Cast(object->GetInternalField(0));
         return static_cast<T*>(field->Value());
@@ -100,25 +120,92 @@ public:
         return v8Isolate_;
     }
 
+    // Releases the native resources immediately instead of when the object is
+    // collected.
+    void Dispose() {
+        if (disposed_) {
+            return;
+        }
+        Release();
+        disposed_ = true;
+        SetExternalMemory(0);
+    }
+
+    bool disposed() const {
+        return disposed_;
+    }
+
+    // Size of the native resources reported to V8.
+    int64_t externalMemory() const {
+        return externalMemory_;
+    }
+
 protected:
+    // Releases the native resources, called at most once. Destructors of
+    // disposable types calls Dispose() to release them.
+    virtual void Release() { }
+
+    // Reports the size of the native resources to V8, which otherwise only
+    // sees the small script object and has no reason to collect it.
+    void SetExternalMemory(int64_t bytes) {
+        if (bytes != externalMemory_) {
+            v8Isolate_->AdjustAmountOfExternalAllocatedMemory(
+                    bytes - externalMemory_);
+            externalMemory_ = bytes;
+        }
+    }
+
     virtual void Initialize() {
         v8::HandleScope scope(v8Isolate_);
-        auto objectTemplate = v8::ObjectTemplate::New(v8Isolate_);
+        // The object template is taken from a function template so that it's
+        // possible to check if a value was created by this type.
+        auto typeTemplate = v8::FunctionTemplate::New(v8Isolate_);
+        auto objectTemplate = typeTemplate->InstanceTemplate();
         objectTemplate->SetInternalFieldCount(1);
+        v8Type_.Reset(v8Isolate_, typeTemplate);
         v8Template_.Reset(v8Isolate_, objectTemplate);
+        if (T::Disposable) {
+            objectTemplate->Set(
+                    v8::String::NewFromUtf8(v8Isolate_, "dispose"),
+                    v8::FunctionTemplate::New(v8Isolate_, DisposeCallback));
+        }
     }
 
     void SetFunction(std::string name, v8::FunctionCallback function) {
         v8::HandleScope scope(v8Isolate_);
+        auto functionTemplate = v8::FunctionTemplate::New(
+                v8Isolate_, function);
+        if (T::Disposable) {
+            // The function is called through a check that the object hasn't
+            // been disposed.
+            functionTemplate = v8::FunctionTemplate::New(
+                    v8Isolate_, CallUnlessDisposed,
+                    v8::Integer::New(v8Isolate_, static_cast<int>(
+                            functions_.size())));
+            functions_.push_back(function);
+        }
         v8Template()->Set(v8::String::NewFromUtf8(v8Isolate_, name.c_str()),
-                           v8::FunctionTemplate::New(v8Isolate_, function));
+                          functionTemplate);
     }
 
     void SetAccessor(std::string name, v8::AccessorGetterCallback getter,
                      v8::AccessorSetterCallback setter) {
         v8::HandleScope scope(v8Isolate_);
-        v8Template()->SetAccessor(v8::String::NewFromUtf8(
-                v8Isolate_, name.c_str()), getter, setter);
+        auto key = v8::String::NewFromUtf8(v8Isolate_, name.c_str());
+        if (T::Disposable) {
+            auto index = v8::Integer::New(
+                    v8Isolate_, static_cast<int>(accessors_.size()));
+            accessors_.push_back(std::make_pair(getter, setter));
+            v8::AccessorSetterCallback checkedSetter = NULL;
+            if (setter) {
+                checkedSetter = SetUnlessDisposed;
+            }
+            v8Template()->SetAccessor(key, GetUnlessDisposed, checkedSetter,
+                                      index);
+        }
+        else {
+            v8Template()->SetAccessor(key, getter, setter);
+        }
     }
 
     void SetIndexedPropertyHandler(v8::IndexedPropertyGetterCallback getter,
@@ -134,6 +221,44 @@ protected:
     }
 
 private:
+    static bool ThrowIfDisposed(v8::Isolate* isolate,
+                                v8::Handle<v8::Object> holder) {
+        if (!GetInternalObject(holder)->disposed_) {
+            return false;
+        }
+        isolate->ThrowException(v8::Exception::TypeError(
+                v8::String::NewFromUtf8(isolate, "Object has been disposed.")));
+        return true;
+    }
+
+    static void CallUnlessDisposed(
+            const v8::FunctionCallbackInfo<v8::Value>& args) {
+        if (!ThrowIfDisposed(args.GetIsolate(), args.Holder())) {
+            functions_[args.Data()->Int32Value()](args);
+        }
+    }
+
+    static void GetUnlessDisposed(
+            v8::Local<v8::String> name,
+            const v8::PropertyCallbackInfo<v8::Value>& args) {
+        if (!ThrowIfDisposed(args.GetIsolate(), args.Holder())) {
+            accessors_[args.Data()->Int32Value()].first(name, args);
+        }
+    }
+
+    static void SetUnlessDisposed(
+            v8::Local<v8::String> name, v8::Local<v8::Value> value,
+            const v8::PropertyCallbackInfo<void>& args) {
+        if (!ThrowIfDisposed(args.GetIsolate(), args.Holder())) {
+            accessors_[args.Data()->Int32Value()].second(name, value, args);
+        }
+    }
+
+    static void DisposeCallback(
+            const v8::FunctionCallbackInfo<v8::Value>& args) {
+        GetInternalObject(args.Holder())->Dispose();
+    }
+
     static void WeakCallback(
             const v8::WeakCallbackData<v8::Object, ScriptObjectWrap<T>>& data) {
         auto scriptObject = data.GetParameter();
@@ -143,15 +268,31 @@ private:
 
     v8::Persistent<v8::Object> v8Object_;
     v8::Isolate* v8Isolate_;
+    int64_t externalMemory_ = 0;
+    bool disposed_ = false;
 
     static v8::Persistent<v8::ObjectTemplate> v8Template_;
+    static v8::Persistent<v8::FunctionTemplate> v8Type_;
     static v8::Persistent<v8::FunctionTemplate> v8Constructor_;
+    static std::vector<v8::FunctionCallback> functions_;
+    static std::vector<std::pair<v8::AccessorGetterCallback,
+                                 v8::AccessorSetterCallback>> accessors_;
 };
 
 template <typename T>
 v8::Persistent<v8::ObjectTemplate> ScriptObjectWrap<T>::v8Template_;
 
+template <typename T>
+v8::Persistent<v8::FunctionTemplate> ScriptObjectWrap<T>::v8Type_;
+
 template <typename T>
 v8::Persistent<v8::FunctionTemplate> ScriptObjectWrap<T>::v8Constructor_;
 
+template <typename T>
+std::vector<v8::FunctionCallback> ScriptObjectWrap<T>::functions_;
+
+template <typename T>
+std::vector<std::pair<v8::AccessorGetterCallback, v8::AccessorSetterCallback>>
+        ScriptObjectWrap<T>::accessors_;
+
 #endif // GAMEPLAY_SCRIPTOBJECTWRAP_H
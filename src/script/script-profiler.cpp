@@ -0,0 +1,112 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "script-profiler.h"
+#include "script-engine.h"
+#include "scripthelper.h"
+
+using namespace v8;
+
+void ScriptProfiler::Initialize() {
+    ScriptObjectWrap::Initialize();
+    SetFunction("frameStatistics", FrameStatistics);
+    SetFunction("gcStatistics", GCStatistics);
+}
+
+void ScriptProfiler::FrameStatistics(
+        const FunctionCallbackInfo<Value>& args) {
+    auto isolate = args.GetIsolate();
+    HandleScope scope(isolate);
+    ScriptHelper helper(isolate);
+
+    auto& engine = ScriptEngine::current();
+    auto& frameTimes = engine.frameTimes();
+    auto buckets = Array::New(isolate, frameTimes.buckets().size());
+    for (size_t i = 0; i < frameTimes.buckets().size(); i++) {
+        buckets->Set(i, Integer::New(isolate, frameTimes.buckets()[i]));
+    }
+
+    auto result = helper.NewObject();
+    helper.SetInt32(result, "frames", frameTimes.count());
+    helper.Set(result, "mean", Number::New(isolate, frameTimes.mean()));
+    helper.Set(result, "p50", Number::New(
+            isolate, frameTimes.Percentile(0.5)));
+    helper.Set(result, "p95", Number::New(
+            isolate, frameTimes.Percentile(0.95)));
+    helper.Set(result, "p99", Number::New(
+            isolate, frameTimes.Percentile(0.99)));
+    helper.Set(result, "max", Number::New(isolate, frameTimes.max()));
+    helper.Set(result, "histogram", buckets);
+    helper.Set(result, "idleTime", Number::New(isolate, engine.idleTime()));
+    args.GetReturnValue().Set(result);
+}
+
+void ScriptProfiler::GCStatistics(const FunctionCallbackInfo<Value>& args) {
+    auto isolate = args.GetIsolate();
+    HandleScope scope(isolate);
+    ScriptHelper helper(isolate);
+
+    auto& tracker = ScriptEngine::current().gcTracker();
+    auto number = [&](Handle<Object> object, std::string name, double value) {
+        helper.Set(object, name, Number::New(isolate, value));
+    };
+
+    auto collections = helper.NewObject();
+    for (auto type : tracker.types()) {
+        auto& counter = tracker.counter(type);
+        auto collection = helper.NewObject();
+        number(collection, "count", counter.count);
+        number(collection, "time", counter.time);
+        number(collection, "maxPause", counter.maxPause);
+        helper.Set(collections, ScriptGCTracker::TypeName(type), collection);
+    }
+
+    auto recent = Array::New(isolate, tracker.records().size());
+    for (size_t i = 0; i < tracker.records().size(); i++) {
+        auto& record = tracker.records()[i];
+        auto item = helper.NewObject();
+        helper.Set(item, "type", String::NewFromUtf8(
+                isolate, ScriptGCTracker::TypeName(record.type)));
+        number(item, "start", record.start);
+        number(item, "duration", record.duration);
+        number(item, "heapBefore", record.heapBefore);
+        number(item, "heapAfter", record.heapAfter);
+        helper.Set(item, "idle", Boolean::New(isolate, record.idle));
+        helper.SetInt32(item, "frame", record.frame);
+        recent->Set(i, item);
+    }
+
+    auto& frameTimes = tracker.frameTimes();
+    auto perFrame = helper.NewObject();
+    number(perFrame, "mean", frameTimes.mean());
+    number(perFrame, "p95", frameTimes.Percentile(0.95));
+    number(perFrame, "max", frameTimes.max());
+
+    auto result = helper.NewObject();
+    number(result, "time", tracker.time());
+    number(result, "idleTime", tracker.idleTime());
+    number(result, "lastFrameTime", tracker.lastFrameTime());
+    helper.Set(result, "perFrame", perFrame);
+    helper.Set(result, "collections", collections);
+    helper.Set(result, "recent", recent);
+    args.GetReturnValue().Set(result);
+}
@@ -0,0 +1,170 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "script-snapshot.h"
+#include <utils/file-reader.h>
+#include <utils/path-helper.h>
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <set>
+#include <vector>
+
+namespace {
+
+// Evaluates the modules in the snapshot. A module is evaluated with the
+// modules it requires, modules that fails (e.g. uses native bindings when
+// loaded) are evaluated when required at runtime instead.
+const char* SnapshotLoader = R"JS(
+var exports = {};
+var objects = {};
+function resolve(dir, path) {
+    var parts = (dir + path).split('/');
+    var result = [];
+    for (var i = 0; i < parts.length; i++) {
+        if (parts[i] === '..') {
+            result.pop();
+        } else if (parts[i] !== '.' && parts[i] !== '') {
+            result.push(parts[i]);
+        }
+    }
+    var key = result.join('/');
+    return /\.js$/.test(key) ? key : key + '.js';
+}
+function load(key) {
+    if (exports.hasOwnProperty(key)) {
+        return exports[key];
+    }
+    if (!modules.hasOwnProperty(key)) {
+        throw new Error("Module '" + key + "' is not in the snapshot");
+    }
+    var dir = key.substring(0, key.lastIndexOf('/') + 1);
+    var module = {
+        exports: {}, path: dir, filename: key.substring(dir.length)
+    };
+    exports[key] = module.exports;
+    objects[key] = module;
+    try {
+        modules[key](module, module.exports, function (path) {
+            return load(resolve(dir, path));
+        });
+    } catch (error) {
+        delete exports[key];
+        delete objects[key];
+        throw error;
+    }
+    return exports[key] = module.exports;
+}
+for (var key in modules) {
+    try {
+        load(key);
+    } catch (error) {
+    }
+}
+// Sets the path of the evaluated modules, root is the path of the snapshot
+// directory relative to the execution path.
+function setRoot(root) {
+    for (var key in objects) {
+        var dir = key.substring(0, key.lastIndexOf('/'));
+        objects[key].path = dir ? root + '/' + dir : root;
+    }
+}
+return { modules: modules, exports: exports, setRoot: setRoot };
+})();
+)JS";
+
+std::string AddExtension(std::string filepath) {
+    if (!PathHelper::FileNameEndsWith(filepath, ".js")) {
+        filepath += ".js";
+    }
+    return filepath;
+}
+
+}
+
+ScriptSnapshot::ScriptSnapshot(std::string filename) :
+        file_(new MemoryMappedFile(filename)) {
+    data_.data = reinterpret_cast<const char*>(file_->data());
+    data_.raw_size = static_cast<int>(file_->size());
+    path_ = PathHelper::GetPath(PathHelper::Normalize(filename));
+}
+
+void ScriptSnapshot::Create(std::string entry, std::string output) {
+    entry = PathHelper::Normalize(AddExtension(entry));
+    auto root = PathHelper::GetPath(entry);
+
+    // Only the modules required with a relative path are included, they can
+    // be found by scanning the source.
+    std::regex requirePattern(
+            "require\\(\\s*[\"'](\\.{1,2}/[^\"']+)[\"']\\s*\\)");
+    std::vector<std::string> pending { entry };
+    std::set<std::string> included;
+    std::string source = "var __snapshot = (function () {\nvar modules = {};\n";
+    while (!pending.empty()) {
+        auto filepath = pending.back();
+        pending.pop_back();
+        if (included.count(filepath) == 1) {
+            continue;
+        }
+        if (filepath.compare(0, root.length(), root) != 0) {
+            std::cout << "Skipping " << filepath <<
+                    " (outside snapshot directory)" << std::endl;
+            continue;
+        }
+        included.insert(filepath);
+        auto text = FileReader::ReadAsText(filepath);
+        auto key = filepath.substr(root.length());
+        source += "modules[\"" + key + "\"] = function (module, exports, "
+                "require) { " + text + "\n};\n";
+
+        auto path = PathHelper::GetPath(filepath);
+        for (std::sregex_iterator match(text.begin(), text.end(),
+                                        requirePattern), end;
+             match != end; ++match) {
+            pending.push_back(PathHelper::Normalize(
+                    AddExtension(path + (*match)[1].str())));
+        }
+    }
+    source += SnapshotLoader;
+
+    auto data = v8::V8::CreateSnapshotDataBlob(source.c_str());
+    if (data.data == NULL) {
+        throw std::runtime_error("Failed to create snapshot from '" +
+                                 entry + "'");
+    }
+    std::ofstream file(output, std::ios::binary);
+    file.write(data.data, data.raw_size);
+    delete[] data.data;
+    if (!file) {
+        throw std::runtime_error("Failed to write snapshot '" + output + "'");
+    }
+    std::cout << "Created snapshot " << output << " with " <<
+            included.size() << " modules" << std::endl;
+}
+
+std::string ScriptSnapshot::GetModuleKey(std::string resolvedPath) {
+    resolvedPath = PathHelper::Normalize(resolvedPath);
+    if (resolvedPath.compare(0, path_.length(), path_) != 0) {
+        return "";
+    }
+    return resolvedPath.substr(path_.length());
+}
@@ -0,0 +1,57 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef GAMEPLAY_SCRIPTSNAPSHOT_H
+#define GAMEPLAY_SCRIPTSNAPSHOT_H
+
+#include "v8.h"
+#include <memory>
+#include <string>
+#include <utils/memory-mapped-file.h>
+
+// A startup snapshot with the modules reachable from an entry script (e.g.
+// lib/lib.js). Modules that can be evaluated without native bindings are
+// evaluated when the snapshot is created, the other modules are stored as
+// functions that are called when required.
+class ScriptSnapshot {
+
+public:
+    ScriptSnapshot(std::string filename);
+
+    // Creates a snapshot with the entry script and the modules it requires
+    // using relative paths, and writes it to the output file.
+    static void Create(std::string entry, std::string output);
+
+    // Returns the key of the module in the snapshot, or an empty string when
+    // the module isn't in the snapshot.
+    std::string GetModuleKey(std::string resolvedPath);
+
+    v8::StartupData* data() { return &data_; }
+
+private:
+    std::unique_ptr<MemoryMappedFile> file_;
+    v8::StartupData data_;
+    // Directory the module keys are relative to.
+    std::string path_;
+};
+
+#endif // GAMEPLAY_SCRIPTSNAPSHOT_H
@@ -0,0 +1,309 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "asset-cache.h"
+#include "virtual-file-system.h"
+#include <script/script-engine.h>
+#include <script/script-global.h>
+#include <script/scripthelper.h>
+#include <graphics/graphics-device.h>
+#include <graphics/shader-program.h>
+#include <graphics/texture-font.h>
+#include <graphics/texture2d.h>
+#include <audio/sound-buffer.h>
+#include <algorithm>
+#include <sstream>
+
+using namespace v8;
+
+namespace {
+
+struct AssetType {
+    // Name of the global constructor used to load the asset.
+    const char* name;
+    bool (*disposed)(Local<Object> object);
+    int64_t (*memory)(Local<Object> object);
+    void (*dispose)(Local<Object> object);
+};
+
+template <typename T>
+struct AssetTypeOf {
+    static bool Disposed(Local<Object> object) {
+        return T::GetInternalObject(object)->disposed();
+    }
+    static int64_t Memory(Local<Object> object) {
+        return T::GetInternalObject(object)->externalMemory();
+    }
+    static void Dispose(Local<Object> object) {
+        T::GetInternalObject(object)->Dispose();
+    }
+};
+
+template <typename T>
+AssetType MakeAssetType(const char* name) {
+    return { name, &AssetTypeOf<T>::Disposed, &AssetTypeOf<T>::Memory,
+             &AssetTypeOf<T>::Dispose };
+}
+
+const AssetType AssetTypes[] = {
+    MakeAssetType<Texture2D>("Texture2D"),
+    MakeAssetType<SoundBuffer>("SoundBuffer"),
+    MakeAssetType<TextureFont>("TextureFont"),
+    MakeAssetType<ShaderProgram>("ShaderProgram"),
+};
+
+// The options are part of the key, the same file loaded with different
+// options are different assets.
+std::string OptionsKey(Isolate* isolate, Local<Value> value) {
+    if (!value->IsObject()) {
+        return "";
+    }
+    auto options = value->ToObject();
+    auto names = options->GetOwnPropertyNames();
+    std::vector<std::string> pairs;
+    for (uint32_t i = 0; i < names->Length(); i++) {
+        auto name = names->Get(i);
+        pairs.push_back(std::string(*String::Utf8Value(name)) + "=" +
+                        *String::Utf8Value(options->Get(name)));
+    }
+    std::sort(pairs.begin(), pairs.end());
+    std::string key;
+    for (auto& pair : pairs) {
+        key += "\n" + pair;
+    }
+    return key;
+}
+
+}
+
+AssetWatch::AssetWatch(std::string filename, bool* stale) :
+        FileWatcherEventHandler(filename), stale_(stale) {
+    FileWatcher::AddEventHandler(this);
+}
+
+AssetWatch::~AssetWatch() {
+    FileWatcher::RemoveEventHandler(this);
+}
+
+AssetCache::~AssetCache() {
+    for (auto& entry : entries_) {
+        entry->object.Reset();
+    }
+}
+
+void AssetCache::Initialize() {
+    ScriptObjectWrap::Initialize();
+    SetFunction("texture", Texture);
+    SetFunction("sound", Sound);
+    SetFunction("font", Font);
+    SetFunction("shader", Shader);
+    SetFunction("release", Release);
+    SetFunction("statistics", Statistics);
+}
+
+void AssetCache::Texture(const FunctionCallbackInfo<Value>& args) {
+    HandleScope scope(args.GetIsolate());
+    ScriptHelper helper(args.GetIsolate());
+    auto filename = ScriptEngine::current().resolvePath(
+            helper.GetString(args[0]));
+    ScriptEngine::current().global().assets().Load(
+            args, TextureAsset, filename, { filename });
+}
+
+void AssetCache::Sound(const FunctionCallbackInfo<Value>& args) {
+    HandleScope scope(args.GetIsolate());
+    ScriptHelper helper(args.GetIsolate());
+    auto filename = ScriptEngine::current().resolvePath(
+            helper.GetString(args[0]));
+    ScriptEngine::current().global().assets().Load(
+            args, SoundAsset, filename, { filename });
+}
+
+void AssetCache::Font(const FunctionCallbackInfo<Value>& args) {
+    HandleScope scope(args.GetIsolate());
+    ScriptHelper helper(args.GetIsolate());
+    auto options = helper.GetObject(args[0]);
+    auto filename = ScriptEngine::current().resolvePath(
+            helper.GetString(options, "filename"));
+    ScriptEngine::current().global().assets().Load(
+            args, FontAsset, filename + OptionsKey(args.GetIsolate(), args[0]),
+            { filename });
+}
+
+void AssetCache::Shader(const FunctionCallbackInfo<Value>& args) {
+    HandleScope scope(args.GetIsolate());
+    ScriptHelper helper(args.GetIsolate());
+    // Programs are only shared by the same graphics device.
+    auto graphicsDevice = helper.GetObject<GraphicsDevice>(args[0]);
+    auto path = ScriptEngine::current().resolvePath(
+            helper.GetString(args[1]));
+    if (!path.empty() && path.back() != '/') {
+        path += "/";
+    }
+    std::ostringstream key;
+    key << path << "\n" << graphicsDevice;
+    std::vector<std::string> files {
+        path + "vertex.glsl", path + "fragment.glsl" };
+    if (VirtualFileSystem::current().Exists(path + "geometry.glsl")) {
+        files.push_back(path + "geometry.glsl");
+    }
+    ScriptEngine::current().global().assets().Load(
+            args, ShaderAsset, key.str(), files);
+}
+
+Local<Object> AssetCache::Acquire(int kind, std::string key) {
+    auto isolate = v8Isolate();
+    auto& assetType = AssetTypes[kind];
+    auto cached = cache_.find(std::string(assetType.name) + "\n" + key);
+    if (cached == cache_.end()) {
+        return Local<Object>();
+    }
+    auto entry = cached->second;
+    auto object = Local<Object>::New(isolate, entry->object);
+    if (!entry->stale && !assetType.disposed(object)) {
+        entry->references++;
+        return object;
+    }
+    // The asset is loaded again, the old one is kept until released.
+    cache_.erase(cached);
+    return Local<Object>();
+}
+
+void AssetCache::Add(int kind, std::string key, Local<Object> object,
+                     std::vector<std::string> files) {
+    std::unique_ptr<Entry> entry(new Entry());
+    entry->key = std::string(AssetTypes[kind].name) + "\n" + key;
+    entry->kind = kind;
+    entry->object.Reset(v8Isolate(), object);
+    entry->object.SetWeak(entry.get(), Collected);
+    entry->object.MarkIndependent();
+    entry->references = 1;
+    entry->stale = false;
+    for (auto& file : files) {
+        entry->watches.push_back(std::unique_ptr<AssetWatch>(
+                new AssetWatch(file, &entry->stale)));
+    }
+    cache_[entry->key] = entry.get();
+    entries_.push_back(std::move(entry));
+}
+
+void AssetCache::ReleaseAsset(Local<Value> asset) {
+    for (auto& entry : entries_) {
+        if (entry->object != asset) {
+            continue;
+        }
+        if (--entry->references == 0) {
+            auto object = Local<Object>::New(v8Isolate(), entry->object);
+            AssetTypes[entry->kind].dispose(object);
+            Remove(entry.get());
+        }
+        return;
+    }
+}
+
+void AssetCache::Load(const FunctionCallbackInfo<Value>& args, int kind,
+                      std::string key, std::vector<std::string> files) {
+    auto isolate = args.GetIsolate();
+    auto cached = Acquire(kind, key);
+    if (!cached.IsEmpty()) {
+        args.GetReturnValue().Set(cached);
+        return;
+    }
+
+    auto context = isolate->GetCurrentContext();
+    auto constructor = Local<Function>::Cast(context->Global()->Get(
+            String::NewFromUtf8(isolate, AssetTypes[kind].name)));
+    std::vector<Local<Value>> arguments;
+    for (int i = 0; i < args.Length(); i++) {
+        arguments.push_back(args[i]);
+    }
+    Local<Object> object;
+    if (!constructor->NewInstance(
+            context, static_cast<int>(arguments.size()),
+            arguments.data()).ToLocal(&object)) {
+        // The exception from the constructor is passed on.
+        return;
+    }
+    Add(kind, key, object, files);
+    args.GetReturnValue().Set(object);
+}
+
+void AssetCache::Release(const FunctionCallbackInfo<Value>& args) {
+    HandleScope scope(args.GetIsolate());
+    auto self = &ScriptEngine::current().global().assets();
+    if (!args[0]->IsObject()) {
+        ScriptEngine::current().ThrowTypeError(
+                "AssetCache: Expected an asset to release.");
+        return;
+    }
+    self->ReleaseAsset(args[0]);
+}
+
+void AssetCache::Remove(Entry* entry) {
+    auto cached = cache_.find(entry->key);
+    if (cached != cache_.end() && cached->second == entry) {
+        cache_.erase(cached);
+    }
+    entry->object.Reset();
+    entries_.erase(std::find_if(
+            entries_.begin(), entries_.end(),
+            [entry](const std::unique_ptr<Entry>& e) {
+                return e.get() == entry;
+            }));
+}
+
+void AssetCache::Collected(
+        const v8::WeakCallbackData<v8::Object, Entry>& data) {
+    // Also removes stale entries which were replaced by a reload.
+    ScriptEngine::current().global().assets().Remove(data.GetParameter());
+}
+
+void AssetCache::Statistics(const FunctionCallbackInfo<Value>& args) {
+    auto isolate = args.GetIsolate();
+    HandleScope scope(isolate);
+    ScriptHelper helper(isolate);
+    auto self = &ScriptEngine::current().global().assets();
+
+    auto result = helper.NewObject();
+    for (auto& assetType : AssetTypes) {
+        int assets = 0;
+        int references = 0;
+        int64_t bytes = 0;
+        for (auto& entry : self->entries_) {
+            if (&AssetTypes[entry->kind] != &assetType) {
+                continue;
+            }
+            auto object = Local<Object>::New(isolate, entry->object);
+            assets++;
+            references += entry->references;
+            bytes += assetType.memory(object);
+        }
+        auto statistics = helper.NewObject();
+        helper.Set(statistics, "assets", Integer::New(isolate, assets));
+        helper.Set(statistics, "references",
+                   Integer::New(isolate, references));
+        helper.Set(statistics, "bytes",
+                   Number::New(isolate, static_cast<double>(bytes)));
+        helper.Set(result, assetType.name, statistics);
+    }
+    args.GetReturnValue().Set(result);
+}
@@ -0,0 +1,108 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef GAMEPLAY_ASSETCACHE_H
+#define GAMEPLAY_ASSETCACHE_H
+
+#include <script/script-object-wrap.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "file-watcher.h"
+
+// Marks a cached asset as stale when its file is changed.
+class AssetWatch : public FileWatcherEventHandler {
+
+public:
+    AssetWatch(std::string filename, bool* stale);
+    ~AssetWatch();
+
+    void Handle() override {
+        *stale_ = true;
+    }
+
+private:
+    bool* stale_;
+};
+
+enum AssetKind { TextureAsset, SoundAsset, FontAsset, ShaderAsset };
+
+// Shares assets (textures, sounds, fonts and shaders) loaded from the same
+// files with the same options, exposed to scripts as the global "assets"
+// object. Each load of a cached asset adds a reference, the asset is disposed
+// when all references have been released. Assets whose files are changed are
+// loaded again the next time, the old object stays valid until released.
+// The assets are held weakly, an asset which scripts no longer reference is
+// removed from the cache when it's collected even if it was never released.
+// The global "assets" object is created from the template and has no internal
+// object, the cache is owned by the script global.
+class AssetCache : public ScriptObjectWrap<AssetCache> {
+
+public:
+    AssetCache(v8::Isolate* isolate) : ScriptObjectWrap(isolate) { }
+    ~AssetCache();
+
+    // Returns the cached asset with one more reference, or an empty handle
+    // when it isn't cached.
+    v8::Local<v8::Object> Acquire(int kind, std::string key);
+    // Adds an asset loaded elsewhere with one reference.
+    void Add(int kind, std::string key, v8::Local<v8::Object> object,
+             std::vector<std::string> files);
+    // Removes a reference, the asset is disposed when it was the last one.
+    void ReleaseAsset(v8::Local<v8::Value> asset);
+
+protected:
+    void Initialize() override;
+
+private:
+    struct Entry {
+        std::string key;
+        int kind;
+        // Weak, the entry is removed when the asset is collected.
+        v8::Persistent<v8::Object> object;
+        int references;
+        // The file was changed after the asset was loaded.
+        bool stale;
+        std::vector<std::unique_ptr<AssetWatch>> watches;
+    };
+
+    static void Texture(const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void Sound(const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void Font(const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void Shader(const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void Release(const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void Statistics(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+    void Load(const v8::FunctionCallbackInfo<v8::Value>& args, int kind,
+              std::string key, std::vector<std::string> files);
+    void Remove(Entry* entry);
+
+    static void Collected(
+            const v8::WeakCallbackData<v8::Object, Entry>& data);
+
+    // The current entry for each key, stale entries are replaced.
+    std::unordered_map<std::string, Entry*> cache_;
+    std::vector<std::unique_ptr<Entry>> entries_;
+};
+
+#endif // GAMEPLAY_ASSETCACHE_H
@@ -0,0 +1,417 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "asset-loader.h"
+#include "asset-cache.h"
+#include "file-reader.h"
+#include <script/script-engine.h>
+#include <script/script-global.h>
+#include <script/scripthelper.h>
+#include <algorithm>
+#include <chrono>
+
+using namespace v8;
+
+namespace {
+
+Local<Value> NewError(Isolate* isolate, std::string message) {
+    return Exception::Error(String::NewFromUtf8(isolate, message.c_str()));
+}
+
+}
+
+AssetLoader::~AssetLoader() {
+    for (auto& group : groups_) {
+        group.second->cancelled = true;
+        group.second->resolver.Reset();
+        for (auto& item : group.second->items) {
+            item->arguments.Reset();
+            item->asset.Reset();
+        }
+    }
+}
+
+void AssetLoader::Initialize() {
+    ScriptObjectWrap::Initialize();
+    SetFunction("load", Load);
+    SetFunction("progress", Progress);
+    SetFunction("cancel", Cancel);
+    SetAccessor("budget", GetBudget, SetBudget);
+}
+
+int AssetLoader::Update() {
+    if (ready_.empty()) {
+        return 0;
+    }
+    HandleScope scope(v8Isolate());
+    std::stable_sort(ready_.begin(), ready_.end(), [](Item* a, Item* b) {
+        return a->group->priority > b->group->priority;
+    });
+    auto start = std::chrono::steady_clock::now();
+    int completed = 0;
+    // At least one asset is created each frame, loading progresses even when
+    // a single asset takes longer than the budget.
+    while (!ready_.empty()) {
+        auto item = ready_.front();
+        ready_.erase(ready_.begin());
+        if (Create(item)) {
+            completed++;
+        }
+        std::chrono::duration<double, std::milli> elapsed =
+                std::chrono::steady_clock::now() - start;
+        if (elapsed.count() >= budget_) {
+            break;
+        }
+    }
+    return completed;
+}
+
+void AssetLoader::Post(std::shared_ptr<Group> group, Item* item) {
+    // Called on a background thread, the group is kept alive by the task.
+    auto work = [group, item] {
+        if (group->cancelled) {
+            return;
+        }
+        try {
+            switch (item->kind) {
+                case ItemKind::Texture:
+                    item->image = Texture2D::Decode(item->path);
+                    break;
+                case ItemKind::Sound:
+                    item->samples = SoundBuffer::Decode(item->path);
+                    break;
+                default:
+                    item->text = FileReader::ReadAsText(item->path);
+                    break;
+            }
+        }
+        catch (std::exception& ex) {
+            item->error = ex.what();
+        }
+    };
+    auto completion = [this, group, item] {
+        if (!group->cancelled) {
+            ready_.push_back(item);
+        }
+    };
+    // Decoding is bound by the CPU rather than by reading the file.
+    auto& pool = item->kind == ItemKind::Texture ||
+                 item->kind == ItemKind::Sound ?
+            ScriptEngine::current().workerThreadPool() :
+            ScriptEngine::current().ioThreadPool();
+    pool.Post(work, completion, group->priority);
+}
+
+bool AssetLoader::Create(Item* item) {
+    auto isolate = v8Isolate();
+    auto context = isolate->GetCurrentContext();
+    auto& assets = ScriptEngine::current().global().assets();
+    auto group = item->group;
+    if (!item->error.empty()) {
+        Fail(group, NewError(isolate, item->error));
+        return true;
+    }
+
+    TryCatch tryCatch;
+    Local<Value> asset;
+    try {
+        switch (item->kind) {
+            case ItemKind::Texture: {
+                // The texture may have been loaded by another group meanwhile.
+                auto texture = assets.Acquire(TextureAsset, item->path);
+                if (texture.IsEmpty()) {
+                    texture = (new Texture2D(isolate, item->image))->v8Object();
+                    assets.Add(TextureAsset, item->path, texture,
+                               { item->path });
+                }
+                asset = texture;
+                break;
+            }
+            case ItemKind::Sound: {
+                auto sound = assets.Acquire(SoundAsset, item->path);
+                if (sound.IsEmpty()) {
+                    sound = (new SoundBuffer(isolate, item->samples))
+                            ->v8Object();
+                    assets.Add(SoundAsset, item->path, sound, { item->path });
+                }
+                asset = sound;
+                break;
+            }
+            case ItemKind::Font:
+            case ItemKind::Shader: {
+                // Created through the asset cache functions, which computes
+                // the keys from the same arguments.
+                auto cache = context->Global()->Get(
+                        String::NewFromUtf8(isolate, "assets"))->ToObject();
+                auto function = Local<Function>::Cast(cache->Get(
+                        String::NewFromUtf8(isolate,
+                        item->kind == ItemKind::Font ? "font" : "shader")));
+                auto arguments = Local<Array>::New(isolate, item->arguments);
+                std::vector<Local<Value>> argv;
+                for (uint32_t i = 0; i < arguments->Length(); i++) {
+                    argv.push_back(arguments->Get(i));
+                }
+                if (!function->Call(context, cache,
+                                    static_cast<int>(argv.size()),
+                                    argv.data()).ToLocal(&asset)) {
+                    Fail(group, tryCatch.Exception());
+                    return true;
+                }
+                break;
+            }
+            case ItemKind::Json: {
+                auto text = String::NewFromUtf8(
+                        isolate, item->text.c_str(), String::kNormalString,
+                        static_cast<int>(item->text.size()));
+                if (!JSON::Parse(isolate, text).ToLocal(&asset)) {
+                    Fail(group, tryCatch.Exception());
+                    return true;
+                }
+                break;
+            }
+        }
+    }
+    catch (std::exception& ex) {
+        Fail(group, NewError(isolate, ex.what()));
+        return true;
+    }
+
+    // The decoded data has been uploaded and isn't needed anymore.
+    item->image = Texture2D::Image();
+    item->samples = SoundBuffer::Samples();
+    std::string().swap(item->text);
+    item->asset.Reset(isolate, asset);
+    item->loaded = true;
+    if (++group->loaded < static_cast<int>(group->items.size())) {
+        return false;
+    }
+    Loaded(group);
+    return true;
+}
+
+void AssetLoader::Loaded(Group* group) {
+    auto isolate = v8Isolate();
+    auto context = isolate->GetCurrentContext();
+    auto result = Array::New(isolate, static_cast<int>(group->items.size()));
+    for (uint32_t i = 0; i < group->items.size(); i++) {
+        result->Set(i, Local<Value>::New(isolate, group->items[i]->asset));
+    }
+    auto resolver = Local<Promise::Resolver>::New(isolate, group->resolver);
+    Remove(group);
+    resolver->Resolve(context, result).FromMaybe(false);
+}
+
+void AssetLoader::Fail(Group* group, Local<Value> error) {
+    auto isolate = v8Isolate();
+    auto context = isolate->GetCurrentContext();
+    // The assets which were already loaded are released, a group is either
+    // loaded completely or not at all.
+    auto& assets = ScriptEngine::current().global().assets();
+    for (auto& item : group->items) {
+        if (item->loaded) {
+            assets.ReleaseAsset(Local<Value>::New(isolate, item->asset));
+        }
+    }
+    auto resolver = Local<Promise::Resolver>::New(isolate, group->resolver);
+    Remove(group);
+    resolver->Reject(context, error).FromMaybe(false);
+}
+
+void AssetLoader::Remove(Group* group) {
+    group->cancelled = true;
+    ready_.erase(std::remove_if(ready_.begin(), ready_.end(),
+                                [group](Item* item) {
+                                    return item->group == group;
+                                }), ready_.end());
+    group->resolver.Reset();
+    for (auto& item : group->items) {
+        item->arguments.Reset();
+        item->asset.Reset();
+    }
+    // The group is deleted here unless there is still work for it on the
+    // background threads.
+    groups_.erase(group->name);
+}
+
+void AssetLoader::Load(const FunctionCallbackInfo<Value>& args) {
+    auto isolate = args.GetIsolate();
+    HandleScope scope(isolate);
+    ScriptHelper helper(isolate);
+    auto self = &ScriptEngine::current().global().loader();
+    auto context = isolate->GetCurrentContext();
+
+    std::shared_ptr<Group> group(new Group());
+    group->name = helper.GetString(args[0]);
+    group->priority = helper.GetInteger(args[2], 0);
+    if (self->groups_.find(group->name) != self->groups_.end()) {
+        ScriptEngine::current().ThrowTypeError(
+                "AssetLoader: '" + group->name + "' is already loading.");
+        return;
+    }
+    if (!args[1]->IsArray()) {
+        ScriptEngine::current().ThrowTypeError(
+                "AssetLoader: Expected an array of assets to load.");
+        return;
+    }
+
+    auto requests = Local<Array>::Cast(args[1]);
+    for (uint32_t i = 0; i < requests->Length(); i++) {
+        auto value = requests->Get(i);
+        if (!value->IsObject()) {
+            ScriptEngine::current().ThrowTypeError(
+                    "AssetLoader: Expected an asset to load.");
+            return;
+        }
+        auto request = value->ToObject();
+        std::unique_ptr<Item> item(new Item());
+        item->group = group.get();
+        auto has = [&](const char* name) {
+            return request->Has(String::NewFromUtf8(isolate, name));
+        };
+        auto get = [&](const char* name) {
+            return request->Get(String::NewFromUtf8(isolate, name));
+        };
+        auto path = [&](const char* name) {
+            return ScriptEngine::current().resolvePath(
+                    helper.GetString(get(name)));
+        };
+        if (has("texture")) {
+            item->kind = ItemKind::Texture;
+            item->path = path("texture");
+        }
+        else if (has("sound")) {
+            item->kind = ItemKind::Sound;
+            item->path = path("sound");
+        }
+        else if (has("json")) {
+            item->kind = ItemKind::Json;
+            item->path = path("json");
+        }
+        else if (has("font")) {
+            item->kind = ItemKind::Font;
+            auto arguments = Array::New(isolate, 1);
+            arguments->Set(0, get("font"));
+            item->arguments.Reset(isolate, arguments);
+        }
+        else if (has("shader")) {
+            item->kind = ItemKind::Shader;
+            auto arguments = Array::New(isolate, 2);
+            arguments->Set(0, get("graphics"));
+            arguments->Set(1, get("shader"));
+            item->arguments.Reset(isolate, arguments);
+        }
+        else {
+            for (auto& loaded : group->items) {
+                loaded->arguments.Reset();
+            }
+            ScriptEngine::current().ThrowTypeError(
+                    "AssetLoader: Expected a texture, sound, font, shader or "
+                    "json to load.");
+            return;
+        }
+        group->items.push_back(std::move(item));
+    }
+
+    Local<Promise::Resolver> resolver;
+    if (!Promise::Resolver::New(context).ToLocal(&resolver)) {
+        return;
+    }
+    group->resolver.Reset(isolate, resolver);
+    self->groups_[group->name] = group;
+    args.GetReturnValue().Set(resolver->GetPromise());
+
+    auto& assets = ScriptEngine::current().global().assets();
+    for (auto& item : group->items) {
+        switch (item->kind) {
+            case ItemKind::Texture:
+            case ItemKind::Sound: {
+                // Cached assets are done without any work.
+                auto cached = assets.Acquire(
+                        item->kind == ItemKind::Texture ?
+                        TextureAsset : SoundAsset, item->path);
+                if (!cached.IsEmpty()) {
+                    item->asset.Reset(isolate, cached);
+                    item->loaded = true;
+                    group->loaded++;
+                    break;
+                }
+                self->Post(group, item.get());
+                break;
+            }
+            case ItemKind::Json:
+                self->Post(group, item.get());
+                break;
+            default:
+                // Fonts and shaders are created on the main thread.
+                self->ready_.push_back(item.get());
+                break;
+        }
+    }
+    if (group->loaded == static_cast<int>(group->items.size())) {
+        self->Loaded(group.get());
+    }
+}
+
+void AssetLoader::Progress(const FunctionCallbackInfo<Value>& args) {
+    auto isolate = args.GetIsolate();
+    HandleScope scope(isolate);
+    ScriptHelper helper(isolate);
+    auto self = &ScriptEngine::current().global().loader();
+    auto found = self->groups_.find(helper.GetString(args[0]));
+    if (found == self->groups_.end()) {
+        return;
+    }
+    auto progress = helper.NewObject();
+    helper.Set(progress, "loaded",
+               Integer::New(isolate, found->second->loaded));
+    helper.Set(progress, "total", Integer::New(
+            isolate, static_cast<int>(found->second->items.size())));
+    args.GetReturnValue().Set(progress);
+}
+
+void AssetLoader::Cancel(const FunctionCallbackInfo<Value>& args) {
+    auto isolate = args.GetIsolate();
+    HandleScope scope(isolate);
+    ScriptHelper helper(isolate);
+    auto self = &ScriptEngine::current().global().loader();
+    auto name = helper.GetString(args[0]);
+    auto found = self->groups_.find(name);
+    if (found == self->groups_.end()) {
+        args.GetReturnValue().Set(false);
+        return;
+    }
+    self->Fail(found->second.get(),
+               NewError(isolate, "Loading of '" + name + "' was cancelled."));
+    args.GetReturnValue().Set(true);
+}
+
+void AssetLoader::GetBudget(Local<String> name,
+                            const PropertyCallbackInfo<Value>& args) {
+    auto self = &ScriptEngine::current().global().loader();
+    args.GetReturnValue().Set(self->budget_);
+}
+
+void AssetLoader::SetBudget(Local<String> name, Local<Value> value,
+                            const PropertyCallbackInfo<void>& args) {
+    auto self = &ScriptEngine::current().global().loader();
+    self->budget_ = std::max(0.0, value->NumberValue());
+}
@@ -0,0 +1,112 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef GAMEPLAY_ASSETLOADER_H
+#define GAMEPLAY_ASSETLOADER_H
+
+#include <script/script-object-wrap.h>
+#include <graphics/texture2d.h>
+#include <audio/sound-buffer.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Loads groups of assets (e.g. the assets of a level) in the background,
+// exposed to scripts as the global "loader" object. Files are read on the I/O
+// thread pool and images and sounds are decoded on the worker thread pool,
+// groups with higher priority first. The GL and AL objects are created on the
+// main thread when polling events, at most for the budget of milliseconds each
+// frame so loading doesn't cause hitches. The loaded assets are shared through
+// the asset cache.
+class AssetLoader : public ScriptObjectWrap<AssetLoader> {
+
+public:
+    AssetLoader(v8::Isolate* isolate) : ScriptObjectWrap(isolate) { }
+    ~AssetLoader();
+
+    // Creates the objects of decoded assets until the budget is spent,
+    // returns the number of completed groups.
+    int Update();
+
+    // True while there are decoded assets waiting to be created.
+    bool loading() const {
+        return !ready_.empty();
+    }
+
+protected:
+    void Initialize() override;
+
+private:
+    enum class ItemKind { Texture, Sound, Font, Shader, Json };
+
+    struct Group;
+
+    struct Item {
+        ItemKind kind;
+        std::string path;
+        Group* group;
+        // The arguments passed to the asset cache for fonts and shaders.
+        v8::Persistent<v8::Array> arguments;
+        Texture2D::Image image;
+        SoundBuffer::Samples samples;
+        std::string text;
+        std::string error;
+        v8::Persistent<v8::Value> asset;
+        bool loaded = false;
+    };
+
+    struct Group {
+        std::string name;
+        int priority;
+        v8::Persistent<v8::Promise::Resolver> resolver;
+        std::vector<std::unique_ptr<Item>> items;
+        int loaded = 0;
+        // Checked by the background threads to skip work of cancelled groups.
+        std::atomic<bool> cancelled { false };
+    };
+
+    static void Load(const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void Progress(const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void Cancel(const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void GetBudget(v8::Local<v8::String> name,
+                          const v8::PropertyCallbackInfo<v8::Value>& args);
+    static void SetBudget(v8::Local<v8::String> name,
+                          v8::Local<v8::Value> value,
+                          const v8::PropertyCallbackInfo<void>& args);
+
+    void Post(std::shared_ptr<Group> group, Item* item);
+    // Returns true when the group of the item has completed.
+    bool Create(Item* item);
+    void Loaded(Group* group);
+    void Fail(Group* group, v8::Local<v8::Value> error);
+    void Remove(Group* group);
+
+    // Milliseconds each frame spent creating objects.
+    double budget_ = 2;
+    std::unordered_map<std::string, std::shared_ptr<Group>> groups_;
+    // Items which are read and decoded, waiting to be created.
+    std::vector<Item*> ready_;
+};
+
+#endif // GAMEPLAY_ASSETLOADER_H
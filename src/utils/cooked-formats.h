@@ -0,0 +1,86 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef GAMEPLAY_COOKEDFORMATS_H
+#define GAMEPLAY_COOKEDFORMATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// The runtime-ready files written by gameplay-cook. They keep the names of
+// the files they were converted from, the loaders recognize them by their
+// magic and use them without decoding.
+
+const uint32_t CookedTextureMagic = 0x58455447;
+const uint32_t CookedTextureVersion = 1;
+
+// Followed by the pixels of each mipmap level, tightly packed with one byte
+// per channel. Each level is half the size of the previous one (at least one
+// pixel), down to 1x1.
+struct CookedTextureHeader {
+    uint32_t magic;
+    uint32_t version;
+    int32_t width;
+    int32_t height;
+    int32_t channels;
+    int32_t levels;
+};
+
+const uint32_t CookedSoundMagic = 0x444e5347;
+const uint32_t CookedSoundVersion = 1;
+
+// Followed by the interleaved 16-bit samples of all channels.
+struct CookedSoundHeader {
+    uint32_t magic;
+    uint32_t version;
+    int32_t channels;
+    int32_t rate;
+    int32_t count;
+};
+
+// Returns the header when the data is a cooked file of the type, or null.
+template <typename T>
+const T* GetCookedHeader(const unsigned char* data, size_t size,
+                         uint32_t magic, uint32_t version) {
+    if (size < sizeof(T)) {
+        return nullptr;
+    }
+    auto header = reinterpret_cast<const T*>(data);
+    if (header->magic != magic || header->version != version) {
+        return nullptr;
+    }
+    return header;
+}
+
+// Size in bytes of all mipmap levels of a cooked texture.
+inline size_t GetCookedTextureSize(int width, int height, int channels,
+                                   int levels) {
+    size_t size = 0;
+    for (int i = 0; i < levels; i++) {
+        size += static_cast<size_t>(width) * height * channels;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return size;
+}
+
+#endif // GAMEPLAY_COOKEDFORMATS_H
@@ -22,33 +22,180 @@ SOFTWARE.*/
 
 #include "file-reader.h"
 #include "script/scripthelper.h"
-#include <fstream>
+#include "memory-mapped-file.h"
+#include "virtual-file-system.h"
+#include <cstring>
+#include <map>
+#include <memory>
 #include <script/script-engine.h>
 
 using namespace v8;
 
-bool FileReader::Exists(std::string filename) {
-    std::ifstream file(filename);
-    if (file.good()) {
-        file.close();
-        return true;
+namespace {
+
+enum class AsyncReadType { Text, Bytes, Json };
+
+// A file being read on the I/O thread pool. The contents are read into memory
+// from the array buffer allocator, which is handed over to V8 as the backing
+// store of the resulting array buffer.
+struct AsyncRead {
+    ~AsyncRead() {
+        if (data) {
+            ScriptEngine::current().allocator().Free(data, size);
+        }
+    }
+
+    AsyncReadType type;
+    std::string filename;
+    Persistent<Promise::Resolver> resolver;
+    void* data = nullptr;
+    size_t size = 0;
+    std::string error;
+};
+
+// Reads the contents of a file into memory from the array buffer allocator,
+// which can be used as the backing store of an array buffer without copying.
+// Returns null for empty files.
+void* ReadIntoBuffer(std::string filename, size_t* size) {
+    std::unique_ptr<VirtualFile> file;
+    try {
+        file = VirtualFileSystem::current().Open(filename);
+    }
+    catch (std::exception&) {
+        throw std::runtime_error("Failed to read file '" + filename + "'");
+    }
+    *size = file->size();
+    if (*size == 0) {
+        return nullptr;
+    }
+    auto data = ScriptEngine::current().allocator().AllocateUninitialized(
+            *size);
+    if (!data) {
+        throw std::runtime_error(
+                "Failed to allocate memory for '" + filename + "'");
+    }
+    memcpy(data, file->data(), *size);
+    return data;
+}
+
+// Called on an I/O thread.
+void ReadFile(AsyncRead* read) {
+    try {
+        read->data = ReadIntoBuffer(read->filename, &read->size);
+    }
+    catch (std::exception& ex) {
+        read->size = 0;
+        read->error = ex.what();
+    }
+}
+
+// A file mapped as the memory of an array buffer, it's unmapped when the array
+// buffer is collected or explicitly unmapped.
+struct MappedBuffer {
+    std::unique_ptr<MemoryMappedFile> file;
+    Persistent<ArrayBuffer> buffer;
+};
+
+// The mapped buffers by the address of their memory.
+std::map<const void*, MappedBuffer*> mappedBuffers;
+
+void ReleaseMappedBuffer(Isolate* isolate, MappedBuffer* mapped) {
+    mappedBuffers.erase(mapped->file->data());
+    isolate->AdjustAmountOfExternalAllocatedMemory(
+            -static_cast<int64_t>(mapped->file->size()));
+    mapped->buffer.Reset();
+    delete mapped;
+}
+
+void MappedBufferCollected(const WeakCallbackInfo<MappedBuffer>& data) {
+    ReleaseMappedBuffer(data.GetIsolate(), data.GetParameter());
+}
+
+// Called on the main thread when the file has been read.
+void ResolveRead(Isolate* isolate, AsyncRead* read) {
+    HandleScope scope(isolate);
+    auto context = isolate->GetCurrentContext();
+    auto resolver = Local<Promise::Resolver>::New(isolate, read->resolver);
+    read->resolver.Reset();
+    if (!read->error.empty()) {
+        resolver->Reject(context, Exception::Error(String::NewFromUtf8(
+                isolate, read->error.c_str()))).FromMaybe(false);
+        return;
+    }
+    if (read->type == AsyncReadType::Bytes) {
+        auto buffer = read->data ?
+                ArrayBuffer::New(isolate, read->data, read->size,
+                                 ArrayBufferCreationMode::kInternalized) :
+                ArrayBuffer::New(isolate, 0);
+        // V8 owns the memory now.
+        read->data = nullptr;
+        resolver->Resolve(context, buffer).FromMaybe(false);
+        return;
     }
-    return false;
+    auto text = String::NewFromUtf8(
+            isolate, static_cast<const char*>(read->data),
+            String::kNormalString, static_cast<int>(read->size));
+    if (read->type == AsyncReadType::Text) {
+        resolver->Resolve(context, text).FromMaybe(false);
+        return;
+    }
+    TryCatch tryCatch;
+    Local<Value> json;
+    if (!JSON::Parse(isolate, text).ToLocal(&json)) {
+        resolver->Reject(context, tryCatch.Exception()).FromMaybe(false);
+        return;
+    }
+    resolver->Resolve(context, json).FromMaybe(false);
+}
+
+void ReadAsync(const v8::FunctionCallbackInfo<v8::Value>& args,
+               AsyncReadType type) {
+    auto isolate = args.GetIsolate();
+    HandleScope scope(isolate);
+    ScriptHelper helper(isolate);
+    Local<Promise::Resolver> resolver;
+    if (!Promise::Resolver::New(isolate->GetCurrentContext()).ToLocal(
+            &resolver)) {
+        return;
+    }
+    std::shared_ptr<AsyncRead> read(new AsyncRead());
+    read->type = type;
+    read->filename = ScriptEngine::current().resolvePath(
+            helper.GetString(args[0]));
+    read->resolver.Reset(isolate, resolver);
+    ScriptEngine::current().ioThreadPool().Post(
+        [read] { ReadFile(read.get()); },
+        [isolate, read] { ResolveRead(isolate, read.get()); });
+    args.GetReturnValue().Set(resolver->GetPromise());
+}
+
+}
+
+bool FileReader::Exists(std::string filename) {
+    return VirtualFileSystem::current().Exists(filename);
 }
 
 std::string FileReader::ReadAsText(std::string filename) {
-    std::ifstream in { filename };
-    if (!in) {
-      throw std::runtime_error("Failed to read file '" + filename + "'");
+    std::unique_ptr<VirtualFile> file;
+    try {
+        file = VirtualFileSystem::current().Open(filename);
+    }
+    catch (std::exception&) {
+        throw std::runtime_error("Failed to read file '" + filename + "'");
     }
-    std::string contents((std::istreambuf_iterator<char>(in)),
-                         std::istreambuf_iterator<char>());
-    return contents;
+    return std::string(reinterpret_cast<const char*>(file->data()),
+                       file->size());
 }
 
 void FileReader::Initialize() {
     ScriptObjectWrap::Initialize();
     SetFunction("readText", ReadText);
+    SetFunction("readBytes", ReadBytes);
+    SetFunction("mapBytes", MapBytes);
+    SetFunction("unmap", Unmap);
+    SetFunction("readTextAsync", ReadTextAsync);
+    SetFunction("readBytesAsync", ReadBytesAsync);
+    SetFunction("readJsonAsync", ReadJsonAsync);
 }
 
 void FileReader::ReadText(const v8::FunctionCallbackInfo<v8::Value>& args) {
@@ -57,11 +204,104 @@ void FileReader::ReadText(const v8::FunctionCallbackInfo<v8::Value>& args) {
     auto filename = ScriptEngine::current().resolvePath(
             helper.GetString(args[0]));
     try {
-        auto text = FileReader::ReadAsText(filename);
+        // The string is created directly from the mapped file, the contents
+        // are only copied once.
+        auto file = VirtualFileSystem::current().Open(filename);
         args.GetReturnValue().Set(v8::String::NewFromUtf8(
-                args.GetIsolate(), text.c_str()));
+                args.GetIsolate(), reinterpret_cast<const char*>(file->data()),
+                v8::String::kNormalString, static_cast<int>(file->size())));
+    }
+    catch (std::exception& ex) {
+        ScriptEngine::current().ThrowTypeError(ex.what());
+    }
+}
+
+void FileReader::ReadBytes(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    auto isolate = args.GetIsolate();
+    HandleScope scope(isolate);
+    ScriptHelper helper(isolate);
+    auto filename = ScriptEngine::current().resolvePath(
+            helper.GetString(args[0]));
+    try {
+        size_t size;
+        auto data = ReadIntoBuffer(filename, &size);
+        if (!data) {
+            args.GetReturnValue().Set(ArrayBuffer::New(isolate, 0));
+            return;
+        }
+        args.GetReturnValue().Set(ArrayBuffer::New(
+                isolate, data, size, ArrayBufferCreationMode::kInternalized));
+    }
+    catch (std::exception& ex) {
+        ScriptEngine::current().ThrowTypeError(ex.what());
+    }
+}
+
+void FileReader::MapBytes(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    auto isolate = args.GetIsolate();
+    HandleScope scope(isolate);
+    ScriptHelper helper(isolate);
+    auto filename = ScriptEngine::current().resolvePath(
+            helper.GetString(args[0]));
+    try {
+        // Mapped as copy on write, array buffers can always be written to.
+        auto file = VirtualFileSystem::current().Map(filename);
+        if (!file) {
+            // Compressed pack entries can't be mapped, they are read instead.
+            ReadBytes(args);
+            return;
+        }
+        if (file->size() == 0) {
+            args.GetReturnValue().Set(ArrayBuffer::New(isolate, 0));
+            return;
+        }
+        auto data = const_cast<unsigned char*>(file->data());
+        auto size = file->size();
+        auto buffer = ArrayBuffer::New(isolate, data, size);
+        auto mapped = new MappedBuffer();
+        mapped->file = std::move(file);
+        mapped->buffer.Reset(isolate, buffer);
+        mapped->buffer.SetWeak(mapped, MappedBufferCollected,
+                               WeakCallbackType::kParameter);
+        mappedBuffers[data] = mapped;
+        isolate->AdjustAmountOfExternalAllocatedMemory(
+                static_cast<int64_t>(size));
+        args.GetReturnValue().Set(buffer);
     }
     catch (std::exception& ex) {
         ScriptEngine::current().ThrowTypeError(ex.what());
     }
-}
\ No newline at end of file
+}
+
+void FileReader::Unmap(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    auto isolate = args.GetIsolate();
+    HandleScope scope(isolate);
+    if (!args[0]->IsArrayBuffer()) {
+        ScriptEngine::current().ThrowTypeError("Expected an array buffer");
+        return;
+    }
+    auto buffer = args[0].As<ArrayBuffer>();
+    auto mapped = mappedBuffers.find(buffer->GetContents().Data());
+    if (mapped == mappedBuffers.end() || !buffer->IsNeuterable()) {
+        return;
+    }
+    // The array buffer is detached from the memory before it's unmapped, it's
+    // empty from now on.
+    buffer->Neuter();
+    ReleaseMappedBuffer(isolate, mapped->second);
+}
+
+void FileReader::ReadTextAsync(
+        const v8::FunctionCallbackInfo<v8::Value>& args) {
+    ReadAsync(args, AsyncReadType::Text);
+}
+
+void FileReader::ReadBytesAsync(
+        const v8::FunctionCallbackInfo<v8::Value>& args) {
+    ReadAsync(args, AsyncReadType::Bytes);
+}
+
+void FileReader::ReadJsonAsync(
+        const v8::FunctionCallbackInfo<v8::Value>& args) {
+    ReadAsync(args, AsyncReadType::Json);
+}
@@ -40,6 +40,15 @@ protected:
 
 private:
     static void ReadText(const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void ReadBytes(const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void MapBytes(const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void Unmap(const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void ReadTextAsync(
+            const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void ReadBytesAsync(
+            const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void ReadJsonAsync(
+            const v8::FunctionCallbackInfo<v8::Value>& args);
 };
 
 #endif // GAMEPLAY_FILEREADER_H
\ No newline at end of file
@@ -28,6 +28,7 @@ SOFTWARE.*/
 #include <string>
 #include <script/script-object-wrap.h>
 #include <efsw/efsw.hpp>
+#include <algorithm>
 #include <vector>
 #include <mutex>
 
@@ -78,12 +79,15 @@ public:
         auto numberOfHandlers = handlers_.size();
         for (auto e: events_) {
             for (int i=0; i<numberOfHandlers; i++) {
-                if (handlers_[i]->filename() == e) {
+                if (handlers_[i] && handlers_[i]->filename() == e) {
                     handlers_[i]->Handle();
                 }
             }
         }
         events_.clear();
+        // Handlers removed while handling the events are erased afterwards.
+        handlers_.erase(std::remove(handlers_.begin(), handlers_.end(),
+                                    nullptr), handlers_.end());
         eventLock_.unlock();
     }
 
@@ -91,6 +95,13 @@ public:
         handlers_.push_back(handler);
     }
 
+    // The handler is only cleared, it can be removed by one of the handlers
+    // being called.
+    void RemoveEventHandler(FileWatcherEventHandler* handler) {
+        std::replace(handlers_.begin(), handlers_.end(), handler,
+                     static_cast<FileWatcherEventHandler*>(nullptr));
+    }
+
 private:
     std::mutex eventLock_;
     std::vector<FileWatcherEventHandler*> handlers_;
@@ -110,6 +121,15 @@ public:
         listener_.HandleEvents();
     }
 
+    // Handlers added from native code, they are called until removed.
+    static void AddEventHandler(FileWatcherEventHandler* handler) {
+        listener_.AddEventHandler(handler);
+    }
+
+    static void RemoveEventHandler(FileWatcherEventHandler* handler) {
+        listener_.RemoveEventHandler(handler);
+    }
+
     static void Start(std::string directory) {
         watcher_.addWatch(directory, &listener_, true);
         watcher_.watch();
@@ -0,0 +1,63 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef GAMEPLAY_HASH_H
+#define GAMEPLAY_HASH_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+
+class Hash {
+
+public:
+    static const uint64_t Seed = 14695981039346656037ULL;
+
+    // Calculates the 64-bit FNV-1a hash of the data. The result of a previous
+    // call can be used as seed to calculate the hash of multiple buffers.
+    static uint64_t Fnv1a(const void *data, size_t size, uint64_t seed = Seed) {
+        auto bytes = static_cast<const unsigned char*>(data);
+        auto hash = seed;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    static uint64_t Fnv1a(const std::string &text, uint64_t seed = Seed) {
+        return Fnv1a(text.data(), text.size(), seed);
+    }
+
+    // Returns the hash as 16 hexadecimal digits, used in file names.
+    static std::string ToHex(uint64_t hash) {
+        const char* digits = "0123456789abcdef";
+        std::string result(16, '0');
+        for (int i = 15; i >= 0; i--) {
+            result[i] = digits[hash & 0xF];
+            hash >>= 4;
+        }
+        return result;
+    }
+};
+
+#endif // GAMEPLAY_HASH_H
@@ -0,0 +1,85 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "histogram.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+// Width of the longest bar when printing the histogram.
+const int MaxBarLength = 50;
+
+}
+
+Histogram::Histogram(double bucketWidth, int buckets) :
+        bucketWidth_(bucketWidth), buckets_(buckets) {
+}
+
+void Histogram::Add(double value) {
+    auto bucket = static_cast<int>(std::max(0.0, value) / bucketWidth_);
+    buckets_[std::min(bucket, static_cast<int>(buckets_.size()) - 1)]++;
+    count_++;
+    sum_ += value;
+    max_ = std::max(max_, value);
+}
+
+double Histogram::Percentile(double fraction) const {
+    auto target = fraction * count_;
+    auto count = 0;
+    for (size_t i = 0; i < buckets_.size(); i++) {
+        count += buckets_[i];
+        if (count > 0 && count >= target) {
+            return std::min(max_, (i + 1) * bucketWidth_);
+        }
+    }
+    return max_;
+}
+
+void Histogram::Reset() {
+    std::fill(buckets_.begin(), buckets_.end(), 0);
+    count_ = 0;
+    sum_ = 0;
+    max_ = 0;
+}
+
+std::string Histogram::ToString(std::string unit) const {
+    std::ostringstream output;
+    output << std::fixed << std::setprecision(2);
+    output << "count " << count_ << ", mean " << mean() << " " << unit <<
+            ", p50 " << Percentile(0.5) << " " << unit <<
+            ", p95 " << Percentile(0.95) << " " << unit <<
+            ", p99 " << Percentile(0.99) << " " << unit <<
+            ", max " << max_ << " " << unit << std::endl;
+    auto largest = *std::max_element(buckets_.begin(), buckets_.end());
+    for (size_t i = 0; i < buckets_.size(); i++) {
+        if (buckets_[i] == 0) {
+            continue;
+        }
+        auto last = i == buckets_.size() - 1;
+        output << std::setw(8) << i * bucketWidth_ << (last ? "+ " : "  ") <<
+                std::string(std::max(1, buckets_[i] * MaxBarLength / largest),
+                            '#') << " " << buckets_[i] << std::endl;
+    }
+    return output.str();
+}
@@ -0,0 +1,71 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef GAMEPLAY_HISTOGRAM_H
+#define GAMEPLAY_HISTOGRAM_H
+
+#include <string>
+#include <vector>
+
+// Counts samples in buckets of equal width, the last bucket also counts all
+// samples above the range.
+class Histogram {
+
+public:
+    Histogram(double bucketWidth, int buckets);
+
+    void Add(double value);
+    // Returns the upper bound of the bucket where the given fraction (0-1) of
+    // the samples are at or below.
+    double Percentile(double fraction) const;
+    void Reset();
+    std::string ToString(std::string unit) const;
+
+    const std::vector<int>& buckets() const {
+        return buckets_;
+    }
+
+    double bucketWidth() const {
+        return bucketWidth_;
+    }
+
+    int count() const {
+        return count_;
+    }
+
+    double max() const {
+        return max_;
+    }
+
+    double mean() const {
+        return count_ == 0 ? 0 : sum_ / count_;
+    }
+
+private:
+    double bucketWidth_;
+    std::vector<int> buckets_;
+    int count_ = 0;
+    double sum_ = 0;
+    double max_ = 0;
+};
+
+#endif // GAMEPLAY_HISTOGRAM_H
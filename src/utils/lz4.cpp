@@ -0,0 +1,177 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "lz4.h"
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+const size_t MinMatch = 4;
+// The last bytes are always literals, and the last match has to start this
+// far from the end.
+const size_t LastLiterals = 5;
+const size_t MatchFindLimit = 12;
+const size_t MaxOffset = 65535;
+const int HashBits = 16;
+const size_t NoPosition = static_cast<size_t>(-1);
+
+uint32_t Read32(const unsigned char* data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+uint32_t HashOf(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - HashBits);
+}
+
+// Lengths that doesn't fit in the token are continued with bytes of 255.
+void WriteLength(std::vector<unsigned char>& output, size_t length) {
+    length -= 15;
+    while (length >= 255) {
+        output.push_back(255);
+        length -= 255;
+    }
+    output.push_back(static_cast<unsigned char>(length));
+}
+
+bool ReadLength(const unsigned char* data, size_t size, size_t* position,
+                size_t* length) {
+    unsigned char byte;
+    do {
+        if (*position >= size) {
+            return false;
+        }
+        byte = data[(*position)++];
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+void WriteSequence(std::vector<unsigned char>& output,
+                   const unsigned char* literals, size_t literalLength,
+                   size_t offset, size_t matchLength) {
+    auto token = static_cast<unsigned char>(
+            (literalLength < 15 ? literalLength : 15) << 4);
+    if (matchLength > 0) {
+        auto length = matchLength - MinMatch;
+        token |= static_cast<unsigned char>(length < 15 ? length : 15);
+    }
+    output.push_back(token);
+    if (literalLength >= 15) {
+        WriteLength(output, literalLength);
+    }
+    output.insert(output.end(), literals, literals + literalLength);
+    if (matchLength == 0) {
+        // The last sequence only has literals.
+        return;
+    }
+    output.push_back(static_cast<unsigned char>(offset & 0xFF));
+    output.push_back(static_cast<unsigned char>(offset >> 8));
+    if (matchLength - MinMatch >= 15) {
+        WriteLength(output, matchLength - MinMatch);
+    }
+}
+
+}
+
+std::vector<unsigned char> Lz4::Compress(const unsigned char* data,
+                                         size_t size) {
+    std::vector<unsigned char> output;
+    output.reserve(size + size / 255 + 16);
+    std::vector<size_t> table(1 << HashBits, NoPosition);
+    size_t anchor = 0;
+    size_t position = 0;
+    if (size > MatchFindLimit) {
+        auto matchLimit = size - LastLiterals;
+        auto startLimit = size - MatchFindLimit;
+        while (position < startLimit) {
+            auto sequence = Read32(data + position);
+            auto hash = HashOf(sequence);
+            auto candidate = table[hash];
+            table[hash] = position;
+            if (candidate == NoPosition ||
+                    position - candidate > MaxOffset ||
+                    Read32(data + candidate) != sequence) {
+                position++;
+                continue;
+            }
+            auto length = MinMatch;
+            while (position + length < matchLimit &&
+                    data[candidate + length] == data[position + length]) {
+                length++;
+            }
+            WriteSequence(output, data + anchor, position - anchor,
+                          position - candidate, length);
+            position += length;
+            anchor = position;
+        }
+    }
+    WriteSequence(output, data + anchor, size - anchor, 0, 0);
+    return output;
+}
+
+bool Lz4::Decompress(const unsigned char* data, size_t size,
+                     unsigned char* output, size_t outputSize) {
+    size_t in = 0;
+    size_t out = 0;
+    while (in < size) {
+        auto token = data[in++];
+        size_t literals = token >> 4;
+        if (literals == 15 && !ReadLength(data, size, &in, &literals)) {
+            return false;
+        }
+        if (literals > size - in || literals > outputSize - out) {
+            return false;
+        }
+        memcpy(output + out, data + in, literals);
+        in += literals;
+        out += literals;
+        if (in == size) {
+            // The last sequence doesn't have a match.
+            break;
+        }
+        if (size - in < 2) {
+            return false;
+        }
+        size_t offset = data[in] | (data[in + 1] << 8);
+        in += 2;
+        if (offset == 0 || offset > out) {
+            return false;
+        }
+        size_t length = token & 15;
+        if (length == 15 && !ReadLength(data, size, &in, &length)) {
+            return false;
+        }
+        length += MinMatch;
+        if (length > outputSize - out) {
+            return false;
+        }
+        // The match may overlap the output being written, e.g. a run of the
+        // same byte, it's copied one byte at a time.
+        for (size_t i = 0; i < length; i++, out++) {
+            output[out] = output[out - offset];
+        }
+    }
+    return out == outputSize;
+}
@@ -0,0 +1,44 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef GAMEPLAY_LZ4_H
+#define GAMEPLAY_LZ4_H
+
+#include <cstddef>
+#include <vector>
+
+// Compresses and decompresses data in the LZ4 block format. The compressor is
+// a simple greedy one, it's only used when creating packs where speed doesn't
+// matter much, decompression is what happens when the game is running.
+class Lz4 {
+
+public:
+    static std::vector<unsigned char> Compress(const unsigned char* data,
+                                               size_t size);
+
+    // Decompresses into a buffer of exactly the decompressed size. Returns
+    // false when the data is corrupt.
+    static bool Decompress(const unsigned char* data, size_t size,
+                           unsigned char* output, size_t outputSize);
+};
+
+#endif // GAMEPLAY_LZ4_H
@@ -0,0 +1,161 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "memory-mapped-file.h"
+#include <cstdint>
+#include <stdexcept>
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Used as length to map the whole file.
+const size_t WholeFile = static_cast<size_t>(-1);
+
+}
+
+MemoryMappedFile::MemoryMappedFile(std::string filename, bool copyOnWrite) {
+    Map(filename, copyOnWrite, 0, WholeFile);
+}
+
+MemoryMappedFile::MemoryMappedFile(std::string filename, bool copyOnWrite,
+                                   size_t offset, size_t length) {
+    Map(filename, copyOnWrite, offset, length);
+}
+
+#ifdef WIN32
+
+void MemoryMappedFile::Map(std::string filename, bool copyOnWrite,
+                           size_t offset, size_t length) {
+    file_ = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Failed to open file '" + filename + "'");
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file_, &fileSize)) {
+        CloseHandle(file_);
+        throw std::runtime_error("Failed to open file '" + filename + "'");
+    }
+    auto available = static_cast<size_t>(fileSize.QuadPart);
+    if (length == WholeFile) {
+        length = available;
+    }
+    if (offset > available || length > available - offset) {
+        CloseHandle(file_);
+        throw std::runtime_error("Failed to map file '" + filename + "'");
+    }
+    size_ = length;
+    if (size_ == 0) {
+        // Empty files can't be mapped.
+        return;
+    }
+    mapping_ = CreateFileMappingA(
+            file_, NULL, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0,
+            NULL);
+    // The view has to start at a multiple of the allocation granularity.
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    auto start = static_cast<uint64_t>(
+            offset - offset % info.dwAllocationGranularity);
+    mappedSize_ = size_ + (offset - static_cast<size_t>(start));
+    if (mapping_ != NULL) {
+        base_ = MapViewOfFile(
+                mapping_, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ,
+                static_cast<DWORD>(start >> 32),
+                static_cast<DWORD>(start & 0xFFFFFFFF), mappedSize_);
+    }
+    if (base_ == nullptr) {
+        if (mapping_ != NULL) {
+            CloseHandle(mapping_);
+        }
+        CloseHandle(file_);
+        throw std::runtime_error("Failed to map file '" + filename + "'");
+    }
+    data_ = static_cast<const unsigned char*>(base_) +
+            (offset - static_cast<size_t>(start));
+}
+
+MemoryMappedFile::~MemoryMappedFile() {
+    if (base_ != nullptr) {
+        UnmapViewOfFile(base_);
+        CloseHandle(mapping_);
+    }
+    CloseHandle(file_);
+}
+
+#else
+
+void MemoryMappedFile::Map(std::string filename, bool copyOnWrite,
+                           size_t offset, size_t length) {
+    auto file = open(filename.c_str(), O_RDONLY);
+    if (file < 0) {
+        throw std::runtime_error("Failed to open file '" + filename + "'");
+    }
+    struct stat info;
+    if (fstat(file, &info) != 0) {
+        close(file);
+        throw std::runtime_error("Failed to open file '" + filename + "'");
+    }
+    auto available = static_cast<size_t>(info.st_size);
+    if (length == WholeFile) {
+        length = available;
+    }
+    if (offset > available || length > available - offset) {
+        close(file);
+        throw std::runtime_error("Failed to map file '" + filename + "'");
+    }
+    size_ = length;
+    if (size_ == 0) {
+        // Empty files can't be mapped.
+        close(file);
+        return;
+    }
+    // The mapping has to start at a multiple of the page size.
+    auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    auto start = offset - offset % pageSize;
+    mappedSize_ = size_ + (offset - start);
+    auto protection = copyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ;
+    auto data = mmap(NULL, mappedSize_, protection, MAP_PRIVATE, file,
+                     static_cast<off_t>(start));
+    // The mapping keeps the file open, the descriptor is no longer needed.
+    close(file);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Failed to map file '" + filename + "'");
+    }
+    base_ = data;
+    data_ = static_cast<const unsigned char*>(data) + (offset - start);
+}
+
+MemoryMappedFile::~MemoryMappedFile() {
+    if (base_ != nullptr) {
+        munmap(base_, mappedSize_);
+    }
+}
+
+#endif
@@ -0,0 +1,63 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef GAMEPLAY_MEMORYMAPPEDFILE_H
+#define GAMEPLAY_MEMORYMAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+// Maps the contents of a file into memory as read only. The file is paged in
+// by the operating system when accessed instead of being read up front. When
+// mapped as copy on write, the memory can also be written to. The changes are
+// private to the process and never written back to the file.
+class MemoryMappedFile {
+
+public:
+    MemoryMappedFile(std::string filename, bool copyOnWrite = false);
+    // Maps a range of the file, e.g. an entry in a pack.
+    MemoryMappedFile(std::string filename, bool copyOnWrite, size_t offset,
+                     size_t length);
+    ~MemoryMappedFile();
+
+    const unsigned char* data() { return data_; }
+    size_t size() { return size_; }
+
+private:
+    MemoryMappedFile(MemoryMappedFile const& copy);
+    MemoryMappedFile& operator=(MemoryMappedFile const& copy);
+
+    void Map(std::string filename, bool copyOnWrite, size_t offset,
+             size_t length);
+
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+    // The mapping starts at an aligned offset, which can be before the data.
+    void* base_ = nullptr;
+    size_t mappedSize_ = 0;
+#ifdef WIN32
+    void* file_;
+    void* mapping_ = nullptr;
+#endif
+};
+
+#endif // GAMEPLAY_MEMORYMAPPEDFILE_H
@@ -25,14 +25,18 @@ SOFTWARE.*/
 
 #include <string>
 #include <assert.h>
-#include <regex>
+#include <cstring>
+#include <stdexcept>
 #include <stdio.h>  /* defines FILENAME_MAX */
 #ifdef WIN32
 #include <direct.h>
 #define GetCurrentDir _getcwd
+#define MakeDir(path) _mkdir(path)
 #else
 #include <unistd.h>
+#include <sys/stat.h>
 #define GetCurrentDir getcwd
+#define MakeDir(path) mkdir(path, 0755)
 #endif
 
 #include <vector>
@@ -40,23 +44,55 @@ SOFTWARE.*/
 class PathHelper {
 
 public:
+    // Converts backslashes to slashes and removes "." and empty segments, and
+    // ".." together with the segment before it. It's done in a single pass,
+    // segments are moved down in place over the ones that were removed.
     static std::string Normalize(std::string filepath) {
-        std::regex backslash("\\\\");
-        std::string result = std::regex_replace(filepath, backslash, "/");
-        while (result.find("../", 2) != std::string::npos) {
-            auto pos = result.find("../", 2);
-            auto end = result.rfind("/", pos - 1);
-            auto beg = result.rfind("/", end - 1);
-            if (end == std::string::npos) {
-                end = 0;
+        auto data = &filepath[0];
+        auto size = filepath.size();
+        size_t in = 0;
+        size_t out = 0;
+        // A leading slash is never removed by "..".
+        size_t root = 0;
+        if (size > 0 && (data[0] == '/' || data[0] == '\\')) {
+            data[out++] = '/';
+            in = root = 1;
+        }
+        while (in < size) {
+            auto end = in;
+            while (end < size && data[end] != '/' && data[end] != '\\') {
+                end++;
+            }
+            auto length = end - in;
+            auto slash = end < size;
+            if (length == 0 || (length == 1 && data[in] == '.')) {
+                in = end + 1;
+                continue;
+            }
+            if (length == 2 && data[in] == '.' && data[in + 1] == '.' &&
+                    out > root) {
+                // The previous segment always ends with a slash.
+                auto start = out - 1;
+                while (start > root && data[start - 1] != '/') {
+                    start--;
+                }
+                auto previous = out - 1 - start;
+                if (previous != 2 || data[start] != '.' ||
+                        data[start + 1] != '.') {
+                    out = start;
+                    in = end + 1;
+                    continue;
+                }
             }
-            if (beg == std::string::npos) {
-                beg = 0;
+            memmove(data + out, data + in, length);
+            out += length;
+            if (slash) {
+                data[out++] = '/';
             }
-            result.erase(pos, 3);
-            result.erase(beg, end - beg);
+            in = end + 1;
         }
-        return result;
+        filepath.resize(out);
+        return filepath;
     }
 
     static bool FileNameEndsWith(const std::string &str, const std::string &suffix) {
@@ -64,6 +100,13 @@ public:
                str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
     }
 
+    // True for paths starting at the root, or at a drive on Windows.
+    static bool IsAbsolute(const std::string &filepath) {
+        return (filepath.size() > 0 &&
+                (filepath[0] == '/' || filepath[0] == '\\')) ||
+               (filepath.size() > 1 && filepath[1] == ':');
+    }
+
     static std::string GetPath(std::string filepath) {
         auto index = filepath.find_last_of("\\/");
         if (index == std::string::npos) {
@@ -90,6 +133,17 @@ public:
         return PathHelper::Normalize(std::string(currentPath));
     }
 
+    // Creates the directory and all parent directories that doesn't exist.
+    static void CreateDirectories(std::string path) {
+        path = Normalize(path);
+        size_t position = 0;
+        do {
+            position = path.find('/', position + 1);
+            // Fails when the directory already exists, which is fine.
+            MakeDir(path.substr(0, position).c_str());
+        } while (position != std::string::npos);
+    }
+
     static std::string Append(std::vector<std::string> paths) {
         for (int i=0; i<paths.size(); i++) {
             if (paths[i].length() == 0) {
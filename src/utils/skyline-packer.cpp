@@ -0,0 +1,129 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "skyline-packer.h"
+#include <algorithm>
+#include <limits>
+
+SkylinePacker::SkylinePacker(int width, int height, int padding) :
+        width_(width), height_(height), padding_(padding) {
+    Clear();
+}
+
+void SkylinePacker::Clear() {
+    skyline_.clear();
+    skyline_.push_back(Segment { 0, 0, width_ });
+}
+
+void SkylinePacker::SetSkyline(std::vector<Segment> skyline) {
+    if (skyline.empty()) {
+        Clear();
+        return;
+    }
+    skyline_ = std::move(skyline);
+}
+
+bool SkylinePacker::Pack(int width, int height, int *x, int *y) {
+    // The padding keeps neighbouring rectangles from bleeding into each other
+    // when sampled with linear filtering.
+    width += padding_;
+    height += padding_;
+
+    auto bestIndex = skyline_.size();
+    auto bestBottom = std::numeric_limits<int>::max();
+    auto bestWidth = std::numeric_limits<int>::max();
+    for (size_t i = 0; i < skyline_.size(); i++) {
+        auto top = Fit(i, width, height);
+        if (top < 0) {
+            continue;
+        }
+        // Prefer the lowest position, and the narrowest segment when equal.
+        if (top + height < bestBottom ||
+                (top + height == bestBottom && skyline_[i].width < bestWidth)) {
+            bestIndex = i;
+            bestBottom = top + height;
+            bestWidth = skyline_[i].width;
+        }
+    }
+    if (bestIndex == skyline_.size()) {
+        return false;
+    }
+    *x = skyline_[bestIndex].x;
+    *y = bestBottom - height;
+    // The padding of the rightmost rectangles is outside of the skyline.
+    AddSegment(bestIndex, *x, *y, std::min(width, width_ - *x), height);
+    return true;
+}
+
+int SkylinePacker::Fit(size_t index, int width, int height) {
+    auto x = skyline_[index].x;
+    if (x + width > width_ + padding_) {
+        return -1;
+    }
+    // The rectangle rests on the highest segment below it.
+    auto y = skyline_[index].y;
+    auto remaining = width;
+    for (auto i = index; remaining > 0; i++) {
+        if (i == skyline_.size()) {
+            // Only the padding is left, which may extend past the right edge.
+            break;
+        }
+        y = std::max(y, skyline_[i].y);
+        if (y + height > height_ + padding_) {
+            return -1;
+        }
+        remaining -= skyline_[i].width;
+    }
+    return y;
+}
+
+void SkylinePacker::AddSegment(size_t index, int x, int y, int width,
+                               int height) {
+    skyline_.insert(skyline_.begin() + index, Segment { x, y + height, width });
+
+    // Shrink or remove the segments covered by the new segment.
+    auto i = index + 1;
+    while (i < skyline_.size()) {
+        auto& previous = skyline_[i - 1];
+        auto& segment = skyline_[i];
+        auto overlap = previous.x + previous.width - segment.x;
+        if (overlap <= 0) {
+            break;
+        }
+        if (overlap < segment.width) {
+            segment.x += overlap;
+            segment.width -= overlap;
+            break;
+        }
+        skyline_.erase(skyline_.begin() + i);
+    }
+    // Merge neighbouring segments at the same height.
+    for (i = 0; i + 1 < skyline_.size();) {
+        if (skyline_[i].y == skyline_[i + 1].y) {
+            skyline_[i].width += skyline_[i + 1].width;
+            skyline_.erase(skyline_.begin() + i + 1);
+        }
+        else {
+            i++;
+        }
+    }
+}
@@ -0,0 +1,66 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef GAMEPLAY_SKYLINE_PACKER_H
+#define GAMEPLAY_SKYLINE_PACKER_H
+
+#include <cstddef>
+#include <vector>
+
+// Packs rectangles into an area using the skyline bottom-left heuristic. The
+// top edge of the packed rectangles is stored as horizontal segments, each new
+// rectangle is placed where it ends up lowest.
+class SkylinePacker {
+
+public:
+    struct Segment {
+        int x;
+        int y;
+        int width;
+    };
+
+    SkylinePacker(int width, int height, int padding = 1);
+
+    // Finds a position for the rectangle, returns false when it doesn't fit.
+    bool Pack(int width, int height, int* x, int* y);
+
+    // Removes all packed rectangles.
+    void Clear();
+
+    // The skyline can be saved and restored to continue packing later.
+    const std::vector<Segment>& skyline() { return skyline_; }
+    void SetSkyline(std::vector<Segment> skyline);
+
+    int width() { return width_; }
+    int height() { return height_; }
+
+private:
+    int Fit(size_t index, int width, int height);
+    void AddSegment(size_t index, int x, int y, int width, int height);
+
+    int width_;
+    int height_;
+    int padding_;
+    std::vector<Segment> skyline_;
+};
+
+#endif // GAMEPLAY_SKYLINE_PACKER_H
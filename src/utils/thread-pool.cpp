@@ -0,0 +1,106 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "thread-pool.h"
+#include <algorithm>
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    workPosted_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void ThreadPool::Post(std::function<void()> work,
+                      std::function<void()> completion, int priority) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // The threads are started when the first work is posted, most games
+        // never uses them.
+        if (threads_.empty()) {
+            for (int i = 0; i < size_; i++) {
+                threads_.push_back(std::thread(&ThreadPool::Work, this));
+            }
+        }
+        auto position = std::find_if(
+                tasks_.begin(), tasks_.end(), [priority](const Task& task) {
+                    return task.priority < priority;
+                });
+        tasks_.insert(position, { work, completion, priority });
+        pending_++;
+    }
+    workPosted_.notify_one();
+}
+
+int ThreadPool::RunCompletions() {
+    std::vector<std::function<void()>> completions;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        completions.swap(completions_);
+    }
+    // A completion may post more work, the lock isn't held while calling it.
+    for (auto& completion : completions) {
+        completion();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_ -= static_cast<int>(completions.size());
+    return static_cast<int>(completions.size());
+}
+
+void ThreadPool::WaitForCompletion() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    workFinished_.wait(lock, [this] {
+        return !completions_.empty() || pending_ == 0;
+    });
+}
+
+int ThreadPool::pending() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_;
+}
+
+void ThreadPool::Work() {
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            workPosted_.wait(lock, [this] {
+                return stopping_ || !tasks_.empty();
+            });
+            if (stopping_) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task.work();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            completions_.push_back(std::move(task.completion));
+        }
+        workFinished_.notify_all();
+    }
+}
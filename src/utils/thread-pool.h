@@ -0,0 +1,80 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef GAMEPLAY_THREADPOOL_H
+#define GAMEPLAY_THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs work on a fixed number of background threads. When the work is done,
+// its completion is queued and called from RunCompletions on the thread
+// running the scripts, where it's safe to use V8.
+class ThreadPool {
+
+public:
+    ThreadPool(int threads) : size_(threads) { }
+    ~ThreadPool();
+
+    // Work with higher priority is started first, work with the same priority
+    // is started in the order it was posted.
+    void Post(std::function<void()> work, std::function<void()> completion,
+              int priority = 0);
+
+    // Calls the completions of finished work, returns the number of called
+    // completions.
+    int RunCompletions();
+
+    // Blocks until there is finished work or nothing is pending.
+    void WaitForCompletion();
+
+    // Number of posted work items that hasn't been completed yet.
+    int pending();
+
+private:
+    ThreadPool(ThreadPool const& copy);
+    ThreadPool& operator=(ThreadPool const& copy);
+
+    struct Task {
+        std::function<void()> work;
+        std::function<void()> completion;
+        int priority;
+    };
+
+    void Work();
+
+    int size_;
+    int pending_ = 0;
+    bool stopping_ = false;
+    std::mutex mutex_;
+    std::condition_variable workPosted_;
+    std::condition_variable workFinished_;
+    std::deque<Task> tasks_;
+    std::vector<std::function<void()>> completions_;
+    std::vector<std::thread> threads_;
+};
+
+#endif // GAMEPLAY_THREADPOOL_H
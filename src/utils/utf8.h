@@ -0,0 +1,85 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef GAMEPLAY_UTF8_H
+#define GAMEPLAY_UTF8_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+class Utf8 {
+
+public:
+    // Replacement character used for malformed sequences.
+    static const uint32_t Invalid = 0xFFFD;
+
+    // Decodes the code point starting at the given position and moves the
+    // position to the start of the next code point.
+    static uint32_t Next(const std::string &text, size_t &position) {
+        auto c = static_cast<unsigned char>(text[position++]);
+        if (c < 0x80) {
+            return c;
+        }
+        int length;
+        uint32_t codepoint;
+        if ((c & 0xE0) == 0xC0) {
+            length = 1;
+            codepoint = c & 0x1F;
+        }
+        else if ((c & 0xF0) == 0xE0) {
+            length = 2;
+            codepoint = c & 0x0F;
+        }
+        else if ((c & 0xF8) == 0xF0) {
+            length = 3;
+            codepoint = c & 0x07;
+        }
+        else {
+            return Invalid;
+        }
+        for (int i = 0; i < length; i++) {
+            if (position >= text.length()) {
+                return Invalid;
+            }
+            c = static_cast<unsigned char>(text[position]);
+            if ((c & 0xC0) != 0x80) {
+                return Invalid;
+            }
+            codepoint = (codepoint << 6) | (c & 0x3F);
+            position++;
+        }
+        return codepoint;
+    }
+
+    static std::vector<uint32_t> Decode(const std::string &text) {
+        std::vector<uint32_t> result;
+        result.reserve(text.length());
+        size_t position = 0;
+        while (position < text.length()) {
+            result.push_back(Next(text, position));
+        }
+        return result;
+    }
+};
+
+#endif // GAMEPLAY_UTF8_H
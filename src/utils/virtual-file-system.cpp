@@ -0,0 +1,331 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "virtual-file-system.h"
+#include "hash.h"
+#include "lz4.h"
+#include "path-helper.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+// Describes a file in a pack, the index is sorted by the hash of the names.
+struct PackEntry {
+    uint64_t hash;
+    uint64_t offset;
+    uint64_t size;
+    // The size in the pack, it's smaller than the size when compressed.
+    uint64_t storedSize;
+    // The name is relative to the pack and stored after the index.
+    uint64_t nameOffset;
+    uint64_t nameLength;
+};
+
+namespace {
+
+// Identifies pack files.
+const uint32_t PackMagic = 0x4b415047;
+const uint32_t PackVersion = 1;
+// The entries are aligned to the page size, which makes it possible to map
+// them on their own.
+const uint64_t PackAlignment = 4096;
+
+struct PackHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t count;
+    uint64_t indexOffset;
+};
+
+void AddFiles(std::string directory, std::string relative,
+              std::vector<std::string>& files) {
+    auto path = PathHelper::Append({directory, relative});
+#ifdef WIN32
+    WIN32_FIND_DATAA data;
+    auto find = FindFirstFileA((path + "/*").c_str(), &data);
+    if (find == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Failed to list directory '" + path + "'");
+    }
+    do {
+        std::string name = data.cFileName;
+        if (name[0] == '.') {
+            continue;
+        }
+        auto file = relative.empty() ? name : relative + "/" + name;
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            AddFiles(directory, file, files);
+        }
+        else {
+            files.push_back(file);
+        }
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+#else
+    auto dir = opendir(path.c_str());
+    if (!dir) {
+        throw std::runtime_error("Failed to list directory '" + path + "'");
+    }
+    while (auto entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name[0] == '.') {
+            continue;
+        }
+        auto file = relative.empty() ? name : relative + "/" + name;
+        struct stat info;
+        if (stat(PathHelper::Append({directory, file}).c_str(), &info) != 0) {
+            continue;
+        }
+        if (S_ISDIR(info.st_mode)) {
+            AddFiles(directory, file, files);
+        }
+        else {
+            files.push_back(file);
+        }
+    }
+    closedir(dir);
+#endif
+}
+
+void Pad(std::ofstream& output) {
+    static const char zeros[PackAlignment] = {};
+    auto position = static_cast<uint64_t>(output.tellp());
+    auto padding = (PackAlignment - position % PackAlignment) % PackAlignment;
+    output.write(zeros, static_cast<std::streamsize>(padding));
+}
+
+}
+
+void VirtualFileSystem::Mount(std::string filename) {
+    // The root is compared with resolved paths, which are normalized.
+    filename = PathHelper::Normalize(filename);
+    std::unique_ptr<Pack> pack(new Pack());
+    pack->filename = filename;
+    pack->root = PathHelper::GetPath(filename);
+    pack->file.reset(new MemoryMappedFile(filename));
+    auto data = pack->file->data();
+    auto size = pack->file->size();
+    PackHeader header;
+    if (size < sizeof(header)) {
+        throw std::runtime_error("Invalid pack '" + filename + "'");
+    }
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != PackMagic || header.version != PackVersion ||
+            header.indexOffset > size || header.count >
+            (size - header.indexOffset) / sizeof(PackEntry)) {
+        throw std::runtime_error("Invalid pack '" + filename + "'");
+    }
+    pack->entries = reinterpret_cast<const PackEntry*>(
+            data + header.indexOffset);
+    pack->count = static_cast<size_t>(header.count);
+    pack->names = reinterpret_cast<const char*>(pack->entries + pack->count);
+    auto namesSize = size - (pack->names - reinterpret_cast<const char*>(data));
+    for (size_t i = 0; i < pack->count; i++) {
+        auto& entry = pack->entries[i];
+        if (entry.offset > size || entry.storedSize > size - entry.offset ||
+                entry.nameOffset > namesSize ||
+                entry.nameLength > namesSize - entry.nameOffset) {
+            throw std::runtime_error("Invalid pack '" + filename + "'");
+        }
+    }
+    packs_.push_back(std::move(pack));
+}
+
+std::unique_ptr<VirtualFile> VirtualFileSystem::Open(std::string filename) {
+    Pack* pack = nullptr;
+    const PackEntry* entry = nullptr;
+    if (!looseFiles_ || !LooseFileExists(filename)) {
+        entry = Find(filename, &pack);
+    }
+    std::unique_ptr<VirtualFile> file(new VirtualFile());
+    if (!entry) {
+        if (!LooseFileAllowed(filename)) {
+            throw std::runtime_error(
+                    "File '" + filename + "' is not in the mounted packs");
+        }
+        file->mapped_.reset(new MemoryMappedFile(filename));
+        file->data_ = file->mapped_->data();
+        file->size_ = file->mapped_->size();
+        return file;
+    }
+    auto stored = pack->file->data() + entry->offset;
+    file->size_ = static_cast<size_t>(entry->size);
+    if (entry->storedSize == entry->size) {
+        file->data_ = stored;
+        return file;
+    }
+    file->decompressed_.resize(file->size_);
+    if (!Lz4::Decompress(stored, static_cast<size_t>(entry->storedSize),
+                         file->decompressed_.data(), file->size_)) {
+        throw std::runtime_error("Failed to decompress '" + filename + "'");
+    }
+    file->data_ = file->decompressed_.data();
+    return file;
+}
+
+bool VirtualFileSystem::Exists(std::string filename) {
+    Pack* pack;
+    return Find(filename, &pack) != nullptr ||
+           (LooseFileAllowed(filename) && LooseFileExists(filename));
+}
+
+std::unique_ptr<MemoryMappedFile> VirtualFileSystem::Map(
+        std::string filename) {
+    Pack* pack = nullptr;
+    const PackEntry* entry = nullptr;
+    if (!looseFiles_ || !LooseFileExists(filename)) {
+        entry = Find(filename, &pack);
+    }
+    if (!entry) {
+        if (!LooseFileAllowed(filename)) {
+            throw std::runtime_error(
+                    "File '" + filename + "' is not in the mounted packs");
+        }
+        return std::unique_ptr<MemoryMappedFile>(
+                new MemoryMappedFile(filename, true));
+    }
+    if (entry->storedSize != entry->size) {
+        return nullptr;
+    }
+    return std::unique_ptr<MemoryMappedFile>(new MemoryMappedFile(
+            pack->filename, true, static_cast<size_t>(entry->offset),
+            static_cast<size_t>(entry->size)));
+}
+
+const PackEntry* VirtualFileSystem::Find(const std::string& filename,
+                                         Pack** found) {
+    for (auto pack = packs_.rbegin(); pack != packs_.rend(); pack++) {
+        auto& root = (*pack)->root;
+        if (filename.compare(0, root.size(), root) != 0) {
+            continue;
+        }
+        auto name = filename.data() + root.size();
+        auto length = filename.size() - root.size();
+        auto hash = Hash::Fnv1a(name, length);
+        auto end = (*pack)->entries + (*pack)->count;
+        auto entry = std::lower_bound(
+                (*pack)->entries, end, hash,
+                [](const PackEntry& entry, uint64_t hash) {
+                    return entry.hash < hash;
+                });
+        for (; entry != end && entry->hash == hash; entry++) {
+            if (entry->nameLength == length && memcmp(
+                    (*pack)->names + entry->nameOffset, name, length) == 0) {
+                *found = pack->get();
+                return entry;
+            }
+        }
+    }
+    return nullptr;
+}
+
+bool VirtualFileSystem::LooseFileAllowed(const std::string& filename) {
+    if (looseFiles_) {
+        return true;
+    }
+    for (auto& pack : packs_) {
+        if (filename.compare(0, pack->root.size(), pack->root) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool VirtualFileSystem::LooseFileExists(const std::string& filename) {
+    std::ifstream file(filename);
+    return file.good();
+}
+
+std::vector<std::string> VirtualFileSystem::ListFiles(std::string directory) {
+    std::vector<std::string> files;
+    AddFiles(directory, "", files);
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+void VirtualFileSystem::CreatePack(std::string directory, std::string output,
+                                   bool compress) {
+    auto files = ListFiles(directory);
+
+    std::ofstream pack(output, std::ios::out | std::ios::binary);
+    if (!pack) {
+        throw std::runtime_error("Failed to create pack '" + output + "'");
+    }
+    PackHeader header = { PackMagic, PackVersion, 0, 0 };
+    pack.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    Pad(pack);
+
+    std::vector<PackEntry> entries;
+    std::string names;
+    for (auto& name : files) {
+        if (PathHelper::FileNameEndsWith(name, ".pack")) {
+            continue;
+        }
+        MemoryMappedFile file(PathHelper::Append({directory, name}));
+        PackEntry entry;
+        entry.hash = Hash::Fnv1a(name);
+        entry.offset = static_cast<uint64_t>(pack.tellp());
+        entry.size = file.size();
+        entry.storedSize = file.size();
+        entry.nameOffset = names.size();
+        entry.nameLength = name.size();
+        std::vector<unsigned char> compressed;
+        if (compress && file.size() > 0) {
+            compressed = Lz4::Compress(file.data(), file.size());
+        }
+        if (!compressed.empty() && compressed.size() < file.size()) {
+            entry.storedSize = compressed.size();
+            pack.write(reinterpret_cast<const char*>(compressed.data()),
+                       static_cast<std::streamsize>(compressed.size()));
+        }
+        else {
+            pack.write(reinterpret_cast<const char*>(file.data()),
+                       static_cast<std::streamsize>(file.size()));
+        }
+        Pad(pack);
+        entries.push_back(entry);
+        names += name;
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const PackEntry& a, const PackEntry& b) {
+                  return a.hash < b.hash;
+              });
+
+    header.count = entries.size();
+    header.indexOffset = static_cast<uint64_t>(pack.tellp());
+    pack.write(reinterpret_cast<const char*>(entries.data()),
+               static_cast<std::streamsize>(
+                       entries.size() * sizeof(PackEntry)));
+    pack.write(names.data(), static_cast<std::streamsize>(names.size()));
+    pack.seekp(0);
+    pack.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!pack) {
+        throw std::runtime_error("Failed to write pack '" + output + "'");
+    }
+}
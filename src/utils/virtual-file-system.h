@@ -0,0 +1,114 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef GAMEPLAY_VIRTUALFILESYSTEM_H
+#define GAMEPLAY_VIRTUALFILESYSTEM_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "memory-mapped-file.h"
+
+struct PackEntry;
+
+// The contents of a file opened from the virtual file system. It points
+// directly into a mounted pack, unless the entry was compressed or the file
+// was opened as a loose file.
+class VirtualFile {
+
+public:
+    const unsigned char* data() { return data_; }
+    size_t size() { return size_; }
+
+private:
+    friend class VirtualFileSystem;
+
+    std::unique_ptr<MemoryMappedFile> mapped_;
+    std::vector<unsigned char> decompressed_;
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Opens files from the mounted packs, or from the file system (loose files)
+// when they aren't packed. A pack is a single file with the files from a
+// directory, it's mounted at the directory containing the pack. The entries
+// are found with a precomputed hash index and are aligned so they can be
+// mapped on their own.
+class VirtualFileSystem {
+
+public:
+    static VirtualFileSystem& current() {
+        static VirtualFileSystem instance;
+        return instance;
+    }
+
+    // Packs mounted later takes precedence over earlier ones.
+    void Mount(std::string filename);
+
+    std::unique_ptr<VirtualFile> Open(std::string filename);
+    bool Exists(std::string filename);
+
+    // Maps the file as copy on write, returns null when the file is a
+    // compressed pack entry and has to be opened instead.
+    std::unique_ptr<MemoryMappedFile> Map(std::string filename);
+
+    // Loose files overrides the entries of the mounted packs while the game
+    // is being developed. When disabled with --no-loose-files, files in the
+    // directories of the mounted packs are only opened from the packs, other
+    // files (e.g. the lib modules) are still opened as loose files.
+    void SetLooseFiles(bool enabled) {
+        looseFiles_ = enabled;
+    }
+
+    // Lists the files in a directory and its subdirectories (except hidden
+    // files) relative to the directory, sorted by name.
+    static std::vector<std::string> ListFiles(std::string directory);
+
+    // Packs all files in a directory (except hidden files and other packs),
+    // entries are compressed when it makes them smaller.
+    static void CreatePack(std::string directory, std::string output,
+                           bool compress);
+
+private:
+    struct Pack {
+        std::string filename;
+        // The directory the pack is mounted at, ends with a slash.
+        std::string root;
+        std::unique_ptr<MemoryMappedFile> file;
+        const PackEntry* entries;
+        size_t count;
+        const char* names;
+    };
+
+    VirtualFileSystem() { }
+    VirtualFileSystem(VirtualFileSystem const& copy);
+    VirtualFileSystem& operator=(VirtualFileSystem const& copy);
+
+    const PackEntry* Find(const std::string& filename, Pack** pack);
+    bool LooseFileAllowed(const std::string& filename);
+    bool LooseFileExists(const std::string& filename);
+
+    std::vector<std::unique_ptr<Pack>> packs_;
+    bool looseFiles_ = true;
+};
+
+#endif // GAMEPLAY_VIRTUALFILESYSTEM_H
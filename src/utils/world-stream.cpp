@@ -0,0 +1,635 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "world-stream.h"
+#include "file-reader.h"
+#include "hash.h"
+#include "memory-mapped-file.h"
+#include "path-helper.h"
+#include "virtual-file-system.h"
+#include <script/script-engine.h>
+#include <script/scripthelper.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sys/stat.h>
+
+using namespace v8;
+
+// The mapped world file, shared with the I/O threads reading cells.
+struct WorldFile {
+    std::unique_ptr<VirtualFile> file;
+    std::unique_ptr<MemoryMappedFile> mapped;
+    const unsigned char* data;
+    size_t size;
+};
+
+namespace {
+
+// Identifies world files, the version is increased when the format changes.
+const uint32_t WorldMagic = 0x444c5257;
+const uint32_t WorldVersion = 1;
+
+// The header is followed by the cell index sorted by id, the shared data and
+// the cells. The shared data and the cells are JSON.
+struct WorldHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    float cellSize;
+    int32_t cellCount;
+    uint32_t sharedOffset;
+    uint32_t sharedSize;
+};
+
+struct WorldCell {
+    int32_t x;
+    int32_t y;
+    uint32_t offset;
+    uint32_t size;
+};
+
+const WorldHeader* GetHeader(const unsigned char* data, size_t size) {
+    if (size < sizeof(WorldHeader)) {
+        return nullptr;
+    }
+    auto header = reinterpret_cast<const WorldHeader*>(data);
+    if (header->magic != WorldMagic || header->version != WorldVersion ||
+            header->cellCount < 0 ||
+            (size - sizeof(WorldHeader)) / sizeof(WorldCell) <
+                    static_cast<size_t>(header->cellCount) ||
+            header->sharedOffset > size ||
+            header->sharedSize > size - header->sharedOffset) {
+        return nullptr;
+    }
+    return header;
+}
+
+// True when the file is a world file built from contents with the key.
+bool IsWorldFile(std::string filename, uint64_t key) {
+    try {
+        MemoryMappedFile file(filename);
+        auto header = GetHeader(file.data(), file.size());
+        return header && header->key == key;
+    }
+    catch (std::exception&) {
+        return false;
+    }
+}
+
+std::string Stringify(Isolate* isolate, Local<Value> value) {
+    auto context = isolate->GetCurrentContext();
+    auto json = context->Global()->Get(
+            String::NewFromUtf8(isolate, "JSON"))->ToObject();
+    auto stringify = Local<Function>::Cast(json->Get(
+            String::NewFromUtf8(isolate, "stringify")));
+    Local<Value> text;
+    if (!stringify->Call(context, json, 1, &value).ToLocal(&text)) {
+        throw std::runtime_error("Failed to convert world data to JSON");
+    }
+    return *String::Utf8Value(text);
+}
+
+struct WorldOptions {
+    float cellSize;
+    double radius;
+    double hysteresis;
+    Local<Function> enter;
+    Local<Function> leave;
+};
+
+WorldOptions GetOptions(Isolate* isolate, Local<Value> value) {
+    ScriptHelper helper(isolate);
+    auto options = helper.GetObject(value);
+    WorldOptions result;
+    result.cellSize = helper.GetFloat(options, "cellSize", 0);
+    result.radius = helper.GetFloat(options, "radius", 0);
+    result.hysteresis = helper.GetFloat(options, "hysteresis", 0);
+    if (result.radius <= 0) {
+        throw std::runtime_error("Expected a radius greater than zero");
+    }
+    auto enter = options->Get(String::NewFromUtf8(isolate, "enter"));
+    auto leave = options->Get(String::NewFromUtf8(isolate, "leave"));
+    if (!enter->IsFunction() || !leave->IsFunction()) {
+        throw std::runtime_error("Expected enter and leave callbacks");
+    }
+    result.enter = Local<Function>::Cast(enter);
+    result.leave = Local<Function>::Cast(leave);
+    return result;
+}
+
+// The world file of a level and whether it has to be built.
+struct WorldSource {
+    std::string filename;
+    float cellSize = 0;
+    std::string world;
+    uint64_t key = 0;
+    // The names of the worlds built from the level start with the prefix.
+    std::string prefix;
+    // The level's JSON, only read when the world has to be built.
+    std::string json;
+    bool build = false;
+};
+
+// Finds the cached world of the level, called on the I/O threads when loading
+// asynchronously. The key is taken from the size and modification time of the
+// level, so the level is only read when it has changed.
+void FindWorld(WorldSource* source) {
+    auto& filename = source->filename;
+    if (PathHelper::FileNameEndsWith(filename, ".world")) {
+        source->world = filename;
+        return;
+    }
+    if (source->cellSize <= 0) {
+        throw std::runtime_error("Expected a cell size greater than zero");
+    }
+    auto key = Hash::Fnv1a(filename);
+    struct stat info;
+    if (stat(filename.c_str(), &info) == 0) {
+        int64_t stamp[] = { static_cast<int64_t>(info.st_size),
+                            static_cast<int64_t>(info.st_mtime) };
+        key = Hash::Fnv1a(stamp, sizeof(stamp), key);
+    }
+    else {
+        // Levels in packs don't change, but have no modification time.
+        auto file = VirtualFileSystem::current().Open(filename);
+        key = Hash::Fnv1a(file->data(), file->size(), key);
+    }
+    key = Hash::Fnv1a(&source->cellSize, sizeof(source->cellSize), key);
+    source->key = key;
+    source->prefix = Hash::ToHex(Hash::Fnv1a(filename)) + "-";
+    source->world = PathHelper::Append(
+            {ScriptEngine::current().cachePath(), "worlds",
+             source->prefix + Hash::ToHex(key) + ".world"});
+    if (!IsWorldFile(source->world, key)) {
+        source->json = FileReader::ReadAsText(filename);
+        source->build = true;
+    }
+}
+
+// Builds the world when needed, on the main thread since the level is parsed
+// by V8. The worlds built from earlier versions of the level are removed.
+void BuildWorld(Isolate* isolate, WorldSource* source) {
+    if (!source->build) {
+        return;
+    }
+    auto directory = PathHelper::GetPath(source->world);
+    PathHelper::CreateDirectories(directory);
+    WorldStream::Create(isolate, source->json, source->cellSize, source->key,
+                        source->world);
+    std::string().swap(source->json);
+    source->build = false;
+    auto name = PathHelper::GetFileName(source->world);
+    for (auto& file : VirtualFileSystem::ListFiles(directory)) {
+        if (file != name &&
+                file.compare(0, source->prefix.size(), source->prefix) == 0) {
+            std::remove(PathHelper::Append({directory, file}).c_str());
+        }
+    }
+}
+
+// Objects with a position are partitioned into cells.
+bool HasPosition(Isolate* isolate, Local<Value> value) {
+    if (!value->IsObject()) {
+        return false;
+    }
+    auto position = value->ToObject()->Get(
+            String::NewFromUtf8(isolate, "position"));
+    return position->IsObject();
+}
+
+}
+
+WorldStream::WorldStream(Isolate* isolate, std::string filename,
+                         float cellSize, double radius, double hysteresis) :
+        ScriptObjectWrap(isolate), file_(new WorldFile()), radius_(radius),
+        hysteresis_(hysteresis) {
+
+    // Worlds from packs are opened through the virtual file system, built
+    // worlds are mapped from the cache directory.
+    if (VirtualFileSystem::current().Exists(filename)) {
+        file_->file = VirtualFileSystem::current().Open(filename);
+        file_->data = file_->file->data();
+        file_->size = file_->file->size();
+    }
+    else {
+        file_->mapped.reset(new MemoryMappedFile(filename));
+        file_->data = file_->mapped->data();
+        file_->size = file_->mapped->size();
+    }
+    auto header = GetHeader(file_->data, file_->size);
+    if (!header || (cellSize > 0 && header->cellSize != cellSize)) {
+        throw std::runtime_error("Invalid world file '" + filename + "'");
+    }
+    cellSize_ = header->cellSize;
+
+    auto cells = reinterpret_cast<const WorldCell*>(header + 1);
+    for (int32_t i = 0; i < header->cellCount; i++) {
+        auto& cell = cells[i];
+        if (cell.offset > file_->size ||
+                cell.size > file_->size - cell.offset) {
+            throw std::runtime_error("World file '" + filename +
+                                     "' is truncated");
+        }
+        index_[CellId(cell.x, cell.y)] =
+                std::make_pair(cell.offset, cell.size);
+    }
+
+    TryCatch tryCatch;
+    Local<Value> data;
+    auto shared = String::NewFromUtf8(
+            isolate, reinterpret_cast<const char*>(
+                    file_->data + header->sharedOffset),
+            String::kNormalString, static_cast<int>(header->sharedSize));
+    if (!JSON::Parse(isolate, shared).ToLocal(&data)) {
+        throw std::runtime_error("Invalid world file '" + filename + "'");
+    }
+    data_.Reset(isolate, data);
+}
+
+WorldStream::~WorldStream() {
+    Dispose();
+}
+
+void WorldStream::Create(Isolate* isolate, const std::string& json,
+                         float cellSize, uint64_t key, std::string output) {
+    HandleScope scope(isolate);
+    TryCatch tryCatch;
+    Local<Value> value;
+    if (!JSON::Parse(isolate, String::NewFromUtf8(
+            isolate, json.c_str(), String::kNormalString,
+            static_cast<int>(json.size()))).ToLocal(&value) ||
+            !value->IsObject()) {
+        throw std::runtime_error("Expected the level to be a JSON object");
+    }
+    auto level = value->ToObject();
+    auto shared = Object::New(isolate);
+    std::map<CellId, Local<Object>> cells;
+
+    // Arrays of objects with a position are split by the cell containing the
+    // position, everything else is shared by all cells.
+    auto names = level->GetOwnPropertyNames();
+    for (uint32_t i = 0; i < names->Length(); i++) {
+        auto name = names->Get(i);
+        auto property = level->Get(name);
+        bool partition = property->IsArray();
+        auto array = Local<Array>::Cast(property);
+        for (uint32_t j = 0; partition && j < array->Length(); j++) {
+            partition = HasPosition(isolate, array->Get(j));
+        }
+        if (!partition || array->Length() == 0) {
+            shared->Set(name, property);
+            continue;
+        }
+        for (uint32_t j = 0; j < array->Length(); j++) {
+            auto object = array->Get(j);
+            auto position = object->ToObject()->Get(
+                    String::NewFromUtf8(isolate, "position"))->ToObject();
+            auto x = position->Get(String::NewFromUtf8(isolate, "x"));
+            auto y = position->Get(String::NewFromUtf8(isolate, "y"));
+            CellId id(
+                static_cast<int32_t>(std::floor(x->NumberValue() / cellSize)),
+                static_cast<int32_t>(std::floor(y->NumberValue() / cellSize)));
+            auto cell = cells.find(id);
+            if (cell == cells.end()) {
+                cell = cells.insert(std::make_pair(id, Object::New(isolate)))
+                        .first;
+            }
+            if (!cell->second->Has(name)) {
+                cell->second->Set(name, Array::New(isolate));
+            }
+            auto objects = Local<Array>::Cast(cell->second->Get(name));
+            objects->Set(objects->Length(), object);
+        }
+    }
+
+    std::vector<WorldCell> index;
+    std::vector<std::string> texts;
+    auto sharedText = Stringify(isolate, shared);
+    uint32_t offset = static_cast<uint32_t>(
+            sizeof(WorldHeader) + cells.size() * sizeof(WorldCell));
+    WorldHeader header {
+        WorldMagic, WorldVersion, key, cellSize,
+        static_cast<int32_t>(cells.size()), offset,
+        static_cast<uint32_t>(sharedText.size())
+    };
+    offset += header.sharedSize;
+    for (auto& cell : cells) {
+        texts.push_back(Stringify(isolate, cell.second));
+        index.push_back({ cell.first.first, cell.first.second, offset,
+                          static_cast<uint32_t>(texts.back().size()) });
+        offset += index.back().size;
+    }
+
+    // The world is written to a temporary file first so a partially written
+    // file is never read.
+    auto temporary = output + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Failed to write world '" + output + "'");
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(index.data()),
+                   index.size() * sizeof(WorldCell));
+        file.write(sharedText.data(), sharedText.size());
+        for (auto& text : texts) {
+            file.write(text.data(), text.size());
+        }
+        if (!file) {
+            throw std::runtime_error("Failed to write world '" + output + "'");
+        }
+    }
+    std::remove(output.c_str());
+    std::rename(temporary.c_str(), output.c_str());
+}
+
+void WorldStream::Initialize() {
+    ScriptObjectWrap::Initialize();
+    SetFunction("update", Update);
+    SetAccessor("data", GetData, nullptr);
+    SetAccessor("cells", GetCells, nullptr);
+}
+
+void WorldStream::Release() {
+    for (auto& cell : cells_) {
+        cell.second->cancelled = true;
+    }
+    cells_.clear();
+    index_.clear();
+    file_.reset();
+    data_.Reset();
+    enter_.Reset();
+    leave_.Reset();
+}
+
+double WorldStream::Distance(CellId id, double x, double y) {
+    auto left = id.first * cellSize_;
+    auto bottom = id.second * cellSize_;
+    auto dx = std::max(0.0, std::max(left - x, x - (left + cellSize_)));
+    auto dy = std::max(0.0, std::max(bottom - y, y - (bottom + cellSize_)));
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+void WorldStream::Read(std::shared_ptr<Cell> cell) {
+    auto range = index_[cell->id];
+    auto file = file_;
+    // Called on an I/O thread, reading pages in the mapped file.
+    auto work = [file, cell, range] {
+        if (cell->cancelled) {
+            return;
+        }
+        cell->text.assign(
+                reinterpret_cast<const char*>(file->data + range.first),
+                range.second);
+    };
+    auto completion = [cell] {
+        cell->read = true;
+    };
+    ScriptEngine::current().ioThreadPool().Post(work, completion);
+}
+
+void WorldStream::New(const FunctionCallbackInfo<Value>& args) {
+    auto isolate = args.GetIsolate();
+    HandleScope scope(isolate);
+    ScriptHelper helper(isolate);
+    try {
+        auto options = GetOptions(isolate, args[1]);
+        WorldSource source;
+        source.filename = ScriptEngine::current().resolvePath(
+                helper.GetString(args[0]));
+        source.cellSize = options.cellSize;
+        FindWorld(&source);
+        BuildWorld(isolate, &source);
+        auto stream = new WorldStream(isolate, source.world, options.cellSize,
+                                      options.radius, options.hysteresis);
+        stream->enter_.Reset(isolate, options.enter);
+        stream->leave_.Reset(isolate, options.leave);
+        args.GetReturnValue().Set(stream->v8Object());
+    }
+    catch (std::exception& ex) {
+        ScriptEngine::current().ThrowTypeError(ex.what());
+    }
+}
+
+void WorldStream::InstallAsConstructor(
+        v8::Isolate* isolate, std::string name,
+        v8::Handle<v8::ObjectTemplate> objectTemplate) {
+
+    ScriptObjectWrap::InstallAsConstructor(isolate, name, objectTemplate);
+    SetConstructorFunction(isolate, "loadAsync", LoadAsync);
+}
+
+void WorldStream::LoadAsync(const FunctionCallbackInfo<Value>& args) {
+    struct AsyncLoad {
+        WorldSource source;
+        double radius;
+        double hysteresis;
+        std::string error;
+        Persistent<Function> enter;
+        Persistent<Function> leave;
+        Persistent<Promise::Resolver> resolver;
+    };
+
+    auto isolate = args.GetIsolate();
+    HandleScope scope(isolate);
+    ScriptHelper helper(isolate);
+    Local<Promise::Resolver> resolver;
+    if (!Promise::Resolver::New(isolate->GetCurrentContext()).ToLocal(
+            &resolver)) {
+        return;
+    }
+    std::shared_ptr<AsyncLoad> load(new AsyncLoad());
+    try {
+        auto options = GetOptions(isolate, args[1]);
+        load->source.cellSize = options.cellSize;
+        load->radius = options.radius;
+        load->hysteresis = options.hysteresis;
+        load->enter.Reset(isolate, options.enter);
+        load->leave.Reset(isolate, options.leave);
+    }
+    catch (std::exception& ex) {
+        ScriptEngine::current().ThrowTypeError(ex.what());
+        return;
+    }
+    load->source.filename = ScriptEngine::current().resolvePath(
+            helper.GetString(args[0]));
+    load->resolver.Reset(isolate, resolver);
+
+    auto work = [load] {
+        try {
+            FindWorld(&load->source);
+        }
+        catch (std::exception& ex) {
+            load->error = ex.what();
+        }
+    };
+    auto completion = [isolate, load] {
+        HandleScope scope(isolate);
+        auto context = isolate->GetCurrentContext();
+        auto resolver = Local<Promise::Resolver>::New(isolate, load->resolver);
+        load->resolver.Reset();
+        if (load->error.empty()) {
+            try {
+                BuildWorld(isolate, &load->source);
+                auto stream = new WorldStream(
+                        isolate, load->source.world, load->source.cellSize,
+                        load->radius, load->hysteresis);
+                stream->enter_.Reset(isolate, load->enter);
+                stream->leave_.Reset(isolate, load->leave);
+                resolver->Resolve(context, stream->v8Object()).FromMaybe(
+                        false);
+            }
+            catch (std::exception& ex) {
+                load->error = ex.what();
+            }
+        }
+        load->enter.Reset();
+        load->leave.Reset();
+        if (!load->error.empty()) {
+            resolver->Reject(context, Exception::Error(String::NewFromUtf8(
+                    isolate, load->error.c_str()))).FromMaybe(false);
+        }
+    };
+    ScriptEngine::current().ioThreadPool().Post(work, completion);
+    args.GetReturnValue().Set(resolver->GetPromise());
+}
+
+void WorldStream::Update(const FunctionCallbackInfo<Value>& args) {
+    auto isolate = args.GetIsolate();
+    HandleScope scope(isolate);
+    auto self = GetInternalObject(args.Holder());
+    auto context = isolate->GetCurrentContext();
+    auto x = args[0]->NumberValue();
+    auto y = args[1]->NumberValue();
+
+    // Cells leave beyond the radius and the hysteresis, so moving back and
+    // forth at the edge doesn't read the same cells over and over.
+    std::vector<std::shared_ptr<Cell>> left;
+    for (auto cell = self->cells_.begin(); cell != self->cells_.end();) {
+        if (self->Distance(cell->first, x, y) >
+                self->radius_ + self->hysteresis_) {
+            cell->second->cancelled = true;
+            if (cell->second->entered) {
+                left.push_back(cell->second);
+            }
+            cell = self->cells_.erase(cell);
+        }
+        else {
+            ++cell;
+        }
+    }
+
+    auto radius = self->radius_;
+    auto size = self->cellSize_;
+    auto minX = static_cast<int32_t>(std::floor((x - radius) / size));
+    auto maxX = static_cast<int32_t>(std::floor((x + radius) / size));
+    auto minY = static_cast<int32_t>(std::floor((y - radius) / size));
+    auto maxY = static_cast<int32_t>(std::floor((y + radius) / size));
+    for (auto i = minX; i <= maxX; i++) {
+        for (auto j = minY; j <= maxY; j++) {
+            CellId id(i, j);
+            if (self->index_.find(id) == self->index_.end() ||
+                    self->cells_.find(id) != self->cells_.end() ||
+                    self->Distance(id, x, y) > radius) {
+                continue;
+            }
+            std::shared_ptr<Cell> cell(new Cell());
+            cell->id = id;
+            self->cells_[id] = cell;
+            self->Read(cell);
+        }
+    }
+
+    // The callbacks are called last, they may dispose the stream.
+    auto enter = Local<Function>::New(isolate, self->enter_);
+    auto leave = Local<Function>::New(isolate, self->leave_);
+    std::vector<std::shared_ptr<Cell>> entered;
+    for (auto& cell : self->cells_) {
+        if (cell.second->read && !cell.second->entered) {
+            entered.push_back(cell.second);
+        }
+    }
+    auto cellObject = [isolate](CellId id) {
+        auto object = Object::New(isolate);
+        object->Set(String::NewFromUtf8(isolate, "x"),
+                    Integer::New(isolate, id.first));
+        object->Set(String::NewFromUtf8(isolate, "y"),
+                    Integer::New(isolate, id.second));
+        return object;
+    };
+    // The cells have already been removed, so every one of them is left even
+    // when a callback throws. The first exception is thrown afterwards.
+    Local<Value> exception;
+    for (auto& cell : left) {
+        TryCatch tryCatch;
+        Local<Value> argv[] = { cellObject(cell->id) };
+        if (leave->Call(context, args.Holder(), 1, argv).IsEmpty() &&
+                exception.IsEmpty()) {
+            exception = tryCatch.Exception();
+        }
+    }
+    if (!exception.IsEmpty()) {
+        isolate->ThrowException(exception);
+        return;
+    }
+    for (auto& cell : entered) {
+        if (cell->cancelled) {
+            continue;
+        }
+        Local<Value> data;
+        auto text = String::NewFromUtf8(
+                isolate, cell->text.c_str(), String::kNormalString,
+                static_cast<int>(cell->text.size()));
+        if (!JSON::Parse(isolate, text).ToLocal(&data)) {
+            return;
+        }
+        // The text isn't needed after the cell has been parsed.
+        std::string().swap(cell->text);
+        cell->entered = true;
+        Local<Value> argv[] = { cellObject(cell->id), data };
+        if (enter->Call(context, args.Holder(), 2, argv).IsEmpty()) {
+            return;
+        }
+    }
+}
+
+void WorldStream::GetData(Local<String> name,
+                          const PropertyCallbackInfo<Value>& args) {
+    auto self = GetInternalObject(args.Holder());
+    args.GetReturnValue().Set(Local<Value>::New(args.GetIsolate(),
+                                                self->data_));
+}
+
+void WorldStream::GetCells(Local<String> name,
+                           const PropertyCallbackInfo<Value>& args) {
+    auto self = GetInternalObject(args.Holder());
+    int cells = 0;
+    for (auto& cell : self->cells_) {
+        if (cell.second->entered) {
+            cells++;
+        }
+    }
+    args.GetReturnValue().Set(cells);
+}
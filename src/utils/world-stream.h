@@ -0,0 +1,105 @@
+/*The MIT License (MIT)
+
+Copyright (c) 2016 Jens Malmborg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef GAMEPLAY_WORLDSTREAM_H
+#define GAMEPLAY_WORLDSTREAM_H
+
+#include <script/script-object-wrap.h>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct WorldFile;
+
+// Streams a large level in square cells around a position (e.g. the camera),
+// only the cells within the radius are kept in memory. The objects with a
+// position in the level's JSON are partitioned into cells and stored in a
+// binary world file, which is built once and cached by the size and
+// modification time of the level. Cells are read on the I/O thread pool,
+// scripts are told when cells enter and leave through callbacks called from
+// update().
+class WorldStream : public ScriptObjectWrap<WorldStream> {
+
+public:
+    static const bool Disposable = true;
+
+    WorldStream(v8::Isolate* isolate, std::string filename, float cellSize,
+                double radius, double hysteresis);
+    ~WorldStream();
+
+    // Builds a world file from the JSON of a level, the key identifies the
+    // contents it was built from.
+    static void Create(v8::Isolate* isolate, const std::string& json,
+                       float cellSize, uint64_t key, std::string output);
+
+    static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+    static void InstallAsConstructor(
+            v8::Isolate* isolate, std::string name,
+            v8::Handle<v8::ObjectTemplate> objectTemplate);
+
+protected:
+    void Initialize() override;
+    void Release() override;
+
+private:
+    typedef std::pair<int32_t, int32_t> CellId;
+
+    struct Cell {
+        CellId id;
+        std::string text;
+        bool read = false;
+        bool entered = false;
+        // Checked by the I/O threads to skip cells which already left.
+        std::atomic<bool> cancelled { false };
+    };
+
+    // Checks the cached world and reads the level on the I/O threads, the
+    // promise is resolved with the stream.
+    static void LoadAsync(const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void Update(const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void GetData(v8::Local<v8::String> name,
+                        const v8::PropertyCallbackInfo<v8::Value>& args);
+    static void GetCells(v8::Local<v8::String> name,
+                         const v8::PropertyCallbackInfo<v8::Value>& args);
+
+    // Distance from the position to the closest point of the cell.
+    double Distance(CellId id, double x, double y);
+    void Read(std::shared_ptr<Cell> cell);
+
+    std::shared_ptr<WorldFile> file_;
+    float cellSize_;
+    double radius_;
+    double hysteresis_;
+    // The offset and size of each cell in the file.
+    std::map<CellId, std::pair<uint32_t, uint32_t>> index_;
+    // The cells within the radius, being read or entered.
+    std::map<CellId, std::shared_ptr<Cell>> cells_;
+    v8::Persistent<v8::Value> data_;
+    v8::Persistent<v8::Function> enter_;
+    v8::Persistent<v8::Function> leave_;
+};
+
+#endif // GAMEPLAY_WORLDSTREAM_H